@@ -0,0 +1,28 @@
+#ifndef ARDUINO_HAL_H
+#define ARDUINO_HAL_H
+
+#include "Hal.h"
+
+class ArduinoClock : public Clock {
+public:
+    uint32_t millis() override;
+    uint32_t micros() override;
+    void delay(uint32_t ms) override;
+    void delayMicroseconds(uint32_t us) override;
+};
+
+class ArduinoGpio : public Gpio {
+public:
+    void pinMode(uint8_t pin, uint8_t mode) override;
+    void digitalWrite(uint8_t pin, uint8_t value) override;
+    int digitalRead(uint8_t pin) override;
+};
+
+class ArduinoEeprom : public Storage {
+public:
+    uint16_t length() override;
+    uint8_t read(uint16_t address) override;
+    void update(uint16_t address, uint8_t value) override;
+};
+
+#endif
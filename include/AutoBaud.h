@@ -0,0 +1,47 @@
+#ifndef AUTO_BAUD_H
+#define AUTO_BAUD_H
+
+#include <Arduino.h>
+
+// Zegar pomiaru impulsów: Timer3 bez preskalera (62.5 ns przy 16 MHz)
+#ifdef F_CPU
+#define AUTOBAUD_TICK_HZ F_CPU
+#else
+#define AUTOBAUD_TICK_HZ 16000000UL
+#endif
+
+// Wykrywanie prędkości z szerokości najkrótszych impulsów na linii RX.
+// Na Leonardo zbocza zbiera przerwanie INT2 (PD2 = RX1) z odczytem TCNT3;
+// w symulacji impulsy podaje SimBus przez recordPulse().
+class AutoBaud {
+public:
+    static const uint8_t MIN_EDGES = 24;        // Zbocza przed oceną
+    static const uint8_t MIN_BIT_PULSES = 4;    // Impulsy jednobitowe
+    static const uint8_t TOLERANCE_PERCENT = 5; // Dopasowanie do standardu
+
+    AutoBaud();
+    void begin();
+    void end();
+    bool isActive() const { return _active; }
+
+    void recordPulse(uint16_t ticks);
+    bool ready() const;
+    unsigned long measuredBaud() const;
+    unsigned long estimateBaud() const;
+    uint16_t edgeCount() const;
+
+private:
+    static const unsigned long STANDARD_RATES[];    // PROGMEM
+    static const uint8_t STANDARD_COUNT;
+    static const uint16_t MIN_PULSE_TICKS = AUTOBAUD_TICK_HZ / 460800UL;
+
+    volatile bool _active;
+    volatile uint16_t _edges;
+    volatile uint16_t _minTicks;    // Najkrótszy impuls = czas bitu
+    volatile uint32_t _sumTicks;    // Suma impulsów bliskich minimum
+    volatile uint8_t _bitPulses;    // Ich liczba (do uśrednienia)
+
+    void reset();
+};
+
+#endif
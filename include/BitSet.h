@@ -0,0 +1,42 @@
+#ifndef BIT_SET_H
+#define BIT_SET_H
+
+#include <stdint.h>
+
+// Zbiór bitów o stałym rozmiarze: przynależność w O(1), bez sterty.
+// Struktura bez konstruktora, więc można ją zerować memset() razem
+// z otaczającą strukturą (np. MasterInfo).
+template <uint16_t BITS>
+struct BitSet {
+    static const uint16_t SIZE = BITS;
+    static const uint16_t BYTES = (BITS + 7) / 8;
+
+    uint8_t bits[BYTES];
+
+    void clear() {
+        for (uint16_t i = 0; i < BYTES; i++) bits[i] = 0;
+    }
+
+    // Zwraca true, gdy bit był wcześniej wyzerowany
+    bool set(uint16_t index) {
+        if (index >= BITS) return false;
+        uint8_t mask = 1 << (index & 7);
+        bool added = !(bits[index >> 3] & mask);
+        bits[index >> 3] |= mask;
+        return added;
+    }
+
+    bool test(uint16_t index) const {
+        return index < BITS && (bits[index >> 3] & (1 << (index & 7)));
+    }
+
+    uint16_t count() const {
+        uint16_t total = 0;
+        for (uint16_t i = 0; i < BYTES; i++) {
+            for (uint8_t b = bits[i]; b; b &= b - 1) total++;
+        }
+        return total;
+    }
+};
+
+#endif
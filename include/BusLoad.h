@@ -0,0 +1,52 @@
+#ifndef BUS_LOAD_H
+#define BUS_LOAD_H
+
+#include <Arduino.h>
+#include "RtuTiming.h"
+
+// Obciążenie magistrali liczone ze znaczników bajtów w stałej pamięci:
+// każdy bajt zajmuje linię na czas znaku. Okna przesuwne 1 s (10 x 100 ms)
+// i 10 s (10 x 1 s) z zapamiętanym szczytem oraz histogram przerw między
+// ramkami w czasach znaku.
+class BusLoad {
+public:
+    static const uint8_t GAP_BUCKETS = 9;
+
+    explicit BusLoad(const RtuTiming& timing);
+    void reset(uint32_t now);
+    void onByte(uint32_t timestamp);
+    // Cisza przed ramką (odstęp od poprzedniego znaku minus czas znaku)
+    void onFrameGap(uint32_t idleUs);
+    // Domyka przedziały czasu także wtedy, gdy na linii nic się nie dzieje
+    void advance(uint32_t now);
+    void print() const;
+
+private:
+    static const uint8_t SLOTS = 10;
+    static const uint32_t SLOT_US = 100000;             // 100 ms
+    static const uint16_t GAP_LIMITS[GAP_BUCKETS - 1];  // Granice w połówkach znaku, PROGMEM
+
+    const RtuTiming& _timing;
+    uint32_t _slotStartUs;
+    uint16_t _shortSlots[SLOTS];    // Bajty w przedziałach 100 ms
+    uint16_t _longSlots[SLOTS];     // Bajty w przedziałach 1 s
+    uint8_t _shortIndex;
+    uint8_t _longIndex;
+    uint32_t _shortBytes;           // Suma okna 1 s (z bieżącym przedziałem)
+    uint32_t _longBytes;            // Suma okna 10 s (z bieżącym przedziałem)
+    uint32_t _lastShortBytes;       // Ostatnie pełne okna
+    uint32_t _lastLongBytes;
+    uint32_t _slotCount;            // Przedziały 100 ms od startu
+    uint32_t _peakShortBytes;
+    uint32_t _peakLongBytes;
+    uint32_t _totalBytes;
+    uint16_t _gaps[GAP_BUCKETS];
+
+    void closeSlot();
+    void closeLongSlot();
+    uint8_t percentOf(uint32_t bytes, uint32_t windowMs) const;
+    static void printHalfChars(uint16_t halfChars);
+    void printWindow(const __FlashStringHelper* label, uint32_t bytes, uint32_t windowMs) const;
+};
+
+#endif
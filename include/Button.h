@@ -0,0 +1,27 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include "Hal.h"
+
+// Przycisk do masy z podciąganiem. Eliminacja drgań bez blokowania:
+// stan uznany za stabilny po DEBOUNCE_MS bez zmian odczytu.
+class Button {
+public:
+    static const uint8_t DEBOUNCE_MS = 50;
+
+    Button(Gpio& gpio, uint8_t pin);
+    void begin();
+    void update(uint32_t nowMs);
+    // Jednorazowo true po każdym stabilnym wciśnięciu
+    bool pressed();
+
+private:
+    Gpio& _gpio;
+    uint8_t _pin;
+    bool _reading;          // Ostatni surowy odczyt (true = wciśnięty)
+    bool _stable;           // Stan po eliminacji drgań
+    bool _event;
+    uint32_t _changeMs;
+};
+
+#endif
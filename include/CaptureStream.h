@@ -0,0 +1,37 @@
+#ifndef CAPTURE_STREAM_H
+#define CAPTURE_STREAM_H
+
+#include <Arduino.h>
+
+// Flagi rekordu przechwycenia
+const uint8_t CAPTURE_FLAG_CRC_ERROR = 0x01;
+const uint8_t CAPTURE_FLAG_T15 = 0x02;          // Przerwa > t1.5 w ramce
+const uint8_t CAPTURE_FLAG_OVERFLOW = 0x04;     // Ramka ucięta (bufor/pierścień)
+const uint8_t CAPTURE_FLAG_SHORT = 0x08;        // Mniej niż 4 bajty
+const uint8_t CAPTURE_FLAG_FRAMING = 0x10;      // Bajt z błędem ramki (FE)
+const uint8_t CAPTURE_FLAG_PARITY = 0x20;       // Bajt z błędem parzystości (UPE)
+const uint8_t CAPTURE_FLAG_LOST = 0x40;         // Utracone bajty (DOR lub pierścień RX)
+
+// Binarny strumień ramek przez USB CDC. Rekord (little-endian):
+//   0xA5 | długość N | nr sekwencji u16 | czas us u32 | flagi | N bajtów
+// Rekord, który nie mieści się w buforze nadawczym, jest pomijany zamiast
+// blokować pętlę - numer sekwencji i tak rośnie, więc host widzi lukę.
+class CaptureStream {
+public:
+    static const uint8_t SYNC = 0xA5;
+    static const uint8_t HEADER_SIZE = 9;
+
+    explicit CaptureStream(Print& output);
+    void reset();
+    bool writeFrame(const uint8_t* frame, uint8_t length, uint32_t timestamp, uint8_t flags);
+    uint32_t recordCount() const { return _records; }
+    uint32_t droppedCount() const { return _dropped; }
+
+private:
+    Print& _output;
+    uint16_t _sequence;
+    uint32_t _records;
+    uint32_t _dropped;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+
+// Pojemności wszystkich struktur - cała pamięć przydzielona statycznie,
+// bez sterty. Koszt w SRAM pokazuje tools/sram_report.py po kompilacji.
+
+constexpr uint8_t SCANNER_MAX_DEVICES = 10;     // Znalezione urządzenia (i lista w EEPROM)
+constexpr uint8_t TRANSPORT_FRAME_SIZE = 32;    // Bufory nadawania i odbioru RtuTransport
+constexpr uint8_t ANALYZER_FRAME_SIZE = 32;     // Bufor ramki analizatora
+constexpr uint8_t ANALYZER_MAX_SLAVE_STATS = 5; // Slave'y z histogramem czasów odpowiedzi
+constexpr uint8_t ANALYZER_MAX_FLOWS = 8;       // Przepływy (adres, funkcja, zakres), potęga 2
+constexpr uint8_t RX_RING_SIZE = 64;            // Pierścień RX w przerwaniu, potęga 2
+constexpr uint8_t SCHEDULER_MAX_TASKS = 6;      // Zadania pętli głównej
+constexpr uint8_t FILTER_MAX_PREDICATES = 6;    // Warunki filtra/wyzwalacza ramek
+constexpr uint8_t TRIGGER_HISTORY_SIZE = 64;    // Bajty historii przed wyzwoleniem
+constexpr uint8_t MAPPER_MAX_RANGES = 8;        // Zakresy w mapie rejestrów urządzenia
+constexpr uint8_t EMULATOR_HOLDING_REGISTERS = 16; // Bank rejestrów holding emulatora slave
+constexpr uint8_t WATCH_MAX_BLOCKS = 4;         // Bloki obserwacji rejestrów
+constexpr uint8_t WATCH_MAX_REGISTERS = 16;     // Obserwowane rejestry łącznie (wartość + pasmo)
+constexpr uint8_t GATEWAY_QUEUE_SIZE = 64;      // Kolejka zapytań bramki USB-RS485
+constexpr uint16_t SD_LOG_BUFFER_SIZE = 64;     // Bufor logu SD (x2), część sektora 512 B
+
+// Budżet zmiennych globalnych szkicu (static_assert w main.cpp): SRAM minus
+// zapas na stos minus rdzeń. Rdzeń to zmienne Arduino i USB CDC (pusty
+// szkic na Leonardo: 149 B), vtable klas HAL i drobne zmienne modułów,
+// które avr-gcc trzyma w .data. Stałe tablice i teksty są we flash
+// (PROGMEM, F(), PSTR) - inaczej zajmowałyby .data poza tym rachunkiem.
+constexpr uint16_t SRAM_BYTES = 2560;           // ATmega32U4
+constexpr uint16_t SRAM_STACK_RESERVE = 512;    // Jak STACK_RESERVE w tools/sram_report.py
+#ifdef SD_LOG
+constexpr uint16_t SRAM_CORE_ESTIMATE = 320;    // Także vtable karty i loggera SD
+#else
+constexpr uint16_t SRAM_CORE_ESTIMATE = 288;
+#endif
+constexpr uint16_t SRAM_STATIC_BUDGET = SRAM_BYTES - SRAM_STACK_RESERVE - SRAM_CORE_ESTIMATE;
+
+static_assert((RX_RING_SIZE & (RX_RING_SIZE - 1)) == 0, "RX_RING_SIZE musi byc potega 2");
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DEVICE_CACHE_H
+#define DEVICE_CACHE_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "Config.h"
+
+struct DeviceInfo {
+    uint8_t address;
+    unsigned long baudRate;
+};
+
+// Lista znalezionych urządzeń w EEPROM. Układ (little-endian):
+//   'M' 'B' | wersja | liczba N | N x (adres, baud u32) | CRC16
+// CRC obejmuje nagłówek i wpisy, więc przerwany zapis lub pusta
+// pamięć (0xFF) dają po prostu brak zapamiętanej listy. Format znaku
+// nie jest zapisywany - skaner pracuje tylko w 8N1 (wersja 1 miała
+// jeszcze bajt formatu i jest odrzucana).
+class DeviceCache {
+public:
+    static const uint8_t MAX_ENTRIES = SCANNER_MAX_DEVICES;
+    static const uint8_t VERSION = 2;
+    static const uint8_t HEADER_SIZE = 4;
+    static const uint8_t ENTRY_SIZE = 5;
+
+    explicit DeviceCache(Storage& storage, uint16_t baseAddress = 0);
+    // Zwraca liczbę wczytanych wpisów, 0 gdy brak listy lub błąd CRC
+    uint8_t load(DeviceInfo* devices, uint8_t maxCount);
+    void save(const DeviceInfo* devices, uint8_t count);
+    void clear();
+
+private:
+    Storage& _storage;
+    uint16_t _base;
+
+    uint16_t crcAddress(uint8_t count) const;
+    uint16_t computeCrc(uint8_t count);
+};
+
+#endif
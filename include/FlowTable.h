@@ -0,0 +1,60 @@
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include <Arduino.h>
+#include "ModbusPdu.h"
+#include "Config.h"
+
+// Przepływ: zapytania mastera o ten sam zakres (adres, funkcja, rejestr, ilość)
+struct FlowEntry {
+    uint8_t address;
+    uint8_t function;
+    uint16_t startAddress;
+    uint16_t quantity;
+    uint16_t requests;              // 0 - miejsce wolne
+    uint16_t errors;                // Wyjątki i zapytania bez odpowiedzi
+    uint32_t meanInterval;          // Średni odstęp zapytań w ms << MEAN_SHIFT
+    uint32_t lastMs;                // Ostatnie zapytanie, też wiek do LRU
+};
+
+// Liczniki przepływów w tablicy z adresowaniem otwartym (próbkowanie
+// liniowe). Koszt na zapytanie jest stały, a raport ma zawsze tyle samo
+// wierszy niezależnie od ruchu. Gdy tablica jest pełna, nowy przepływ
+// wypycha najdawniej widziany.
+class FlowTable {
+public:
+    static const uint8_t CAPACITY = ANALYZER_MAX_FLOWS;
+    // Średnia wykładnicza odstępów z wagą 1/8 nowego odstępu: nadąża za
+    // zmianą okresu odpytywania, a skalowanie zachowuje ułamki ms
+    static const uint8_t MEAN_SHIFT = 3;
+
+    FlowTable();
+    void clear();
+    // Zapytanie mastera; zwraca wpis przepływu
+    FlowEntry* recordRequest(const ModbusTransaction& request, uint32_t nowMs);
+    // Wyjątek lub brak odpowiedzi na zapytanie
+    void recordError(const ModbusTransaction& request);
+    uint8_t size() const { return _size; }
+    uint16_t evictions() const { return _evictions; }
+    // Tabela topCount przepływów o największej liczbie zapytań
+    void print(uint8_t topCount, uint32_t nowMs) const;
+
+private:
+    static const uint8_t NOT_FOUND = 0xFF;
+
+    FlowEntry _entries[CAPACITY];
+    uint8_t _size;
+    uint16_t _evictions;
+
+    static uint8_t hash(uint8_t address, uint8_t function, uint16_t startAddress,
+                        uint16_t quantity);
+    static bool matches(const FlowEntry& entry, const ModbusTransaction& request);
+    uint8_t find(const ModbusTransaction& request) const;
+    void evictOldest(uint32_t nowMs);
+    void remove(uint8_t slot);
+};
+
+static_assert((ANALYZER_MAX_FLOWS & (ANALYZER_MAX_FLOWS - 1)) == 0,
+              "ANALYZER_MAX_FLOWS musi byc potega 2");
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FRAME_FILTER_H
+#define FRAME_FILTER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Cechy ramki oceniane przez filtr - wyliczane raz w closeFrame()
+struct FrameSummary {
+    uint8_t address;
+    uint8_t function;               // Bez bitu wyjątku 0x80
+    uint8_t flags;                  // CAPTURE_FLAG_* ramki
+    bool exception;
+    uint16_t startAddress;          // Zakres rejestrów; dla odpowiedzi - z zapytania
+    uint16_t quantity;              // 0 = ramka bez zakresu
+    uint32_t responseUs;            // Czas reakcji slave'a, 0 = to nie odpowiedź
+};
+
+// Filtr ramek kompilowany z wyrażenia do tablicy predykatów, np.
+//   "a=1,5-9 f=3,0x10 r=100-199 err t>20"
+// a - adresy, f - funkcje, r - zakres rejestrów (część wspólna), err - ramki
+// z błędem lub wyjątkiem, t>N - odpowiedź później niż N ms. Predykaty tego
+// samego pola łączy OR, różnych pól - AND. Puste wyrażenie przepuszcza wszystko.
+class FrameFilter {
+public:
+    static const uint8_t MAX_PREDICATES = FILTER_MAX_PREDICATES;
+
+    FrameFilter();
+    // false przy błędzie składni lub braku miejsca - poprzedni filtr zostaje
+    bool compile(const char* expression);
+    void clear();
+    bool isEmpty() const { return _count == 0; }
+    bool matches(const FrameSummary& frame) const;
+    void print() const;
+
+private:
+    enum Field : uint8_t {
+        ADDRESS,
+        FUNCTION,
+        REGISTER,
+        ERROR,
+        SLOW
+    };
+
+    struct Predicate {
+        uint8_t field;
+        uint16_t low;
+        uint16_t high;
+    };
+
+    Predicate _predicates[MAX_PREDICATES];
+    uint8_t _count;
+    uint8_t _fields;                // Maska pól obecnych w wyrażeniu
+
+    static bool test(const Predicate& predicate, const FrameSummary& frame);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Historia ostatnich ramek przed wyzwoleniem. Rekordy zmiennej długości
+// w pierścieniu bajtów: długość N | flagi | czas us u32 | N bajtów.
+// Nowa ramka wypiera najstarsze, więc krótkie ramki mieszczą się licznie.
+class FrameRing {
+public:
+    static const uint8_t SIZE = TRIGGER_HISTORY_SIZE;
+    static const uint8_t HEADER_SIZE = 6;
+
+    FrameRing();
+    void clear();
+    void push(const uint8_t* frame, uint8_t length, uint32_t timestamp, uint8_t flags);
+    // Najstarsza ramka; false gdy pusto. frame musi pomieścić najdłuższą wstawioną
+    bool pop(uint8_t* frame, uint8_t& length, uint32_t& timestamp, uint8_t& flags);
+    uint8_t frameCount() const { return _frames; }
+
+private:
+    uint8_t _data[SIZE];
+    uint8_t _head;                  // Miejsce zapisu
+    uint8_t _tail;                  // Najstarszy rekord
+    uint8_t _used;
+    uint8_t _frames;
+
+    void put(uint8_t value);
+    uint8_t take();
+    void dropOldest();
+};
+
+#endif
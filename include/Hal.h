@@ -0,0 +1,86 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+// Cienka warstwa sprzętowa używana przez skaner i analizator.
+// Na Leonardo implementują ją Rs485Uart i ArduinoHal, w środowisku
+// native - symulowana magistrala z lib/SimBus.
+
+// Status odebranego bajtu z rejestru UCSR1A
+const uint8_t RX_STATUS_FRAMING = 0x01;     // FE: brak bitu stopu - zakłócenia, zła prędkość
+const uint8_t RX_STATUS_PARITY = 0x02;      // UPE: błąd parzystości (tylko 8E1/8O1)
+const uint8_t RX_STATUS_OVERRUN = 0x04;     // DOR: bajty przed tym utracone w USART
+
+// Bajt odebrany z magistrali wraz ze znacznikiem czasu
+struct RxEvent {
+    uint8_t data;
+    uint8_t status;                 // RX_STATUS_*
+    uint32_t timestamp;             // micros() w chwili odbioru
+};
+
+class SerialPort {
+public:
+    virtual ~SerialPort() {}
+    virtual void begin(unsigned long baud) = 0;
+    virtual void end() = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual bool readEvent(RxEvent& event) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+    virtual void flush() = 0;
+    // Nadawanie bez blokowania: txReady() - można wpisać bajt bez czekania,
+    // txComplete() - ostatni bajt opuścił nadajnik (można wyłączyć DIR)
+    virtual bool txReady() = 0;
+    virtual bool txComplete() = 0;
+    virtual uint32_t overflowCount() const = 0;
+};
+
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint32_t millis() = 0;
+    virtual uint32_t micros() = 0;
+    virtual void delay(uint32_t ms) = 0;
+    virtual void delayMicroseconds(uint32_t us) = 0;
+};
+
+class Gpio {
+public:
+    virtual ~Gpio() {}
+    virtual void pinMode(uint8_t pin, uint8_t mode) = 0;
+    virtual void digitalWrite(uint8_t pin, uint8_t value) = 0;
+    virtual int digitalRead(uint8_t pin) = 0;
+};
+
+// Pamięć nieulotna (EEPROM); update() zapisuje tylko zmienione bajty
+class Storage {
+public:
+    virtual ~Storage() {}
+    virtual uint16_t length() = 0;
+    virtual uint8_t read(uint16_t address) = 0;
+    virtual void update(uint16_t address, uint8_t value) = 0;
+};
+
+// Nośnik blokowy (karta SD) zapisywany strumieniowo: startWrite() otwiera
+// zapis kolejnych bloków od podanego, writeData() przyjmuje blok 512 B
+// w dowolnych częściach. Po ostatniej części bloku nośnik programuje go
+// i busy() zwraca true - do tego czasu nie wolno wysyłać danych.
+// busy() pyta się tylko między blokami: w trakcie bloku karta SPI wzięłaby
+// bajt zegarujący za dane, więc wtedy zwraca false bez transmisji.
+class BlockDevice {
+public:
+    static const uint16_t BLOCK_SIZE = 512;
+
+    virtual ~BlockDevice() {}
+    virtual uint32_t blockCount() = 0;
+    // count > 0 - liczba bloków do wstępnego przydzielenia/wymazania
+    virtual bool startWrite(uint32_t block, uint32_t count) = 0;
+    virtual bool writeData(const uint8_t* data, uint16_t length) = 0;
+    virtual bool busy() = 0;
+    virtual bool stopWrite() = 0;
+    // Bajty [offset, offset + length) bloku, bez bufora całego sektora
+    virtual bool readData(uint32_t block, uint16_t offset, uint8_t* data, uint16_t length) = 0;
+};
+
+#endif
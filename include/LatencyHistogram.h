@@ -0,0 +1,86 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+// Histogram czasów w oktawach od 2^FIRST_OCTAVE us, każda oktawa podzielona
+// liniowo na 2^SUB_BITS przedziałów. Czasy poniżej pierwszej oktawy trafiają
+// do przedziału 0, ostatni przedział jest otwarty.
+template <uint8_t FIRST_OCTAVE, uint8_t OCTAVES, uint8_t SUB_BITS>
+struct BasicLatencyHistogram {
+    static const uint8_t SUB_BUCKETS = 1 << SUB_BITS;
+    static const uint8_t BUCKETS = OCTAVES * SUB_BUCKETS;
+
+    uint16_t counts[BUCKETS];
+    uint16_t samples;               // Próbki w totalUs
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t totalUs;
+
+    void reset() {
+        for (uint8_t i = 0; i < BUCKETS; i++) counts[i] = 0;
+        samples = 0;
+        minUs = UINT32_MAX;
+        maxUs = 0;
+        totalUs = 0;
+    }
+
+    void record(uint32_t us) {
+        uint8_t bucket = bucketFor(us);
+        if (counts[bucket] < UINT16_MAX) counts[bucket]++;
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+        // Po nasyceniu licznika lub sumy średnia zostaje przy dotychczasowych
+        // próbkach - licznik i suma muszą się zatrzymać razem
+        if (samples < UINT16_MAX && totalUs <= UINT32_MAX - us) {
+            samples++;
+            totalUs += us;
+        }
+    }
+
+    uint32_t averageUs() const {
+        return samples ? totalUs / samples : 0;
+    }
+
+    // Górna granica przedziału, w którym leży dany percentyl
+    uint32_t percentileUs(uint8_t percent) const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < BUCKETS; i++) total += counts[i];
+        if (total == 0) return 0;
+
+        uint32_t target = (total * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= target) {
+                uint32_t upper = bucketUpperUs(i);
+                return upper < maxUs ? upper : maxUs;
+            }
+        }
+        return maxUs;
+    }
+
+    static uint8_t bucketFor(uint32_t us) {
+        if (us < (1UL << FIRST_OCTAVE)) return 0;
+        uint8_t octave = FIRST_OCTAVE;
+        while ((us >> (octave + 1)) && octave < FIRST_OCTAVE + OCTAVES - 1) octave++;
+        if (us >> (octave + 1)) return BUCKETS - 1;
+        // Bity pod najstarszym wybierają przedział w oktawie
+        uint8_t sub = (us >> (octave - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return (octave - FIRST_OCTAVE) * SUB_BUCKETS + sub;
+    }
+
+    static uint32_t bucketUpperUs(uint8_t bucket) {
+        uint8_t octave = FIRST_OCTAVE + bucket / SUB_BUCKETS;
+        uint8_t sub = bucket % SUB_BUCKETS;
+        return (uint32_t)(SUB_BUCKETS + sub + 1) << (octave - SUB_BITS);
+    }
+
+    static_assert(FIRST_OCTAVE >= SUB_BITS, "Za drobne przedzialy dla pierwszej oktawy");
+};
+
+// Czasy odpowiedzi slave'ów w analizatorze: przedziały log2, przedział 0
+// to < 256 us, przedział i to [2^(i+7), 2^(i+8)) us, ostatni > 262 ms
+typedef BasicLatencyHistogram<7, 12, 0> LatencyHistogram;
+
+#endif
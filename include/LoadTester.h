@@ -0,0 +1,73 @@
+#ifndef LOAD_TESTER_H
+#define LOAD_TESTER_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "DeviceCache.h"
+#include "LatencyHistogram.h"
+#include "Config.h"
+
+// Test obciążenia: znalezione urządzenia odpytywane jedno po drugim bez
+// przerw (poza ciszą t3.5), odczyt 0x03/0x04 w zadanej proporcji. Raport
+// podaje transakcje/s, przepływność wobec teoretycznej dla prędkości,
+// p50/p99 czasu reakcji slave'a i odsetek błędów.
+class LoadTester {
+public:
+    static const uint8_t MAX_DEVICES = SCANNER_MAX_DEVICES;
+    // Odpowiedź musi zmieścić się w buforze transportu
+    static const uint8_t MAX_REGISTERS = (RtuTransport::FRAME_SIZE - 5) / 2;
+    static const uint16_t RESPONSE_TIMEOUT_MS = 100;
+    static const uint16_t PROGRESS_INTERVAL_MS = 10000;
+
+    LoadTester(RtuTransport& transport, Clock& clock);
+    // Proporcja zapytań 0x03:0x04 (np. 3:1) i liczba rejestrów w zapytaniu
+    void configure(uint8_t holdingWeight, uint8_t inputWeight, uint8_t registers);
+    // Urządzenia na najczęstszej prędkości z listy; false gdy brak urządzeń
+    bool start(const DeviceInfo* devices, uint8_t count);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showSummary() const;
+
+private:
+    // Histogram log-liniowy: 4 przedziały na oktawę od 128 us, ~19% rozdzielczości,
+    // 10 oktaw do 131 ms - powyżej RESPONSE_TIMEOUT_MS
+    typedef BasicLatencyHistogram<7, 10, 2> TurnaroundHistogram;
+    static const uint8_t REQUEST_LENGTH = 8;    // 0x03/0x04 z CRC
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    bool _running;
+    uint8_t _addresses[MAX_DEVICES];
+    uint8_t _deviceCount;
+    uint8_t _skipped;               // Urządzenia na innych prędkościach
+    uint8_t _next;
+    uint8_t _holdingWeight;
+    uint8_t _inputWeight;
+    uint8_t _registers;
+    int16_t _mixBalance;            // Akumulator proporcji (jak Bresenham)
+    uint8_t _address;               // Bieżące zapytanie
+    uint8_t _function;
+    bool _pending;
+
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+    uint32_t _lastProgressMs;
+    uint32_t _transactions;
+    uint32_t _timeouts;
+    uint32_t _crcErrors;
+    uint32_t _exceptions;
+    uint32_t _invalid;              // Odpowiedź z innym adresem/funkcją/długością
+    uint32_t _busBytes;             // Zapytania + odpowiedzi
+    TurnaroundHistogram _turnaround;
+
+    void sendNext();
+    void handleResult();
+    uint8_t nextFunction();
+    uint32_t errorCount() const;
+    static uint32_t ratePerSecondTenths(uint32_t count, uint32_t ms);
+    static void printTenths(uint32_t tenths);
+};
+
+#endif
@@ -2,15 +2,31 @@
 #define MODBUS_ANALYZER_H
 
 #include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "ModbusCRC.h"
+#include "ModbusPdu.h"
+#include "RtuTiming.h"
+#include "AutoBaud.h"
+#include "CaptureStream.h"
+#include "LatencyHistogram.h"
+#include "BitSet.h"
+#include "BusLoad.h"
+#include "FrameFilter.h"
+#include "FrameRing.h"
+#include "FlowTable.h"
+#include "Config.h"
+
+const uint16_t MODBUS_ADDRESS_SPACE = 248;  // 0 (rozgłoszenie) .. 247
 
 struct MasterInfo {
-    uint8_t slaveAddresses[10];     // Lista odpytywanych adresów
+    BitSet<MODBUS_ADDRESS_SPACE> slaveAddresses;   // Odpytywane adresy
     uint8_t addressCount;           // Liczba różnych adresów
     unsigned long baudRate;         // Wykryta prędkość
-    uint8_t functions[5];           // Lista używanych funkcji
-    uint8_t functionCount;          // Liczba różnych funkcji
-    uint16_t startRegister;         // Początkowy rejestr
-    uint16_t registerCount;         // Liczba odczytywanych rejestrów
+    uint32_t baudLockTime;          // Czas do potwierdzenia prędkości CRC [ms]
+    BitSet<256> functions;          // Używane kody funkcji
+    uint16_t functionCount;         // Liczba różnych funkcji
+    uint32_t writeRequests;         // Zapytania zapisu (0x05, 0x06, 0x0F, 0x10, 0x17)
     
     // Statystyki czasowe
     uint32_t lastQueryTime;         // Czas ostatniego zapytania
@@ -24,46 +40,165 @@ struct MasterInfo {
     uint32_t crcErrors;             // Błędy CRC
     uint32_t collisions;            // Wykryte kolizje
     uint32_t invalidFrames;         // Nieprawidłowe ramki
+    uint32_t t15Violations;         // Przerwy > t1.5 wewnątrz ramki
+    uint32_t t35Violations;         // Ramka bez ciszy t3.5 po poprzedniej
+    uint32_t rxOverflows;           // Bajty utracone w pierścieniu RX
+
+    // Błędy linii z UCSR1A, bajt po bajcie
+    uint32_t framingErrors;         // FE - zakłócenia, okablowanie, zła prędkość
+    uint32_t parityErrors;          // UPE
+    uint32_t overruns;              // DOR - przerwanie obsłużone za późno
+    uint32_t lineErrorFrames;       // Ramki z bajtami FE/UPE
+    uint32_t lostByteFrames;        // Ramki z utraconymi bajtami (DOR lub pierścień)
+};
+
+// Statystyki odpowiedzi pojedynczego slave'a
+struct SlaveStats {
+    uint8_t address;
+    uint16_t requests;              // Zapytania mastera do tego adresu
+    uint16_t timeouts;              // Zapytania bez odpowiedzi
+    uint16_t exceptions;            // Odpowiedzi z kodem wyjątku
+    uint8_t lastException;          // Kod ostatniego wyjątku
+    LatencyHistogram turnaround;    // Od końca zapytania do początku odpowiedzi
 };
 
 class ModbusAnalyzer {
 public:
-    ModbusAnalyzer(HardwareSerial& modbusSerial);
+    ModbusAnalyzer(RtuTransport& transport, Clock& clock);
     void begin();
     void startAnalysis();
     void stop();
     void update();
     bool isAnalyzing() const;
     unsigned long getCurrentBaudRate() const;
+    void setAutoBaud(AutoBaud* autoBaud);
+    // Strumień binarny zamiast wydruków tekstowych (nullptr = tekst)
+    void setCaptureStream(CaptureStream* capture);
+    // Wyjście (tekst lub strumień) tylko dla ramek pasujących do filtra;
+    // statystyki liczone są zawsze ze wszystkich ramek
+    bool setFilter(const char* expression);
+    // Uzbrojony wyzwalacz: ramki tylko do historii, po trafieniu wydruk
+    // historii, ramki wyzwalającej i postFrames kolejnych. "" wyłącza
+    bool setTrigger(const char* expression, uint8_t postFrames);
+    // Co periodS sekund tabela topCount przepływów zamiast wydruku
+    // każdej ramki (tylko tryb tekstowy); 0 - wydruk ramek
+    void setFlowReport(uint16_t periodS, uint8_t topCount);
+    void showOutputSettings() const;
     void showSummary() const;
+    const MasterInfo& masterInfo() const { return _masterInfo; }
 
 private:
-    static const uint8_t MAX_BUFFER = 32;
-    static const unsigned long BAUD_RATES[];
+    static const uint8_t MAX_BUFFER = ANALYZER_FRAME_SIZE;
+    static const unsigned long BAUD_RATES[];    // PROGMEM
     static const uint8_t BAUD_COUNT;
     static const uint32_t COLLISION_THRESHOLD = 5;  // ms między ramkami = kolizja
+    static const uint8_t MIN_FRAME_SIZE = 4;        // Adres + funkcja + CRC
+    static const uint32_t AUTOBAUD_TIMEOUT_MS = 1000;   // Brak zboczy = cisza
+    static const uint32_t CONFIRM_TIMEOUT_MS = 1000;    // Oczekiwanie na CRC
+    static const uint32_t ROTATE_INTERVAL_MS = 1000;
+    static const uint32_t RESPONSE_TIMEOUT_MS = 1000;   // Typowy timeout mastera
+    static const uint8_t MAX_SLAVE_STATS = ANALYZER_MAX_SLAVE_STATS;
+
+    // Ustalanie prędkości magistrali
+    enum class BaudState : uint8_t {
+        DETECTING,  // Pomiar impulsów (AutoBaud)
+        CONFIRMING, // Prędkość ustawiona, czekanie na poprawne CRC
+        LOCKED,     // Potwierdzona poprawną ramką
+        ROTATING    // Przeszukiwanie listy BAUD_RATES co sekundę
+    };
 
-    HardwareSerial& _serial;
+    // Stan odbiornika RTU
+    enum class RxState : uint8_t {
+        SYNC,       // Czekanie na ciszę t3.5 przed pierwszą ramką
+        IDLE,       // Magistrala wolna, następny bajt otwiera ramkę
+        RECEIVING   // Odbiór ramki, zamknięcie po przewidzianej długości lub ciszy t3.5
+    };
+
+    RtuTransport& _transport;
+    Clock& _clock;
     bool _analyzing;
     uint8_t _baudIndex;
+    unsigned long _currentBaud;
+    AutoBaud* _autoBaud;
+    BaudState _baudState;
+    uint32_t _lockStartTime;        // Początek ustalania prędkości
+    CaptureStream* _capture;
     uint8_t _buffer[MAX_BUFFER];
     uint8_t _bufferIndex;
+    ModbusCRC _crc;                 // CRC liczone w trakcie odbioru
+    const RtuTiming& _timing;       // Zależności czasowe bieżącej prędkości transportu
+    BusLoad _busLoad;               // Zajętość linii i przerwy między ramkami
+    RxState _rxState;
+    uint32_t _lastByteMicros;       // Znacznik czasu ostatniego bajtu
+    uint32_t _frameStartMicros;     // Znacznik czasu pierwszego bajtu ramki
+    bool _frameOverflow;            // Ramka dłuższa niż bufor
+    bool _frameT15Violation;        // Przerwa t1.5 < x < t3.5 w ramce
+    uint8_t _frameStatus;           // Suma RX_STATUS_* bajtów ramki
+    uint32_t _lastValidFrameTime;   // Do przełączania prędkości
+    uint32_t _lastOverflowCount;    // Stan licznika przepełnień pierścienia
     uint32_t _lastActivityTime;
     uint32_t _lastFrameTime;
     MasterInfo _masterInfo;
+    SlaveStats _slaveStats[MAX_SLAVE_STATS];
+    uint8_t _slaveStatsCount;
+
+    // Zapytanie czekające na odpowiedź
+    bool _pending;
+    ModbusTransaction _pendingRequest;
+    uint32_t _pendingEndMicros;     // Znacznik ostatniego bajtu zapytania
+    uint32_t _pendingTime;          // millis() do wykrycia timeoutu
+
+    // Filtr i wyzwalacz wyjścia
+    FrameFilter _filter;
+    FrameFilter _trigger;
+    FrameRing _history;             // Ramki przed wyzwoleniem
+    bool _triggerArmed;
+    uint8_t _postFrames;
+    uint8_t _postRemaining;         // Ramki do wypisania po wyzwoleniu
+    uint16_t _triggerCount;
+
+    // Zestawienie przepływów
+    FlowTable _flows;
+    uint32_t _flowPeriodMs;         // 0 - wydruk każdej ramki
+    uint32_t _lastFlowReport;
+    uint8_t _flowTop;
     
     void changeBaudRate();
-    uint16_t calculateCRC16(uint8_t* buffer, uint8_t length) const;
+    void applyBaud(unsigned long baud);
+    void updateBaudLock();
+    void restartBaudDetection();
+    void confirmBaud();
+    void onByte(const RxEvent& event);
+    void countLineErrors(uint8_t status);
+    void showLineErrors() const;
+    void checkSilence(uint32_t now);
+    void closeFrame();
+    void resetFrame();
+    bool frameComplete() const;
     bool processFrame();
+    uint8_t frameFlags() const;
+    void routeFrame(const FrameSummary& summary, const ModbusTransaction* transaction,
+                    FrameDirection direction);
+    void outputFrame(const FrameSummary& summary, const ModbusTransaction* transaction,
+                     FrameDirection direction);
+    void printFrame(uint8_t flags) const;
+    void dumpHistory();
+    static void printHex(const uint8_t* data, uint8_t length);
     void clearBuffer();
     void updateMasterInfo();
-    bool isAddressInList(uint8_t address) const;
-    bool isFunctionInList(uint8_t function) const;
-    const char* getFunctionName(uint8_t function) const;
+    FrameDirection pairTransaction(ModbusTransaction& transaction, FrameSummary& summary);
+    void printTransaction(const ModbusTransaction& transaction, FrameDirection direction) const;
+    void checkResponseTimeout();
+    SlaveStats* findSlaveStats(uint8_t address);
+    void resetSlaveStats();
+    void showSlaveStats() const;
     void updateTimingStats();
     void showTimingStats() const;
     void showErrorStats() const;
     void checkCollision();
+    void checkFlowReport();
+    bool textOutput() const { return _capture == nullptr; }
+    bool flowReport() const { return _flowPeriodMs && textOutput(); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef MODBUS_CRC_H
+#define MODBUS_CRC_H
+
+#include <stdint.h>
+
+// CRC16 Modbus RTU liczone przyrostowo - bajt po bajcie w miarę odbioru.
+// Domyślnie wariant tablicowy (PROGMEM), alternatywy wybierane flagą
+// kompilacji: -D MODBUS_CRC_NIBBLE (32 B flash) lub -D MODBUS_CRC_BITWISE.
+class ModbusCRC {
+public:
+    static const uint16_t INITIAL = 0xFFFF;
+    static const uint16_t TABLE_BYTES;         // Koszt tablicy pełnej we flash
+    static const uint16_t NIBBLE_TABLE_BYTES;  // Koszt tablicy półbajtowej
+
+    ModbusCRC() : _crc(INITIAL) {}
+
+    void reset() { _crc = INITIAL; }
+    void update(uint8_t byte);
+    void update(const uint8_t* buffer, uint16_t length);
+    uint16_t value() const { return _crc; }
+    // Po przejściu przez całą ramkę razem z CRC reszta wynosi 0
+    bool isValid() const { return _crc == 0; }
+
+    static uint16_t calculate(const uint8_t* buffer, uint16_t length);
+    static void append(uint8_t* frame, uint16_t length);
+    static bool check(const uint8_t* frame, uint16_t length);
+
+    static uint16_t updateBitwise(uint16_t crc, uint8_t byte);
+    static uint16_t updateNibble(uint16_t crc, uint8_t byte);
+    static uint16_t updateTable(uint16_t crc, uint8_t byte);
+
+private:
+    uint16_t _crc;
+};
+
+#endif
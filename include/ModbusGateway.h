@@ -0,0 +1,98 @@
+#ifndef MODBUS_GATEWAY_H
+#define MODBUS_GATEWAY_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "Config.h"
+
+// Bramka USB-RS485: host wysyła paczki zapytań w rekordach binarnych,
+// bramka trzyma je w kolejce i wykonuje jedno po drugim (tylko cisza
+// t3.5), bez opóźnień USB między transakcjami. Rekordy (little-endian):
+//   host -> bramka: 0x5A | długość N | znacznik | limit odpowiedzi ms | N bajtów
+//                   (adres + PDU, bez CRC); N = 0 kończy tryb bramki
+//   bramka -> host: 0x5B | długość N | znacznik | status | czas reakcji us u32 | N bajtów
+//                   (odpowiedź bez CRC)
+// Gdy w kolejce nie ma miejsca, bramka nie czyta USB - CDC wstrzymuje hosta.
+// Wynik czeka na miejsce w buforze nadawczym USB, więc żaden nie ginie.
+class ModbusGateway : public ResponseStream {
+public:
+    enum class Status : uint8_t {
+        OK,             // Odpowiedź z poprawnym CRC (także wyjątek)
+        CRC_ERROR,      // Odebrane bajty do diagnostyki
+        TIMEOUT,
+        TRUNCATED,      // CRC poprawne, ramka dłuższa niż bufor - początek
+        BROADCAST,      // Adres 0: nadane, odczekany limit odpowiedzi
+        INVALID         // Długość zapytania poza 2..MAX_REQUEST
+    };
+
+    static const uint8_t REQUEST_SYNC = 0x5A;
+    static const uint8_t RESULT_SYNC = 0x5B;
+    static const uint8_t RESULT_HEADER_SIZE = 8;
+    static const uint8_t MAX_REQUEST = RtuTransport::FRAME_SIZE - 2;
+    static const uint8_t DEFAULT_TIMEOUT_MS = 100;  // Limit 0 w rekordzie
+    static const uint8_t QUEUE_SIZE = GATEWAY_QUEUE_SIZE;
+
+    ModbusGateway(RtuTransport& transport, Clock& clock, Stream& host);
+    bool start(unsigned long baud);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showSummary() const;
+
+    // Strumień tylko po to, by CRC objęło całą ramkę dłuższą niż bufor
+    void responseByte(uint16_t, uint8_t) override {}
+
+private:
+    // Etap odczytu rekordu z USB
+    enum class Input : uint8_t {
+        SYNC,
+        LENGTH,
+        ROOM,           // Czekanie na miejsce w kolejce
+        TAG,
+        TIMEOUT,
+        DATA
+    };
+    // Wpis w kolejce: długość (0 - błędne zapytanie), znacznik, limit ms, bajty
+    static const uint8_t ENTRY_HEADER = 3;
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    Stream& _host;
+    bool _running;
+    bool _closing;                  // Rekord końca odebrany, kolejka się opróżnia
+    bool _active;                   // Transakcja w transporcie lub wynik do wysłania
+    bool _rejected;                 // Bieżący wpis to błędne zapytanie
+    uint8_t _tag;                   // Bieżącej transakcji
+    uint8_t _address;
+
+    uint8_t _queue[QUEUE_SIZE];
+    uint8_t _head;                  // Początek najstarszego wpisu
+    uint8_t _write;                 // Miejsce zapisu wczytywanego wpisu
+    uint8_t _used;                  // Bajty wpisów kompletnych
+    Input _input;
+    uint8_t _inLength;              // Długość z rekordu
+    uint8_t _inRemaining;           // Bajty danych do wczytania
+    bool _inDiscard;                // Błędna długość - dane pomijane
+
+    uint32_t _transactions;
+    uint32_t _ok;
+    uint16_t _crcErrors;
+    uint16_t _timeouts;
+    uint16_t _truncated;
+    uint16_t _invalid;
+    uint16_t _syncErrors;           // Bajty poza rekordami
+    uint8_t _maxQueued;
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+
+    void readHost();
+    void startNext();
+    bool reportResult();
+    void writeResult(Status status, uint32_t timeUs, const uint8_t* data, uint8_t length);
+    void push(uint8_t data);
+    uint8_t pop();
+    void finish();
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef MODBUS_PDU_H
+#define MODBUS_PDU_H
+
+#include <Arduino.h>
+
+enum class FrameDirection : uint8_t {
+    REQUEST,    // Master -> slave
+    RESPONSE    // Slave -> master
+};
+
+// Pola zdekodowanej ramki RTU
+struct ModbusTransaction {
+    uint8_t address;
+    uint8_t function;           // Kod funkcji bez bitu wyjątku
+    uint8_t exceptionCode;      // 0 = brak wyjątku
+    uint16_t startAddress;      // Pierwszy rejestr/cewka (żądanie)
+    uint16_t quantity;          // Liczba rejestrów/cewek, w odpowiedzi liczba bajtów
+    uint16_t value;             // 0x05/0x06: zapisana wartość
+    uint16_t writeAddress;      // 0x17: zakres zapisu
+    uint16_t writeQuantity;
+};
+
+// Dekoder ramek RTU wyliczający długość ramki z kodu funkcji i pola
+// liczby bajtów, dzięki czemu ramkę można zamknąć po ostatnim bajcie.
+class ModbusPdu {
+public:
+    static const uint16_t LENGTH_NEED_MORE = 0;     // Za mało bajtów do oceny
+    static const uint16_t LENGTH_UNKNOWN = 0xFFFF;  // Nieobsługiwana funkcja
+
+    // Długość całej ramki (adres + PDU + CRC) na podstawie odebranych bajtów
+    static uint16_t expectedLength(const uint8_t* frame, uint16_t received, FrameDirection direction);
+    static bool decode(const uint8_t* frame, uint16_t length, FrameDirection direction,
+                       ModbusTransaction& out);
+    // Nazwy we flash (F()) - na AVR literały poza F() zajmują SRAM
+    static const __FlashStringHelper* functionName(uint8_t function);
+    static const __FlashStringHelper* exceptionName(uint8_t code);
+
+private:
+    static uint16_t deviceIdLength(const uint8_t* frame, uint16_t received);
+};
+
+#endif
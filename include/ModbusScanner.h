@@ -1,45 +1,112 @@
 #ifndef MODBUS_SCANNER_H
 #define MODBUS_SCANNER_H
 #include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "DeviceCache.h"
+#include "Config.h"
 
-struct DeviceInfo {
-    uint8_t address;
-    unsigned long baudRate;
+enum class ScanMode : uint8_t {
+    FULL,           // Wszystkie adresy na wszystkich prędkościach
+    VERIFY,         // Tylko urządzenia zapamiętane w EEPROM
+    INCREMENTAL     // Zapamiętane, potem nieznane adresy na ich prędkościach
+};
+
+// Wynik ostatniego skanowania. Trzyma go właściciel skanera, więc lista
+// przeżywa skaner (np. utworzony na czas skanowania w ModeArena)
+struct ScanResult {
+    DeviceInfo devices[SCANNER_MAX_DEVICES];
+    uint8_t count = 0;
+};
+
+// Okna odpowiedzi skanowania (komenda "timing"). Leży u właściciela
+// skanera, więc ustawienia przeżywają skaner, jak ScanResult
+class ScanTiming {
+public:
+    static const uint16_t DEFAULT_TURNAROUND_MS = 10;   // Czas reakcji slave'a
+    static const uint16_t LEGACY_TIMEOUT_MS = 120;      // Dawne delay(20) + 100 ms
+
+    // turnaroundMs = 0: stałe okno LEGACY_TIMEOUT_MS dla każdego zapytania
+    void set(uint16_t turnaroundMs, uint8_t slowRetries, uint16_t slowTimeoutMs);
+    void show() const;
+
+    uint16_t turnaroundMs = DEFAULT_TURNAROUND_MS;
+    // Próby z długim oknem dla adresu, który odpowiedział za późno
+    uint8_t slowRetries = 1;
+    uint16_t slowTimeoutMs = LEGACY_TIMEOUT_MS;
 };
 
 class ModbusScanner {
 public:
-    ModbusScanner(HardwareSerial& modbusSerial, uint8_t dirPin);
+    ModbusScanner(RtuTransport& transport, Clock& clock, ScanResult& result,
+                  const ScanTiming& timing);
     void begin();
-    void startScan();
+    // Tryby VERIFY/INCREMENTAL bez zapamiętanej listy skanują w pełni
+    void startScan(ScanMode mode = ScanMode::FULL);
     void stopScan();
+    // Jeden krok automatu - wraca od razu, gdy transport jest zajęty
     void update();
     bool isScanning() const;
     uint8_t getFoundDevicesCount() const;
     const DeviceInfo* getFoundDevices() const;
-    bool readRegisters(uint8_t deviceAddr);
+
+    // Lista urządzeń zapisywana po zakończonym skanowaniu (nullptr = brak)
+    void setDeviceCache(DeviceCache* cache);
 
 private:
-    static const uint8_t MAX_FRAME_SIZE = 32;
-    static const uint8_t MAX_DEVICES = 10;
+    static const uint8_t MAX_DEVICES = SCANNER_MAX_DEVICES;
     static const uint8_t MAX_MODBUS_ADDRESS = 247;
-    static const unsigned long BAUD_RATES[];
+    static const uint8_t PROBE_REPLY_SIZE = 7;          // 0x03, 1 rejestr
+    static const uint8_t REGISTERS_REPLY_SIZE = 25;     // 0x03, 10 rejestrów
+    static const uint8_t VERIFY_RETRIES = 2;            // Próby dla zapamiętanych
+    static const unsigned long BAUD_RATES[];    // PROGMEM
     static const uint8_t BAUD_COUNT;
 
-    HardwareSerial& _serial;
-    uint8_t _dirPin;
+    // Etap pracy z bieżącym adresem
+    enum class Step : uint8_t {
+        NEXT,       // Wybór kolejnego adresu
+        PROBING,    // Zapytanie o 1 rejestr w toku
+        READING     // Odczyt 10 rejestrów znalezionego urządzenia
+    };
+
+    RtuTransport& _transport;
+    Clock& _clock;
     bool _scanning;
+    ScanMode _mode;
+    Step _step;
+    uint8_t _target;                // Adres w trakcie sprawdzania
+    unsigned long _targetBaud;
+    bool _targetKnown;              // Adres z listy w EEPROM
+    bool _targetSlow;               // Ponowne sprawdzenie z długim oknem
+    uint8_t _lateAddress;           // Odpowiedział w oknie innego adresu (0 = brak)
+    uint8_t _attempt;
+    uint8_t _attempts;
     uint8_t _currentAddress;
     uint8_t _currentBaudIndex;
-    uint8_t _foundDevices;
-    DeviceInfo* _devices;
-    uint8_t _buffer[MAX_FRAME_SIZE];
-    uint8_t _bufferIndex;
+    uint8_t _sweepBaudCount;        // Prędkości przeszukiwane adres po adresie
+    uint32_t _scanStartTime;
+    ScanResult& _result;
     uint32_t _lastActivityTime;
+    const ScanTiming& _timing;
+    DeviceCache* _cache;
+    DeviceInfo _known[MAX_DEVICES];     // Lista z EEPROM
+    uint8_t _knownCount;
+    uint8_t _verifyIndex;
 
-    bool testDevice(uint8_t address);
-    void changeBaudRate();
-    uint16_t calculateCRC16(uint8_t* buffer, uint8_t length) const;
-    void clearBuffer();
+    void startNextTarget();
+    void beginTarget(uint8_t address, unsigned long baud, uint8_t attempts, bool known,
+                     bool slow = false);
+    void sendProbe();
+    void handleProbe();
+    void handleRegisters();
+    void finishScan();
+    bool addDevice(uint8_t address, unsigned long baud);
+    bool isKnown(uint8_t address, unsigned long baud) const;
+    bool isFound(uint8_t address, unsigned long baud) const;
+    bool isFirstAtBaud(uint8_t i) const;
+    uint8_t countKnownBauds() const;
+    unsigned long sweepBaud(uint8_t index) const;
+    uint32_t responseWindowUs(uint8_t replySize) const;
+    void setBaud(unsigned long baud);
 };
 #endif
\ No newline at end of file
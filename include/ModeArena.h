@@ -0,0 +1,108 @@
+#ifndef MODE_ARENA_H
+#define MODE_ARENA_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "DeviceCache.h"
+#include "ModbusScanner.h"
+#include "LoadTester.h"
+#include "RegisterMapper.h"
+#include "RegisterDump.h"
+#include "SlaveEmulator.h"
+#include "ModbusGateway.h"
+#include "RegisterWatch.h"
+#ifdef SD_LOG
+#include "SdLogger.h"
+#include "CaptureStream.h"
+#endif
+
+// Obiekty trybów pracy we wspólnej pamięci (także bufory logu SD, potrzebne
+// tylko w trakcie nasłuchu z zapisem na kartę). Tryby wykluczają się, więc
+// zamiast osobnego obiektu globalnego dla każdego jest jeden obszar
+// wielkości największego. Akcesor tworzy obiekt (placement new) i niszczy
+// poprzedni, gdy w obszarze był inny; kolejne wywołania zwracają ten sam.
+// W obszarze są tylko bufory robocze - mały stan, który musi przeżyć
+// zmianę trybu (wynik i okna skanowania, ustawienia błędów emulatora,
+// bloki obserwacji), leży obok unii.
+class ModeArena {
+public:
+    enum class Kind : uint8_t {
+        NONE,
+        SCANNER,
+        LOAD_TEST,
+        MAPPER,
+        DUMP,
+        EMULATOR,
+        GATEWAY,
+        WATCH,
+        SD_LOGGER       // Bufory logu SD w nasłuchu bez komputera
+    };
+
+#ifdef SD_LOG
+    // Log SD ze strumieniem rekordów, który do niego pisze
+    struct SdLog {
+        SdLogger logger;
+        CaptureStream capture;
+
+        explicit SdLog(Clock& clock) : logger(clock), capture(logger) {}
+    };
+#endif
+
+    ModeArena(RtuTransport& transport, Clock& clock, Stream& host, DeviceCache& cache);
+    ~ModeArena();
+
+    Kind kind() const { return _kind; }
+    // Urządzenia z ostatniego skanowania, także po wejściu w inny tryb
+    const ScanResult& scanResult() const { return _scanResult; }
+    // Ustawienia "timing" dla kolejnych skanowań
+    ScanTiming& scanTiming() { return _scanTiming; }
+    // Ustawienia "fault" - zmiana działa od razu także w trakcie emulacji
+    EmulatorFaults& emulatorFaults() { return _emulatorFaults; }
+    // Bloki "watch add/band" - konfiguracja, nie stan obserwacji
+    WatchBlocks& watchBlocks() { return _watchBlocks; }
+
+    ModbusScanner& scanner();
+    LoadTester& loadTester();
+    RegisterMapper& mapper();
+    RegisterDump& registerDump();
+    SlaveEmulator& emulator();
+    ModbusGateway& gateway();
+    RegisterWatch& registerWatch();
+#ifdef SD_LOG
+    SdLog& sdLog();
+#endif
+
+private:
+    // Unia bez konstruktorów składowych - obiekt tworzy akcesor
+    union Slot {
+        Slot() {}
+        ~Slot() {}
+        ModbusScanner scanner;
+        LoadTester loadTester;
+        RegisterMapper mapper;
+        RegisterDump registerDump;
+        SlaveEmulator emulator;
+        ModbusGateway gateway;
+        RegisterWatch registerWatch;
+#ifdef SD_LOG
+        SdLog sdLog;
+#endif
+    };
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    Stream& _host;
+    DeviceCache& _cache;
+    ScanResult _scanResult;
+    ScanTiming _scanTiming;
+    EmulatorFaults _emulatorFaults;
+    WatchBlocks _watchBlocks;
+    Kind _kind;
+    Slot _slot;
+
+    bool occupy(Kind kind);
+    void release();
+};
+
+#endif
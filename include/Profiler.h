@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "Hal.h"
+
+// Etapy pętli głównej mierzone w buildzie profilującym
+enum class ProfileStage : uint8_t {
+    LOOP,           // Cała iteracja loop()
+    BUS,            // busTask - tryb bieżący
+    FRAME,          // Zamknięcie i obróbka ramki
+    PRINT,          // Wydruk lub rekord binarny ramki
+    COMMANDS,       // Konsola USB
+    BUTTONS,
+    LED,
+    COUNT
+};
+
+#ifdef PROFILE
+// Liczniki czasu gorącej ścieżki: wywołania, suma i maksimum na etap oraz
+// iteracje pętli dłuższe niż znak przy bieżącej prędkości - wtedy pierścień
+// RX zapełnia się szybciej, niż jest opróżniany. Tylko z -DPROFILE
+// (env:leonardo_profile); bez flagi makra PROFILE_* są puste.
+// Czas z micros() (na AVR co 4 us); etap zagnieżdżony, np. wydruk w obróbce
+// ramki, liczy się także w etapie nadrzędnym. Obsługa jednego bajtu trwa
+// krócej niż ta rozdzielczość, więc nie jest osobnym etapem - mieści się
+// w BUS, a jej koszt mierzy odtwarzanie zapisów na hoście (ns na ramkę).
+class Profiler {
+    struct StageStats {
+        uint32_t count;
+        uint32_t totalUs;
+        uint32_t maxUs;
+    };
+
+public:
+    static const uint8_t STAGE_COUNT = (uint8_t)ProfileStage::COUNT;
+    static const uint16_t SRAM_BYTES = STAGE_COUNT * sizeof(StageStats) + 2 * sizeof(uint32_t)
+                                       + sizeof(Clock*);
+
+    static void begin(Clock& clock);
+    static uint32_t now() { return _clock ? _clock->micros() : 0; }
+    static void record(ProfileStage stage, uint32_t startUs);
+    static void endLoop(uint32_t startUs, uint32_t charUs);
+    static void reset();
+    static void showStats();
+
+private:
+    static Clock* _clock;
+    static StageStats _stages[STAGE_COUNT];
+    static uint32_t _slowLoops;     // Iteracje dłuższe niż znak
+    static uint32_t _charUs;        // Czas znaku z ostatniej iteracji
+
+    static void printStageName(ProfileStage stage);
+};
+
+// Pomiar etapu do końca zasięgu
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage) : _stage(stage), _startUs(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(_stage, _startUs); }
+
+private:
+    ProfileStage _stage;
+    uint32_t _startUs;
+};
+
+// Pomiar iteracji pętli wobec czasu znaku
+class ProfileLoop {
+public:
+    explicit ProfileLoop(uint32_t charUs) : _charUs(charUs), _startUs(Profiler::now()) {}
+    ~ProfileLoop() { Profiler::endLoop(_startUs, _charUs); }
+
+private:
+    uint32_t _charUs;
+    uint32_t _startUs;
+};
+
+#define PROFILE_SCOPE(stage) ProfileScope profileScope(ProfileStage::stage)
+#define PROFILE_LOOP(charUs) ProfileLoop profileLoop(charUs)
+#else
+#define PROFILE_SCOPE(stage)
+#define PROFILE_LOOP(charUs)
+#endif
+
+#endif
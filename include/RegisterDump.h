@@ -0,0 +1,60 @@
+#ifndef REGISTER_DUMP_H
+#define REGISTER_DUMP_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+
+// Zrzut bloku rejestrów 0x03/0x04 odczytami o maksymalnej długości PDU
+// (125 rejestrów, 255 B odpowiedzi) mimo 32-bajtowego bufora transportu:
+// wartości są wypisywane w miarę odbioru, a CRC sprawdzane przyrostowo.
+// Wynik CRC znany jest dopiero po ostatnim bajcie - przy błędzie blok
+// jest oznaczany jako niepewny i czytany ponownie.
+class RegisterDump : public ResponseStream {
+public:
+    static const uint8_t MAX_REGISTERS = 125;       // Limit PDU dla 0x03/0x04
+    static const uint16_t TURNAROUND_MS = 20;
+    static const uint8_t RETRIES = 2;               // Ponowienia bloku po błędzie
+
+    RegisterDump(RtuTransport& transport, Clock& clock);
+    bool start(uint8_t address, unsigned long baud, uint8_t function, uint16_t first, uint16_t count);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showSummary() const;
+
+    void responseByte(uint16_t offset, uint8_t data) override;
+
+private:
+    static const uint8_t REQUEST_LENGTH = 6;        // Bez CRC
+    static const uint8_t HEADER_SIZE = 3;           // Adres, funkcja, liczba bajtów
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    bool _running;
+    bool _pending;
+    uint8_t _address;
+    uint8_t _function;
+    uint16_t _next;                 // Pierwszy rejestr bieżącego bloku
+    uint16_t _remaining;            // Rejestry do odczytu łącznie z blokiem
+    uint8_t _blockCount;
+    uint8_t _attempt;
+    bool _accepted;                 // Nagłówek odpowiedzi pasuje do zapytania
+    uint8_t _high;                  // Starszy bajt bieżącego rejestru
+
+    uint16_t _requests;             // Najwyżej ~525 bloków na 65536 rejestrów z ponowieniami
+    uint32_t _registers;            // Rejestry z poprawnym CRC
+    uint16_t _crcErrors;
+    uint16_t _timeouts;
+    uint16_t _exceptions;
+    uint32_t _busBytes;
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+
+    void sendBlock();
+    void handleResult();
+    void nextBlock();
+    void printRegister(uint16_t reg, uint16_t value);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef REGISTER_MAPPER_H
+#define REGISTER_MAPPER_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "Config.h"
+
+// Ciągły zakres adresów jednej tablicy Modbus (funkcja odczytu 0x01-0x04)
+struct RegisterRange {
+    uint8_t function;
+    uint16_t first;
+    uint16_t last;
+};
+
+// Mapa rejestrów urządzenia. Od adresów startowych typowych dla
+// urządzeń (0, 1, 100, 1000, 30000, 40000...) pojedynczy odczyt sprawdza,
+// czy adres istnieje; granice zakresu szukane są odczytami blokowymi
+// o podwajanej długości (cały blok poprawny - przesunięcie o blok)
+// i połowieniem bloku, który zakończył się wyjątkiem 0x02. Zakres N
+// adresów kosztuje ~2*log2(N) zapytań w każdą stronę zamiast N.
+// Wyjątek 0x01 na pierwszym odczycie - tablica nieobsługiwana; 0x03 przy
+// odczycie blokowym obniża limit bloku. Bloki do maksymalnej długości
+// PDU - odpowiedź odbierana strumieniowo, z danych liczy się tylko
+// długość i CRC.
+class RegisterMapper : public ResponseStream {
+public:
+    static const uint8_t MAX_RANGES = MAPPER_MAX_RANGES;
+    static const uint8_t MAX_REGISTERS = 125;       // Limity PDU odczytu
+    static const uint16_t MAX_BITS = 2000;
+    static const uint16_t TURNAROUND_MS = 20;
+    static const uint8_t MAX_TIMEOUTS = 3;      // Kolejne - urządzenie zniknęło
+
+    RegisterMapper(RtuTransport& transport, Clock& clock);
+    bool start(uint8_t address, unsigned long baud);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showMap() const;
+
+    uint8_t rangeCount() const { return _rangeCount; }
+    const RegisterRange* ranges() const { return _ranges; }
+    uint16_t requestCount() const { return _requests; }
+
+    void responseByte(uint16_t, uint8_t) override {}
+
+private:
+    static const uint8_t TABLE_COUNT = 4;
+    static const uint8_t INITIAL_BLOCK = 8;     // Pierwszy blok za adresem startowym
+    static const uint8_t REQUEST_LENGTH = 6;    // Bez CRC
+
+    // Etap szukania w bieżącej tablicy
+    enum class Step : uint8_t {
+        SEED,       // Pojedynczy odczyt adresu startowego
+        DOWN,       // Bloki poniżej zakresu
+        DOWN_SEARCH,// Połowienie bloku poniżej
+        UP,         // Bloki powyżej zakresu
+        UP_SEARCH   // Połowienie bloku powyżej
+    };
+
+    // Wynik zapytania z punktu widzenia mapy
+    enum class Reply : uint8_t {
+        VALID,          // Dane o oczekiwanej długości
+        INVALID,        // Wyjątek 0x02 lub inny błąd adresu
+        TOO_LONG,       // Wyjątek 0x03 - za duży blok
+        UNSUPPORTED,    // Wyjątek 0x01
+        NONE            // Brak odpowiedzi, błąd CRC, zła ramka
+    };
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    bool _running;
+    bool _pending;
+    uint8_t _address;
+    unsigned long _baud;
+    uint8_t _table;                 // Indeks funkcji 0x01-0x04
+    uint8_t _seed;
+    Step _step;
+    uint16_t _first;                // Znany poprawny zakres
+    uint16_t _last;
+    uint16_t _block;                // Bieżący rozmiar bloku (podwajany)
+    uint16_t _limit;                // Najdłuższy blok akceptowany przez urządzenie
+    uint16_t _good;                 // Połowienie: najdłuższy poprawny / najkrótszy błędny
+    uint16_t _bad;
+    uint16_t _probeStart;
+    uint16_t _probeCount;
+    uint8_t _supported;             // Bity tablic, które odpowiedziały danymi
+    uint8_t _unsupported;           // Bity tablic z wyjątkiem 0x01
+    uint8_t _timeouts;
+    bool _lost;
+    RegisterRange _ranges[MAX_RANGES];
+    uint8_t _rangeCount;
+    uint8_t _dropped;               // Zakresy bez miejsca w mapie
+    uint16_t _requests;
+    uint16_t _exceptions;
+    uint16_t _noReply;
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+
+    void beginTable(uint8_t table);
+    void nextSeed();
+    void extendDown();
+    void searchDown();
+    void startUp();
+    void extendUp();
+    void searchUp();
+    void grow(uint16_t accepted);
+    void finishRange();
+    void finish();
+    void probe(uint16_t start, uint16_t count);
+    void handleReply(Reply reply);
+    Reply readReply();
+    uint16_t replySize(uint16_t count) const;
+    uint8_t function() const { return _table + 1; }
+    uint16_t maxBlock() const;
+    bool isMapped(uint16_t address) const;
+    static void printFunctionName(uint8_t function);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef REGISTER_WATCH_H
+#define REGISTER_WATCH_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "BitSet.h"
+#include "Config.h"
+
+// Obserwowane bloki i pasma martwe. Trzyma je właściciel obserwacji
+// (ModeArena), więc konfiguracja "watch add/band" przeżywa zmianę trybu.
+class WatchBlocks {
+public:
+    static const uint8_t MAX_BLOCKS = WATCH_MAX_BLOCKS;
+    static const uint8_t MAX_REGISTERS = WATCH_MAX_REGISTERS;   // Łącznie we wszystkich blokach
+    static const uint8_t MAX_BLOCK_REGISTERS = (RtuTransport::FRAME_SIZE - 5) / 2;
+
+    struct Block {
+        uint8_t address;
+        uint8_t function;
+        uint16_t first;
+        uint8_t count;
+        uint8_t offset;             // Pierwszy indeks wartości i pasm
+    };
+
+    bool add(uint8_t address, uint8_t function, uint16_t first, uint8_t count);
+    bool setDeadband(uint8_t address, uint16_t reg, uint16_t band);
+    void clear();
+    uint8_t count() const { return _blockCount; }
+    uint8_t registerCount() const { return _registerCount; }
+    uint8_t firstAddress() const { return _blockCount ? _blocks[0].address : 0; }
+    const Block& block(uint8_t index) const { return _blocks[index]; }
+    uint16_t deadband(uint8_t index) const { return _deadbands[index]; }
+    void show() const;
+
+private:
+    Block _blocks[MAX_BLOCKS];
+    uint16_t _deadbands[MAX_REGISTERS] = {};
+    uint8_t _blockCount = 0;
+    uint8_t _registerCount = 0;
+};
+
+// Obserwacja rejestrów na żywo: bloki 0x03/0x04 są odpytywane po kolei bez
+// przerw (tylko cisza t3.5 transportu), a wypisywane są wyłącznie zmiany.
+// Rekord zmiany to jeden wiersz na odpowiedź bloku:
+//   <ms od startu> <adres>: <rejestr>=<wartość> ...
+// Pierwszy odczyt wypisuje wszystkie wartości. Z pasmem martwym rejestr jest
+// zgłaszany dopiero, gdy różni się od ostatnio wypisanej wartości o więcej
+// niż pasmo - wolne dryfy też się kumulują.
+class RegisterWatch {
+public:
+    static const uint16_t TURNAROUND_MS = 20;
+
+    RegisterWatch(RtuTransport& transport, Clock& clock, const WatchBlocks& blocks);
+    bool start(unsigned long baud);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showSummary() const;
+
+private:
+    static const uint8_t REQUEST_LENGTH = 6;        // Bez CRC
+    static const uint8_t HEADER_SIZE = 3;           // Adres, funkcja, liczba bajtów
+
+    // Stan bloku - błąd jest wypisywany tylko przy zmianie stanu
+    enum class BlockState : uint8_t {
+        OK,
+        TIMEOUT,
+        CRC_ERROR,
+        EXCEPTION
+    };
+
+    typedef WatchBlocks::Block Block;
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    const WatchBlocks& _blocks;
+    bool _running;
+    bool _pending;
+    uint8_t _current;               // Odpytywany blok
+    BlockState _states[WatchBlocks::MAX_BLOCKS];
+    uint16_t _values[WatchBlocks::MAX_REGISTERS];   // Ostatnio wypisane wartości
+    BitSet<WatchBlocks::MAX_REGISTERS> _known;      // Wartość już wypisana
+
+    uint32_t _polls;
+    uint32_t _changes;              // Zgłoszone rejestry
+    uint32_t _records;              // Wiersze zmian i błędów
+    uint32_t _readValues;           // Rejestry w poprawnych odpowiedziach
+    uint16_t _crcErrors;
+    uint16_t _timeouts;
+    uint16_t _exceptions;
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+
+    void sendBlock();
+    void handleResult();
+    void reportValues(const Block& block, const uint8_t* data);
+    void reportState(uint8_t index, BlockState state, uint8_t exceptionCode);
+    void printRecordStart(const Block& block) const;
+};
+
+#endif
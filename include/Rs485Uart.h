@@ -0,0 +1,46 @@
+#ifndef RS485_UART_H
+#define RS485_UART_H
+
+#include "Hal.h"
+#include "Config.h"
+
+// Sterownik USART1 zastępujący Serial1. Przerwanie RX zapisuje pary
+// (bajt, czas) do pierścienia SPSC bez blokad: ISR przesuwa tylko _head,
+// pętla główna tylko _tail. Nadawanie jest odpytywane (half-duplex);
+// RtuTransport wpisuje bajt dopiero, gdy txReady(), więc nie czeka.
+class Rs485Uart : public SerialPort {
+public:
+    static const uint8_t RING_SIZE = RX_RING_SIZE;
+
+    Rs485Uart();
+    void begin(unsigned long baud) override;
+    void end() override;
+    int available() override;
+    int read() override;
+    bool readEvent(RxEvent& event) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+    bool txReady() override;
+    bool txComplete() override;
+    uint32_t overflowCount() const override;
+
+    void handleRxInterrupt();
+
+private:
+    static const uint8_t RING_MASK = RING_SIZE - 1;
+    // micros() ma rozdzielczość 4 us przy 16 MHz - dwa najmłodsze bity
+    // znacznika niosą kod statusu bajtu zamiast osobnej tablicy (64 B SRAM)
+    static const uint16_t STATUS_MASK = 0x03;
+
+    volatile uint8_t _data[RING_SIZE];
+    // Młodsze 16 bitów micros(); readEvent() odtwarza pełny czas względem
+    // bieżącego micros(), więc bajt musi zostać odczytany przed upływem
+    // 65,5 ms - pętla główna opróżnia pierścień znacznie częściej
+    volatile uint16_t _timestamps[RING_SIZE];
+    volatile uint8_t _head;
+    volatile uint8_t _tail;
+    volatile uint32_t _overflows;   // Bajty utracone przy pełnym pierścieniu
+    bool _written;                  // Czy od begin() cokolwiek nadano
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef RTU_TIMING_H
+#define RTU_TIMING_H
+
+#include <stdint.h>
+
+// Zależności czasowe Modbus RTU dla danej prędkości.
+// Znak RTU to 11 bitów (start, 8 danych, parzystość lub drugi stop, stop).
+// Powyżej 19200 baud specyfikacja zaleca stałe t1.5 = 750 us i t3.5 = 1750 us.
+struct RtuTiming {
+    static const uint8_t BITS_PER_CHAR = 11;
+    static const uint32_t FIXED_BAUD_LIMIT = 19200;
+    static const uint32_t FIXED_T15_US = 750;
+    static const uint32_t FIXED_T35_US = 1750;
+
+    uint32_t charUs;    // Czas jednego znaku
+    uint32_t t15Us;     // Maksymalna przerwa między znakami ramki
+    uint32_t t35Us;     // Minimalna cisza między ramkami
+
+    void setBaud(unsigned long baud) {
+        charUs = (BITS_PER_CHAR * 1000000UL + baud / 2) / baud;
+        if (baud > FIXED_BAUD_LIMIT) {
+            t15Us = FIXED_T15_US;
+            t35Us = FIXED_T35_US;
+        } else {
+            t15Us = charUs * 3 / 2;
+            t35Us = charUs * 7 / 2;
+        }
+    }
+
+    static RtuTiming forBaud(unsigned long baud) {
+        RtuTiming timing;
+        timing.setBaud(baud);
+        return timing;
+    }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef RTU_TRANSPORT_H
+#define RTU_TRANSPORT_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "Config.h"
+#include "RtuTiming.h"
+#include "ModbusCRC.h"
+
+// Odbiorca odpowiedzi strumieniowej: każdy bajt z pozycją w ramce,
+// w chwili odbioru - zanim wiadomo, czy CRC się zgodzi
+class ResponseStream {
+public:
+    virtual void responseByte(uint16_t offset, uint8_t data) = 0;
+};
+
+// Źródło nadawanej ramki (tryb slave): bajty razem z CRC pobierane
+// w chwili wpisywania do nadajnika, bez bufora na całą odpowiedź
+class FrameSource {
+public:
+    virtual uint8_t frameByte(uint8_t offset) = 0;
+};
+
+// Wspólna warstwa RS485 dla skanera, analizatora i emulatora slave'a:
+// prędkość, sterowanie pinem DIR, dopisywanie i sprawdzanie CRC. Zapytanie jest obsługiwane
+// przez automat stanów odpytywany z poll(), bez delay() i aktywnego
+// czekania - pętla główna w tym czasie obsługuje przyciski i LED.
+class RtuTransport {
+public:
+    enum class Result : uint8_t {
+        NONE,       // Brak zakończonej transakcji
+        PENDING,    // Nadawanie lub oczekiwanie na odpowiedź
+        RESPONSE,   // Odpowiedź z poprawnym CRC
+        CRC_ERROR,  // Ramka odebrana, CRC niezgodne
+        TIMEOUT,    // Brak pierwszego bajtu w oknie odpowiedzi
+        REQUEST,    // Tryb slave: zapytanie z poprawnym CRC
+        SENT        // Tryb slave: odpowiedź nadana
+    };
+
+    static const uint8_t FRAME_SIZE = TRANSPORT_FRAME_SIZE;
+    static const uint16_t DIR_SETTLE_US = 50;       // Włączenie nadajnika
+    static const uint16_t BAUD_SETTLE_MS = 10;      // Po zmianie prędkości przed nadawaniem
+
+    RtuTransport(SerialPort& serial, Gpio& gpio, Clock& clock, uint8_t dirPin);
+    void begin(unsigned long baud);
+    // Zmiana prędkości od razu dla odbioru; nadawanie po BAUD_SETTLE_MS
+    void setBaud(unsigned long baud);
+    unsigned long baud() const { return _baud; }
+    const RtuTiming& timing() const { return _timing; }
+
+    // Zapytanie bez CRC (dopisywane tutaj); false gdy transport zajęty.
+    // Ze strumieniem odpowiedź może być dłuższa niż FRAME_SIZE: bajty idą
+    // do stream, w response() zostaje tylko początek ramki, a CRC liczone
+    // jest przyrostowo po całości.
+    bool request(const uint8_t* frame, uint8_t length, uint32_t responseWindowUs,
+                 ResponseStream* stream = nullptr);
+    // Tryb slave: odbiór jednego zapytania (bez limitu czasu), potem
+    // nadanie odpowiedzi ze źródła - nie wcześniej niż t3.5 po zapytaniu
+    bool listen();
+    bool send(FrameSource& source, uint8_t length);
+    void poll();
+    bool busy() const;
+    Result result() const { return _result; }
+    const uint8_t* response() const { return _rxBuffer; }
+    uint8_t responseLength() const { return _rxLength; }
+    // Długość całej odebranej ramki, także ponad bufor (tryb strumieniowy)
+    uint16_t responseCount() const { return _rxCount; }
+    // Koniec ostatniego znaku na linii i początek nadawania (tryb slave)
+    uint32_t lastByteUs() const { return _lastByteUs; }
+    uint32_t txStartUs() const { return _txStartUs; }
+    // Cisza od końca zapytania do początku odpowiedzi
+    uint32_t turnaroundUs() const;
+    void cancel();
+
+    // Nasłuch bez nadawania (analizator)
+    bool readEvent(RxEvent& event) { return _serial.readEvent(event); }
+    uint32_t overflowCount() const { return _serial.overflowCount(); }
+    void clear();
+
+private:
+    enum class State : uint8_t {
+        IDLE,
+        SETTLING,       // Czekanie po zmianie prędkości
+        ENABLING,       // DIR w stanie wysokim, nadajnik się włącza
+        TRANSMITTING,   // Wpisywanie kolejnych bajtów
+        DRAINING,       // Czekanie na opróżnienie nadajnika
+        WAITING,        // Okno na pierwszy bajt odpowiedzi
+        LISTENING,      // Tryb slave: czekanie na zapytanie
+        RECEIVING       // Odbiór do przewidzianej długości lub ciszy t3.5
+    };
+
+    SerialPort& _serial;
+    Gpio& _gpio;
+    Clock& _clock;
+    uint8_t _dirPin;
+    unsigned long _baud;
+    RtuTiming _timing;
+    State _state;
+    Result _result;
+    uint32_t _settleStartMs;
+    bool _baudChanged;              // Od zmiany prędkości nic nie nadano
+    uint32_t _stateStartUs;
+    uint32_t _windowUs;
+    uint32_t _txStartUs;
+    uint32_t _txEndUs;
+    uint32_t _rxStartUs;            // Znacznik pierwszego bajtu odpowiedzi
+    uint32_t _lastByteUs;           // Ostatni znak na linii (nadany lub odebrany)
+    uint8_t _txBuffer[FRAME_SIZE];
+    uint8_t _txLength;
+    uint8_t _txIndex;
+    FrameSource* _txSource;         // Zamiast _txBuffer (tryb slave)
+    bool _slave;                    // Odbiór zapytań, nadawanie bez czekania na odpowiedź
+    uint8_t _rxBuffer[FRAME_SIZE];
+    uint8_t _rxLength;
+    uint16_t _rxCount;              // Bajty odpowiedzi łącznie z niebuforowanymi
+    ModbusCRC _rxCrc;
+    ResponseStream* _stream;
+    bool _rxOverflow;
+
+    void receive(uint32_t now);
+    void resetReceive();
+    Result validResult() const { return _slave ? Result::REQUEST : Result::RESPONSE; }
+    void finish(Result result);
+};
+
+#endif
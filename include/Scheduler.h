@@ -0,0 +1,46 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// Kooperacyjny planista pętli głównej. Zadania są krótkie i nigdy nie
+// blokują (bez delay()), więc każde dostaje czas procesora co przejście
+// lub co zadany odstęp. Pojemność ustalana w czasie kompilacji.
+template <uint8_t CAPACITY>
+class Scheduler {
+public:
+    typedef void (*Task)();
+
+    Scheduler() : _count(0) {}
+
+    // Odstęp 0 = wywołanie w każdym przejściu pętli
+    bool add(Task task, uint16_t intervalMs) {
+        if (_count >= CAPACITY) return false;
+        _tasks[_count].task = task;
+        _tasks[_count].intervalMs = intervalMs;
+        _tasks[_count].lastRunMs = 0;
+        _count++;
+        return true;
+    }
+
+    void run(uint32_t nowMs) {
+        for (uint8_t i = 0; i < _count; i++) {
+            Entry& entry = _tasks[i];
+            if (entry.intervalMs && nowMs - entry.lastRunMs < entry.intervalMs) continue;
+            entry.lastRunMs = nowMs;
+            entry.task();
+        }
+    }
+
+private:
+    struct Entry {
+        Task task;
+        uint16_t intervalMs;
+        uint32_t lastRunMs;
+    };
+
+    Entry _tasks[CAPACITY];
+    uint8_t _count;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SD_LOGGER_H
+#define SD_LOGGER_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "Config.h"
+
+// Zapis rekordów CaptureStream na nośnik blokowy bez blokowania odbioru.
+// Dwa bufory: jeden się zapełnia, drugi czeka na wolną kartę i jest
+// wysyłany z poll(). Bufor jest częścią sektora 512 B (na Leonardo nie
+// ma miejsca na dwa pełne sektory), karta dostaje sektor kawałkami
+// w jednym zapisie wieloblokowym. Gdy oba bufory są pełne,
+// availableForWrite() zwraca za mało i CaptureStream liczy rekord jako
+// utracony - luka widoczna też w numerach sekwencji.
+//
+// Sektor zaczyna się nagłówkiem: "MBLG" | sesja u32. Obszar logu jest
+// przydzielany z góry (ciągły, bez aktualizacji FAT), a stare sektory
+// z innych sesji host odrzuca po numerze sesji (tools/capture2pcap.py --sd).
+class SdLogger : public Print {
+public:
+    static const uint16_t SECTOR_SIZE = BlockDevice::BLOCK_SIZE;
+    static const uint16_t BUFFER_SIZE = SD_LOG_BUFFER_SIZE;
+    static const uint8_t CHUNKS = SECTOR_SIZE / BUFFER_SIZE;
+    static const uint8_t HEADER_SIZE = 8;
+
+    explicit SdLogger(Clock& clock);
+    // Zapis od bloku 0; blocks = 0 - cały nośnik. Karta z systemem plików
+    // (sygnatura 0x55AA w bloku 0 bez nagłówka logu) tylko z force
+    bool begin(BlockDevice& device, uint32_t session, uint32_t blocks, bool force);
+    // Dopełnia sektor zerami i kończy zapis; czeka na kartę (tylko przy STOP)
+    void end();
+    void poll();
+    bool isLogging() const { return _device != nullptr; }
+    void showSummary() const;
+
+    using Print::write;
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override;
+
+private:
+    Clock& _clock;
+    BlockDevice* _device;
+    uint8_t _buffers[2][BUFFER_SIZE];
+    uint8_t _active;                // Bufor zapełniany
+    uint16_t _length;               // Bajty w buforze aktywnym
+    uint8_t _chunk;                 // Część sektora w buforze aktywnym
+    bool _pending;                  // Drugi bufor pełny, czeka na kartę
+    bool _full;                     // Koniec obszaru logu
+    uint32_t _session;
+    uint32_t _blocks;               // Rozmiar obszaru logu
+    uint32_t _sector;               // Sektor bufora aktywnego
+    uint32_t _pendingSince;         // micros() zapełnienia bufora oczekującego
+    uint32_t _maxWaitUs;            // Najdłuższe czekanie bufora na kartę
+    uint32_t _sectorsWritten;
+    bool _error;
+
+    static bool hasFileSystem(BlockDevice& device);
+    void swap();
+    void send();
+    void drain();
+    bool cardReady();
+    uint16_t chunkRoom(uint8_t chunk) const;
+};
+
+static_assert(BlockDevice::BLOCK_SIZE % SD_LOG_BUFFER_SIZE == 0,
+              "SD_LOG_BUFFER_SIZE musi dzielic sektor 512 B");
+
+#endif
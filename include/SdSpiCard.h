@@ -0,0 +1,45 @@
+#ifndef SD_SPI_CARD_H
+#define SD_SPI_CARD_H
+
+#include <Arduino.h>
+#include "Hal.h"
+
+// Karta SD/SDHC przez SPI bez systemu plików (ICSP: MOSI, MISO, SCK + CS).
+// Log zajmuje kartę od bloku 0 - karta przeznaczona tylko do logu,
+// odczyt na PC: dd z urządzenia i tools/capture2pcap.py --sd.
+// Zapis wieloblokowy CMD25 z wstępnym wymazaniem ACMD23; bajty bloku
+// można wysyłać w częściach, a zajętość karty sprawdza busy() bez czekania.
+class SdSpiCard : public BlockDevice {
+public:
+    explicit SdSpiCard(uint8_t csPin);
+    // Inicjalizacja karty (do ~1 s, tylko przy starcie logu)
+    bool begin();
+    uint32_t blockCount() override { return _blocks; }
+    bool startWrite(uint32_t block, uint32_t count) override;
+    bool writeData(const uint8_t* data, uint16_t length) override;
+    bool busy() override;
+    bool stopWrite() override;
+    bool readData(uint32_t block, uint16_t offset, uint8_t* data, uint16_t length) override;
+
+private:
+    static const uint16_t INIT_TIMEOUT_MS = 1000;
+    static const uint16_t BUSY_TIMEOUT_MS = 600;
+
+    uint8_t _csPin;
+    uint32_t _spiClock;             // 250 kHz przy inicjalizacji, potem 8 MHz
+    bool _highCapacity;             // SDHC/SDXC - adres w blokach, nie w bajtach
+    uint32_t _blocks;
+    uint16_t _offset;               // Bajty wysłane z bieżącego bloku
+    bool _writing;
+    bool _selected;
+
+    void select();
+    void deselect();
+    bool waitReady(uint16_t timeoutMs);
+    bool waitDataToken();
+    uint8_t command(uint8_t index, uint32_t argument);
+    uint8_t appCommand(uint8_t index, uint32_t argument);
+    bool readCsd();
+};
+
+#endif
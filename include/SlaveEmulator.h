@@ -0,0 +1,108 @@
+#ifndef SLAVE_EMULATOR_H
+#define SLAVE_EMULATOR_H
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "RtuTransport.h"
+#include "Config.h"
+
+// Wstrzykiwane błędy emulatora. Trzyma je właściciel emulatora (ModeArena),
+// więc ustawienia "fault" przeżywają emulator i działają od razu w trakcie
+// emulacji.
+class EmulatorFaults {
+public:
+    static const uint8_t BUSY_EXCEPTION = 0x06;     // Domyślny wstrzykiwany wyjątek
+
+    // Procenty zapytań z błędem; wyjątek zastępuje poprawną odpowiedź
+    void set(uint8_t crcPercent, uint8_t exceptionPercent, uint8_t dropPercent,
+             uint16_t delayMs, uint8_t exceptionCode = BUSY_EXCEPTION);
+    void show() const;
+
+    uint8_t crcPercent = 0;
+    uint8_t exceptionPercent = 0;
+    uint8_t dropPercent = 0;
+    uint8_t exceptionCode = BUSY_EXCEPTION;
+    uint16_t delayMs = 0;
+};
+
+// Wirtualne slave'y Modbus do testów masterów i konfiguracji SCADA:
+// kolejne adresy od pierwszego, wspólny bank rejestrów - holding w SRAM
+// (0x03/0x06/0x10), wejściowe stałe we flash (0x04). Odpowiedź jest
+// nadawana t3.5 po zapytaniu, bajty generowane w trakcie nadawania
+// (FrameSource), więc odczyt całego banku nie wymaga bufora ramki.
+// Mierzony jest czas od końca zapytania do początku odpowiedzi; celem
+// jest najwyżej t3.5 + 1 znak (plus wstrzyknięte opóźnienie).
+// Wstrzykiwane błędy: opóźnienie, wyjątek, brak odpowiedzi, złe CRC.
+class SlaveEmulator : public FrameSource {
+public:
+    static const uint8_t MAX_SLAVES = 16;
+    static const uint8_t HOLDING_COUNT = EMULATOR_HOLDING_REGISTERS;
+    static const uint8_t INPUT_COUNT = 64;
+    static const uint8_t BUSY_EXCEPTION = EmulatorFaults::BUSY_EXCEPTION;
+
+    SlaveEmulator(RtuTransport& transport, Clock& clock, const EmulatorFaults& faults);
+    // Adresy firstAddress..firstAddress+count-1
+    bool start(uint8_t firstAddress, uint8_t count, unsigned long baud);
+    void stop();
+    void update();
+    bool isRunning() const { return _running; }
+    void showSummary() const;
+
+    uint16_t holdingRegister(uint8_t index) const { return _holding[index]; }
+    uint8_t frameByte(uint8_t offset) override;
+
+private:
+    // Etap obsługi zapytania
+    enum class Step : uint8_t {
+        LISTENING,      // Transport czeka na zapytanie
+        DELAYING,       // Wstrzyknięte opóźnienie przed odpowiedzią
+        SENDING         // Odpowiedź w nadajniku
+    };
+
+    RtuTransport& _transport;
+    Clock& _clock;
+    bool _running;
+    Step _step;
+    uint8_t _firstAddress;
+    uint8_t _slaveCount;
+    uint16_t _holding[HOLDING_COUNT];
+
+    // Bieżąca odpowiedź - bajty liczone w frameByte()
+    uint8_t _replyAddress;
+    uint8_t _replyFunction;
+    uint8_t _replyException;        // 0 - zwykła odpowiedź
+    uint8_t _replyStart;
+    uint8_t _replyLength;
+    bool _replyBadCrc;
+    ModbusCRC _replyCrc;
+    uint32_t _requestEndUs;
+
+    const EmulatorFaults& _faults;
+    uint16_t _random;
+
+    uint32_t _requests;             // Zapytania do emulowanych adresów z poprawnym CRC
+    uint32_t _responses;
+    uint16_t _badRequests;          // Błędne CRC lub za długie zapytania do nas
+    uint16_t _exceptions;           // Wyjątki z obsługi (adres, funkcja, wartość)
+    uint16_t _injectedExceptions;
+    uint16_t _injectedCrc;
+    uint16_t _dropped;
+    uint16_t _broadcasts;
+    uint32_t _latencyMinUs;
+    uint32_t _latencyMaxUs;
+    uint32_t _latencySumUs;
+    uint16_t _late;                 // Odpowiedzi później niż cel
+    uint32_t _startMs;
+    uint32_t _elapsedMs;
+
+    void handleRequest();
+    uint8_t execute(const uint8_t* frame, uint8_t length, uint16_t received);
+    void prepareReply(uint8_t address, uint8_t function, uint8_t exception);
+    void recordLatency();
+    uint32_t targetUs() const;
+    bool isEmulated(uint8_t address) const;
+    bool chance(uint8_t percent);
+    uint8_t dataByte(uint8_t offset) const;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Minimalny zamiennik Arduino.h dla środowiska native. Dostarcza tylko
+// typy, stałe i konsolę Serial - czas i GPIO idą przez interfejsy z Hal.h.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PROGMEM
+#define PGM_P const char*
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+// unsigned long ma na hoście 8 bajtów - odczyt pełnego elementu tablicy
+#define pgm_read_dword(addr) (*(addr))
+
+// Brak przerwań na hoście - sekcje krytyczne są puste
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const __FlashStringHelper* str);
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const __FlashStringHelper* str);
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(unsigned char value, int base = DEC);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+
+private:
+    size_t printNumber(unsigned long value, uint8_t base);
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+// Konsola USB: wyjście na stdout, wejście z bufora wypełnianego przez
+// program testowy (feedInput), aby przebieg był powtarzalny
+class NativeConsole : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    int availableForWrite() override { return 64; }
+    operator bool() const { return true; }
+    // Wyłączenie wydruków na czas pomiarów wydajności
+    void setMuted(bool muted) { _muted = muted; }
+    // Wydruki do pliku zamiast stdout (porównanie z wzorcem w replay)
+    void setOutput(FILE* output) { _output = output; }
+    void feedInput(const char* text);
+
+private:
+    static const size_t INPUT_SIZE = 256;
+    bool _muted = false;
+    FILE* _output = stdout;
+    char _input[INPUT_SIZE];
+    size_t _inputHead = 0;
+    size_t _inputTail = 0;
+};
+
+extern NativeConsole Serial;
+
+#endif
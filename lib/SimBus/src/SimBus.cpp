@@ -0,0 +1,284 @@
+#include "SimBus.h"
+#include "ModbusCRC.h"
+#include "RtuTiming.h"
+
+SimBus::SimBus(SimClock& clock, uint32_t seed)
+    : _clock(clock)
+    , _slaveCount(0)
+    , _masterEnabled(false)
+    , _nextPollUs(0)
+    , _pollIndex(0)
+    , _seed(seed)
+    , _requests(0)
+    , _responses(0)
+    , _edgeSink(nullptr)
+    , _noisePercent(0)
+    , _recorder(nullptr)
+    , _replay(nullptr)
+    , _replayPending(false)
+    , _liveFirst(0)
+    , _liveCount(0)
+    , _liveStepUs(0)
+{
+    memset(&_master, 0, sizeof(_master));
+}
+
+bool SimBus::addSlave(const SimSlave& slave) {
+    if (_slaveCount >= MAX_SLAVES) return false;
+    _slaves[_slaveCount++] = slave;
+    return true;
+}
+
+void SimBus::setMaster(const SimMaster& master) {
+    _master = master;
+    _masterEnabled = true;
+    _nextPollUs = _clock.now();
+    _pollIndex = 0;
+}
+
+void SimBus::clearMaster() {
+    _masterEnabled = false;
+}
+
+void SimBus::setReplay(SimTrace* trace) {
+    _replay = trace;
+    _replayPending = trace && trace->read(_replayNext.time, _replayNext.data, _replayNext.status);
+}
+
+uint64_t SimBus::place(uint8_t portId, const uint8_t* data, size_t length,
+                       unsigned long baud, uint64_t startUs) {
+    return schedule(portId, data, length, baud, startUs);
+}
+
+void SimBus::endFrame(const uint8_t* frame, size_t length, unsigned long baud, uint64_t endUs) {
+    deliverRequest(frame, length, baud, endUs);
+}
+
+bool SimBus::receive(uint8_t portId, unsigned long baud, RxEvent& event) {
+    uint64_t now = _clock.now();
+    pumpMaster(now);
+    pumpReplay(now);
+
+    while (!_line.empty()) {
+        std::multimap<uint64_t, LineByte>::iterator it = _line.begin();
+        if (it->first > now) return false;
+
+        LineByte byte = it->second;
+        uint64_t timestamp = it->first;
+        _line.erase(it);
+
+        // Przy RE/DE zwartych port nie słyszy własnego nadawania
+        if (byte.source == portId) continue;
+
+        if (_noisePercent && randomPercent() < _noisePercent) {
+            byte.data ^= (uint8_t)(_seed >> 8) | 0x01;
+            byte.status |= RX_STATUS_FRAMING;
+        }
+        if (_recorder && byte.baud == _recorder->baud()) {
+            _recorder->write(timestamp, byte.data, byte.status);
+        }
+
+        // Inna prędkość nadawcy: przekłamany bajt i zwykle brak bitu stopu
+        event.data = (byte.baud == baud) ? byte.data : (uint8_t)(byte.data ^ 0xA5);
+        event.status = (byte.baud == baud) ? byte.status : RX_STATUS_FRAMING;
+        event.timestamp = (uint32_t)timestamp;
+        return true;
+    }
+    return false;
+}
+
+void SimBus::setLiveRegisters(uint16_t first, uint16_t count, uint32_t stepUs) {
+    _liveFirst = first;
+    _liveCount = count;
+    _liveStepUs = stepUs;
+}
+
+uint16_t SimBus::registerValue(uint8_t address, uint16_t reg) const {
+    uint16_t value = (uint16_t)(address * 1000 + reg);
+    uint16_t index = reg - _liveFirst;
+    if (_liveStepUs && reg >= _liveFirst && index < _liveCount) {
+        value += (uint16_t)(_clock.now() / ((uint64_t)_liveStepUs * (index + 1)));
+    }
+    return value;
+}
+
+uint64_t SimBus::schedule(uint8_t source, const uint8_t* frame, size_t length,
+                          unsigned long baud, uint64_t startUs) {
+    uint32_t charUs = RtuTiming::forBaud(baud).charUs;
+    uint64_t t = startUs;
+    for (size_t i = 0; i < length; i++) {
+        t += charUs;
+        LineByte byte = {frame[i], source, baud, 0};
+        _line.insert(std::make_pair(t, byte));
+        if (_edgeSink) reportPulses(frame[i], baud);
+    }
+    return t;
+}
+
+void SimBus::deliverRequest(const uint8_t* frame, size_t length, unsigned long baud, uint64_t endUs) {
+    if (length < 4 || !ModbusCRC::check(frame, length)) return;
+    _requests++;
+
+    for (uint8_t i = 0; i < _slaveCount; i++) {
+        const SimSlave& slave = _slaves[i];
+        if (slave.address != frame[0] || slave.baud != baud) continue;
+        if (randomPercent() < slave.noResponsePercent) return;
+
+        uint8_t response[MAX_SIM_FRAME];
+        size_t responseLength = buildResponse(slave, frame, length, response);
+        if (responseLength == 0) return;
+
+        if (randomPercent() < slave.crcErrorPercent) {
+            response[responseLength - 1] ^= 0xFF;
+        }
+
+        schedule(SLAVE_SOURCE, response, responseLength, baud, endUs + slave.responseDelayUs);
+        _responses++;
+        return;
+    }
+}
+
+size_t SimBus::buildResponse(const SimSlave& slave, const uint8_t* frame, size_t length, uint8_t* out) {
+    uint8_t function = frame[1];
+    uint16_t reg = (frame[2] << 8) | frame[3];
+    uint16_t count = (frame[4] << 8) | frame[5];
+    size_t n = 0;
+
+    out[n++] = slave.address;
+
+    uint8_t exception = 0;
+    switch (function) {
+        case 0x01:
+        case 0x02:
+            if (length != 8 || count == 0 || count > 2000) {
+                exception = 0x03;
+            } else if ((exception = checkRange(slave, function, reg, count)) == 0) {
+                // Stan bitu: co trzeci adres włączony
+                out[n++] = function;
+                out[n++] = (count + 7) / 8;
+                memset(out + n, 0, (count + 7) / 8);
+                for (uint16_t i = 0; i < count; i++) {
+                    if ((reg + i) % 3 == 0) out[n + i / 8] |= 1 << (i % 8);
+                }
+                n += (count + 7) / 8;
+            }
+            break;
+        case 0x03:
+        case 0x04:
+            if (length != 8 || count == 0 || count > 125) {
+                exception = 0x03;
+            } else if ((exception = checkRange(slave, function, reg, count)) == 0) {
+                out[n++] = function;
+                out[n++] = count * 2;
+                for (uint16_t i = 0; i < count; i++) {
+                    uint16_t value = registerValue(slave.address, reg + i);
+                    out[n++] = value >> 8;
+                    out[n++] = value & 0xFF;
+                }
+            }
+            break;
+        case 0x06:
+            if (length != 8) {
+                exception = 0x03;
+            } else if ((exception = checkRange(slave, 0x03, reg, 1)) == 0) {
+                memcpy(out, frame, 6);
+                n = 6;
+            }
+            break;
+        case 0x10:
+            if (length < 9 || count == 0 || count > 123) {
+                exception = 0x03;
+            } else if ((exception = checkRange(slave, 0x03, reg, count)) == 0) {
+                memcpy(out, frame, 6);
+                n = 6;
+            }
+            break;
+        default:
+            exception = 0x01;
+            break;
+    }
+
+    if (exception) {
+        n = 1;
+        out[n++] = function | 0x80;
+        out[n++] = exception;
+    }
+
+    ModbusCRC::append(out, n);
+    return n + 2;
+}
+
+// Kod wyjątku dla odczytu/zapisu zakresu, 0 gdy adresy istnieją
+uint8_t SimBus::checkRange(const SimSlave& slave, uint8_t function, uint16_t reg, uint16_t count) {
+    uint32_t end = (uint32_t)reg + count;
+    if (!slave.tables) {
+        if (function <= 0x02) return 0x01;
+        return end > slave.registerCount ? 0x02 : 0;
+    }
+    bool supported = false;
+    for (uint8_t i = 0; i < slave.tableCount; i++) {
+        const SimTable& table = slave.tables[i];
+        if (table.function != function) continue;
+        supported = true;
+        if (reg >= table.first && end <= (uint32_t)table.first + table.count) return 0;
+    }
+    return supported ? 0x02 : 0x01;
+}
+
+void SimBus::pumpMaster(uint64_t until) {
+    if (!_masterEnabled || _slaveCount == 0) return;
+
+    while (_nextPollUs <= until) {
+        const SimSlave& slave = _slaves[_pollIndex];
+        _pollIndex = (_pollIndex + 1) % _slaveCount;
+
+        uint8_t request[MAX_SIM_FRAME] = {
+            slave.address, _master.function,
+            (uint8_t)(_master.startRegister >> 8), (uint8_t)(_master.startRegister & 0xFF),
+            (uint8_t)(_master.registerCount >> 8), (uint8_t)(_master.registerCount & 0xFF)
+        };
+        size_t length = 6;
+        // 0x10: liczba bajtów i wartości rejestrów (kolejne liczby)
+        if (_master.function == 0x10) {
+            request[length++] = _master.registerCount * 2;
+            for (uint16_t i = 0; i < _master.registerCount; i++) {
+                request[length++] = 0;
+                request[length++] = i & 0xFF;
+            }
+        }
+        ModbusCRC::append(request, length);
+        length += 2;
+
+        uint64_t endUs = schedule(MASTER_SOURCE, request, length, _master.baud, _nextPollUs);
+        deliverRequest(request, length, _master.baud, endUs);
+        _nextPollUs += _master.pollIntervalUs;
+    }
+}
+
+void SimBus::pumpReplay(uint64_t until) {
+    while (_replayPending && _replayNext.time <= until) {
+        LineByte byte = {_replayNext.data, REPLAY_SOURCE, _replay->baud(), _replayNext.status};
+        _line.insert(std::make_pair(_replayNext.time, byte));
+        if (_edgeSink) reportPulses(byte.data, byte.baud);
+        _replayPending = _replay->read(_replayNext.time, _replayNext.data, _replayNext.status);
+    }
+}
+
+void SimBus::reportPulses(uint8_t data, unsigned long baud) {
+    // Znak 8N1: start (0), 8 bitów danych od LSB, stop (1)
+    uint16_t bits = (1u << 9) | ((uint16_t)data << 1);
+    uint16_t bitTicks = AUTOBAUD_TICK_HZ / baud;
+    uint8_t runStart = 0;
+    for (uint8_t i = 1; i < 10; i++) {
+        if (((bits >> i) & 1) != ((bits >> runStart) & 1)) {
+            _edgeSink->recordPulse((i - runStart) * bitTicks);
+            runStart = i;
+        }
+    }
+}
+
+uint8_t SimBus::randomPercent() {
+    // LCG z Numerical Recipes - deterministyczny przebieg dla danego ziarna
+    _seed = _seed * 1664525UL + 1013904223UL;
+    return (uint8_t)((_seed >> 16) % 100);
+}
@@ -0,0 +1,129 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+#include <map>
+#include "Hal.h"
+#include "SimClock.h"
+#include "AutoBaud.h"
+#include "SimTrace.h"
+
+static const size_t MAX_SIM_FRAME = 256;
+
+// Zakres adresów jednej tablicy slave'a (funkcja odczytu 0x01-0x04)
+struct SimTable {
+    uint8_t function;
+    uint16_t first;
+    uint16_t count;
+};
+
+// Wirtualny slave odpowiadający na 0x03/0x04/0x06/0x10, a z mapą tablic
+// także na 0x01/0x02
+struct SimSlave {
+    uint8_t address;
+    unsigned long baud;
+    uint32_t responseDelayUs;       // Od końca zapytania do pierwszego bajtu
+    uint8_t crcErrorPercent;        // Odpowiedzi z uszkodzonym CRC
+    uint8_t noResponsePercent;      // Zgubione odpowiedzi
+    uint16_t registerCount;         // Poza zakresem wyjątek 0x02 (bez mapy)
+    // Mapa tablic zamiast registerCount: odczyt musi mieścić się w jednym
+    // zakresie, funkcja bez zakresów - wyjątek 0x01
+    const SimTable* tables;
+    uint8_t tableCount;
+};
+
+// Wirtualny master odpytujący po kolei wszystkie slave'y (do nasłuchu)
+struct SimMaster {
+    unsigned long baud;
+    uint32_t pollIntervalUs;
+    uint8_t function;
+    uint16_t startRegister;
+    uint16_t registerCount;
+};
+
+// Symulowana magistrala RS485. Bajty są umieszczane na linii z czasem
+// końca znaku wyliczonym z prędkości nadawcy; port o innej prędkości
+// odbiera je przekłamane.
+class SimBus {
+public:
+    static const uint8_t MAX_SLAVES = 32;
+    static const uint8_t MASTER_SOURCE = 0xFE;
+    static const uint8_t SLAVE_SOURCE = 0xFD;
+    static const uint8_t REPLAY_SOURCE = 0xFC;
+
+    SimBus(SimClock& clock, uint32_t seed = 1);
+
+    bool addSlave(const SimSlave& slave);
+    void setMaster(const SimMaster& master);
+    void clearMaster();
+    // Odbiorca szerokości impulsów linii (symulacja INT2 + Timer3)
+    void setEdgeSink(AutoBaud* sink) { _edgeSink = sink; }
+    // Zakłócenia: odsetek bajtów przekłamanych z błędem ramki (FE)
+    void setNoise(uint8_t percent) { _noisePercent = percent; }
+    // Zapis odebranych bajtów o prędkości pliku (z zakłóceniami) do trace
+    void setRecorder(SimTrace* trace) { _recorder = trace; }
+    // Odtwarzanie: bajty z pliku trafiają na linię w swoich chwilach
+    void setReplay(SimTrace* trace);
+    // Czas następnego bajtu z pliku, UINT64_MAX po końcu pliku
+    uint64_t nextReplayUs() const { return _replayPending ? _replayNext.time : UINT64_MAX; }
+
+    // Nadawanie po kawałku: bajty trafiają na linię od razu (zwraca czas
+    // końca), slave'y widzą zapytanie dopiero po endFrame() - po ciszy
+    uint64_t place(uint8_t portId, const uint8_t* data, size_t length,
+                   unsigned long baud, uint64_t startUs);
+    void endFrame(const uint8_t* frame, size_t length, unsigned long baud, uint64_t endUs);
+    bool receive(uint8_t portId, unsigned long baud, RxEvent& event);
+
+    // Rejestry zmieniające się w czasie (obserwacja): rejestr first + i
+    // rośnie o 1 co stepUs * (i + 1), pozostałe są stałe
+    void setLiveRegisters(uint16_t first, uint16_t count, uint32_t stepUs);
+    uint16_t registerValue(uint8_t address, uint16_t reg) const;
+    uint32_t requestCount() const { return _requests; }
+    uint32_t responseCount() const { return _responses; }
+
+private:
+    struct LineByte {
+        uint8_t data;
+        uint8_t source;
+        unsigned long baud;
+        uint8_t status;             // RX_STATUS_* z pliku replay
+    };
+
+    struct ReplayByte {
+        uint64_t time;
+        uint8_t data;
+        uint8_t status;
+    };
+
+    SimClock& _clock;
+    SimSlave _slaves[MAX_SLAVES];
+    uint8_t _slaveCount;
+    SimMaster _master;
+    bool _masterEnabled;
+    uint64_t _nextPollUs;
+    uint8_t _pollIndex;
+    uint32_t _seed;
+    uint32_t _requests;
+    uint32_t _responses;
+    std::multimap<uint64_t, LineByte> _line;
+    AutoBaud* _edgeSink;
+    uint8_t _noisePercent;
+    SimTrace* _recorder;
+    SimTrace* _replay;
+    ReplayByte _replayNext;
+    bool _replayPending;
+    uint16_t _liveFirst;
+    uint16_t _liveCount;
+    uint32_t _liveStepUs;
+
+    uint64_t schedule(uint8_t source, const uint8_t* frame, size_t length,
+                      unsigned long baud, uint64_t startUs);
+    void deliverRequest(const uint8_t* frame, size_t length, unsigned long baud, uint64_t endUs);
+    size_t buildResponse(const SimSlave& slave, const uint8_t* frame, size_t length, uint8_t* out);
+    static uint8_t checkRange(const SimSlave& slave, uint8_t function, uint16_t reg, uint16_t count);
+    void pumpMaster(uint64_t until);
+    void pumpReplay(uint64_t until);
+    void reportPulses(uint8_t data, unsigned long baud);
+    uint8_t randomPercent();
+};
+
+#endif
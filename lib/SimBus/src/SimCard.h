@@ -0,0 +1,104 @@
+#ifndef SIM_CARD_H
+#define SIM_CARD_H
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include "Hal.h"
+#include "SimClock.h"
+
+// Karta SD jako plik obrazu (bez ścieżki - nieaktywna). startWrite()
+// przydziela obszar z góry (posix_fallocate - ciągłe miejsce, plik nie
+// rośnie w trakcie zapisu).
+// Po każdym bloku karta jest zajęta przez blockUs czasu wirtualnego,
+// a co STALL_INTERVAL bloków dłużej (stallUs) - jak przy kasowaniu
+// bloku wymazywania w prawdziwej karcie.
+// busy() w trakcie bloku jest liczone jako błąd - prawdziwa karta SPI
+// dostałaby wtedy bajt zegarujący jako dane.
+class SimCard : public BlockDevice {
+public:
+    static const uint32_t STALL_INTERVAL = 128;     // Bloki na jednostkę wymazywania
+
+    SimCard(SimClock& clock, const char* path, uint32_t blocks, uint32_t blockUs, uint32_t stallUs)
+        : _clock(clock), _file(nullptr), _blocks(blocks), _blockUs(blockUs), _stallUs(stallUs),
+          _busyUntil(0), _offset(0), _writing(false), _written(0), _midBlockBusy(0) {
+        if (!path) return;
+        _file = fopen(path, "r+b");
+        if (!_file) _file = fopen(path, "w+b");
+    }
+
+    ~SimCard() {
+        if (_file) fclose(_file);
+    }
+
+    bool isOpen() const { return _file != nullptr; }
+    uint32_t blockCount() override { return _blocks; }
+
+    bool startWrite(uint32_t block, uint32_t count) override {
+        if (!_file || _writing || block >= _blocks) return false;
+        if (count && posix_fallocate(fileno(_file), (off_t)block * BLOCK_SIZE,
+                                     (off_t)count * BLOCK_SIZE) != 0) {
+            return false;
+        }
+        fseek(_file, (long)block * BLOCK_SIZE, SEEK_SET);
+        _offset = 0;
+        _writing = true;
+        return true;
+    }
+
+    bool writeData(const uint8_t* data, uint16_t length) override {
+        if (!_writing || _clock.now() < _busyUntil || _offset + length > BLOCK_SIZE) return false;
+        memcpy(_block + _offset, data, length);
+        _offset += length;
+        if (_offset < BLOCK_SIZE) return true;
+
+        _offset = 0;
+        if (fwrite(_block, 1, BLOCK_SIZE, _file) != BLOCK_SIZE) return false;
+        _written++;
+        _busyUntil = _clock.now() + (_written % STALL_INTERVAL ? _blockUs : _stallUs);
+        return true;
+    }
+
+    bool busy() override {
+        if (_offset != 0) {
+            _midBlockBusy++;
+            return false;
+        }
+        return _clock.now() < _busyUntil;
+    }
+
+    bool stopWrite() override {
+        if (!_writing) return false;
+        _writing = false;
+        return _offset == 0 && fflush(_file) == 0;
+    }
+
+    bool readData(uint32_t block, uint16_t offset, uint8_t* data, uint16_t length) override {
+        if (!_file || _writing || block >= _blocks || offset + length > BLOCK_SIZE) return false;
+        // Za końcem pliku obraz jest pusty
+        size_t count = 0;
+        if (fseek(_file, (long)block * BLOCK_SIZE + offset, SEEK_SET) == 0) {
+            count = fread(data, 1, length, _file);
+        }
+        memset(data + count, 0, length - count);
+        return true;
+    }
+
+    uint32_t blocksWritten() const { return _written; }
+    uint32_t midBlockBusyCalls() const { return _midBlockBusy; }
+
+private:
+    SimClock& _clock;
+    FILE* _file;
+    uint32_t _blocks;
+    uint32_t _blockUs;
+    uint32_t _stallUs;
+    uint64_t _busyUntil;
+    uint8_t _block[BLOCK_SIZE];
+    uint16_t _offset;
+    bool _writing;
+    uint32_t _written;
+    uint32_t _midBlockBusy;
+};
+
+#endif
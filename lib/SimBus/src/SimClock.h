@@ -0,0 +1,35 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include "Hal.h"
+
+// Wirtualny zegar. Każdy odczyt czasu przesuwa go o _stepUs, co odwzorowuje
+// koszt wykonania kodu i pozwala pętlom aktywnego czekania dobiec końca.
+class SimClock : public Clock {
+public:
+    explicit SimClock(uint32_t stepUs = 2) : _nowUs(0), _stepUs(stepUs) {}
+
+    uint32_t millis() override {
+        _nowUs += _stepUs;
+        return (uint32_t)(_nowUs / 1000);
+    }
+
+    uint32_t micros() override {
+        _nowUs += _stepUs;
+        return (uint32_t)_nowUs;
+    }
+
+    void delay(uint32_t ms) override { _nowUs += (uint64_t)ms * 1000; }
+    void delayMicroseconds(uint32_t us) override { _nowUs += us; }
+
+    uint64_t now() const { return _nowUs; }
+    void advanceTo(uint64_t us) { if (us > _nowUs) _nowUs = us; }
+    void advance(uint64_t us) { _nowUs += us; }
+    void setStep(uint32_t stepUs) { _stepUs = stepUs; }
+
+private:
+    uint64_t _nowUs;
+    uint32_t _stepUs;
+};
+
+#endif
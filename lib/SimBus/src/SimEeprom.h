@@ -0,0 +1,54 @@
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <stdio.h>
+#include "Hal.h"
+
+// EEPROM w pamięci (1 KB jak ATmega32U4, wymazana = 0xFF). Z podaną
+// ścieżką zawartość jest wczytywana z pliku i zapisywana przy zmianie,
+// co pozwala sprawdzić ponowne skanowanie między uruchomieniami.
+class SimEeprom : public Storage {
+public:
+    static const uint16_t SIZE = 1024;
+
+    explicit SimEeprom(const char* path = nullptr) : _path(path), _writes(0) {
+        for (uint16_t i = 0; i < SIZE; i++) _data[i] = 0xFF;
+        if (!_path) return;
+        FILE* file = fopen(_path, "rb");
+        if (!file) return;
+        size_t n = fread(_data, 1, SIZE, file);
+        (void)n;
+        fclose(file);
+    }
+
+    uint16_t length() override { return SIZE; }
+
+    uint8_t read(uint16_t address) override {
+        return address < SIZE ? _data[address] : 0xFF;
+    }
+
+    void update(uint16_t address, uint8_t value) override {
+        if (address >= SIZE || _data[address] == value) return;
+        _data[address] = value;
+        _writes++;
+        save();
+    }
+
+    // Liczba faktycznie zapisanych bajtów (zużycie komórek)
+    uint32_t writeCount() const { return _writes; }
+
+private:
+    const char* _path;
+    uint8_t _data[SIZE];
+    uint32_t _writes;
+
+    void save() {
+        if (!_path) return;
+        FILE* file = fopen(_path, "wb");
+        if (!file) return;
+        fwrite(_data, 1, SIZE, file);
+        fclose(file);
+    }
+};
+
+#endif
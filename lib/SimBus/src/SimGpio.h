@@ -0,0 +1,39 @@
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+
+#include "Hal.h"
+
+// Stan pinów w pamięci; przyciski ustawia program symulacji
+class SimGpio : public Gpio {
+public:
+    static const uint8_t PIN_COUNT = 32;
+
+    SimGpio() {
+        for (uint8_t i = 0; i < PIN_COUNT; i++) {
+            _modes[i] = INPUT;
+            _values[i] = LOW;
+        }
+    }
+
+    void pinMode(uint8_t pin, uint8_t mode) override {
+        if (pin >= PIN_COUNT) return;
+        _modes[pin] = mode;
+        if (mode == INPUT_PULLUP) _values[pin] = HIGH;
+    }
+
+    void digitalWrite(uint8_t pin, uint8_t value) override {
+        if (pin < PIN_COUNT) _values[pin] = value;
+    }
+
+    int digitalRead(uint8_t pin) override {
+        return pin < PIN_COUNT ? _values[pin] : LOW;
+    }
+
+    void setInput(uint8_t pin, uint8_t value) { digitalWrite(pin, value); }
+
+private:
+    uint8_t _modes[PIN_COUNT];
+    uint8_t _values[PIN_COUNT];
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "SimSerial.h"
+
+SimSerial::SimSerial(SimBus& bus, SimClock& clock, uint8_t portId)
+    : _bus(bus)
+    , _clock(clock)
+    , _portId(portId)
+    , _baud(9600)
+    , _open(false)
+    , _txEndUs(0)
+    , _bytesWritten(0)
+    , _txFrameLength(0)
+{
+}
+
+void SimSerial::begin(unsigned long baud) {
+    // Bajty nadane przed włączeniem odbiornika przepadają, jak w USART
+    _open = false;
+    pull();
+    _rx.clear();
+    _baud = baud;
+    _open = true;
+}
+
+void SimSerial::end() {
+    flush();
+    _open = false;
+    _rx.clear();
+}
+
+int SimSerial::available() {
+    pull();
+    return (int)_rx.size();
+}
+
+int SimSerial::read() {
+    RxEvent event;
+    if (!readEvent(event)) return -1;
+    return event.data;
+}
+
+bool SimSerial::readEvent(RxEvent& event) {
+    pull();
+    if (_rx.empty()) return false;
+    event = _rx.front();
+    _rx.pop_front();
+    return true;
+}
+
+size_t SimSerial::write(const uint8_t* data, size_t length) {
+    if (!_open || length == 0) return 0;
+    // Przerwa w nadawaniu kończy poprzednią ramkę
+    if (_clock.now() > _txEndUs) closeFrame();
+    uint64_t start = _clock.now() > _txEndUs ? _clock.now() : _txEndUs;
+    _txEndUs = _bus.place(_portId, data, length, _baud, start);
+    for (size_t i = 0; i < length && _txFrameLength < MAX_SIM_FRAME; i++) {
+        _txFrame[_txFrameLength++] = data[i];
+    }
+    _bytesWritten += length;
+    return length;
+}
+
+void SimSerial::flush() {
+    _clock.advanceTo(_txEndUs);
+    closeFrame();
+}
+
+bool SimSerial::txComplete() {
+    if (_clock.now() < _txEndUs) return false;
+    closeFrame();
+    return true;
+}
+
+void SimSerial::closeFrame() {
+    if (_txFrameLength == 0) return;
+    _bus.endFrame(_txFrame, _txFrameLength, _baud, _txEndUs);
+    _txFrameLength = 0;
+}
+
+void SimSerial::pull() {
+    if (_clock.now() >= _txEndUs) closeFrame();
+    RxEvent event;
+    while (_bus.receive(_portId, _baud, event)) {
+        if (_open) _rx.push_back(event);
+    }
+}
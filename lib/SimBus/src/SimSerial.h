@@ -0,0 +1,44 @@
+#ifndef SIM_SERIAL_H
+#define SIM_SERIAL_H
+
+#include <deque>
+#include "Hal.h"
+#include "SimBus.h"
+#include "SimClock.h"
+
+// Port szeregowy podłączony do symulowanej magistrali
+class SimSerial : public SerialPort {
+public:
+    SimSerial(SimBus& bus, SimClock& clock, uint8_t portId = 1);
+
+    void begin(unsigned long baud) override;
+    void end() override;
+    int available() override;
+    int read() override;
+    bool readEvent(RxEvent& event) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+    bool txReady() override { return true; }
+    bool txComplete() override;
+    uint32_t overflowCount() const override { return 0; }
+
+    unsigned long baud() const { return _baud; }
+    uint32_t bytesWritten() const { return _bytesWritten; }
+
+private:
+    SimBus& _bus;
+    SimClock& _clock;
+    uint8_t _portId;
+    unsigned long _baud;
+    bool _open;
+    uint64_t _txEndUs;
+    uint32_t _bytesWritten;
+    std::deque<RxEvent> _rx;
+    uint8_t _txFrame[MAX_SIM_FRAME];    // Bajty bieżącej ramki (bez przerwy)
+    size_t _txFrameLength;
+
+    void pull();
+    void closeFrame();
+};
+
+#endif
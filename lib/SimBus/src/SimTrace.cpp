@@ -0,0 +1,81 @@
+#include "SimTrace.h"
+#include <string.h>
+
+static const char TRACE_MAGIC[4] = {'M', 'B', 'T', 'R'};
+
+static void putLe32(uint8_t* out, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) out[i] = value >> (8 * i);
+}
+
+static uint32_t getLe32(const uint8_t* in) {
+    return in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+SimTrace::SimTrace()
+    : _file(nullptr)
+    , _baud(0)
+    , _entries(0)
+    , _lastTimestamp(0)
+    , _wraps(0)
+{
+}
+
+SimTrace::~SimTrace() {
+    close();
+}
+
+bool SimTrace::create(const char* path, unsigned long baud) {
+    close();
+    _file = fopen(path, "wb");
+    if (!_file) return false;
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, TRACE_MAGIC, 4);
+    putLe32(header + 4, baud);
+    fwrite(header, 1, HEADER_SIZE, _file);
+    _baud = baud;
+    return true;
+}
+
+bool SimTrace::open(const char* path) {
+    close();
+    _file = fopen(path, "rb");
+    if (!_file) return false;
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, _file) != HEADER_SIZE || memcmp(header, TRACE_MAGIC, 4) != 0) {
+        close();
+        return false;
+    }
+    _baud = getLe32(header + 4);
+    return _baud != 0;
+}
+
+void SimTrace::close() {
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _entries = 0;
+    _lastTimestamp = 0;
+    _wraps = 0;
+}
+
+void SimTrace::write(uint64_t timestamp, uint8_t data, uint8_t status) {
+    if (!_file) return;
+    uint8_t entry[ENTRY_SIZE];
+    putLe32(entry, (uint32_t)timestamp);
+    entry[4] = data;
+    entry[5] = status;
+    fwrite(entry, 1, ENTRY_SIZE, _file);
+    _entries++;
+}
+
+bool SimTrace::read(uint64_t& timestamp, uint8_t& data, uint8_t& status) {
+    uint8_t entry[ENTRY_SIZE];
+    if (!_file || fread(entry, 1, ENTRY_SIZE, _file) != ENTRY_SIZE) return false;
+    uint32_t raw = getLe32(entry);
+    if (_entries > 0 && raw < _lastTimestamp) _wraps++;
+    _lastTimestamp = raw;
+    timestamp = (_wraps << 32) | raw;
+    data = entry[4];
+    status = entry[5];
+    _entries++;
+    return true;
+}
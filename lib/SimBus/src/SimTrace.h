@@ -0,0 +1,38 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <stdio.h>
+#include "Hal.h"
+
+// Zapis bajtów z linii do pliku i ich odtwarzanie przez SimBus (replay).
+// Plik (little-endian):
+//   "MBTR" | prędkość u32 | rekordy: czas końca znaku us u32 | bajt | status
+// Status to RX_STATUS_* odbiornika. Czas 32-bitowy jak micros() - przy
+// odczycie przekręcenie licznika jest rozwijane do 64 bitów.
+class SimTrace {
+public:
+    static const uint8_t HEADER_SIZE = 8;
+    static const uint8_t ENTRY_SIZE = 6;
+
+    SimTrace();
+    ~SimTrace();
+
+    bool create(const char* path, unsigned long baud);
+    bool open(const char* path);
+    void close();
+
+    void write(uint64_t timestamp, uint8_t data, uint8_t status);
+    bool read(uint64_t& timestamp, uint8_t& data, uint8_t& status);
+
+    unsigned long baud() const { return _baud; }
+    uint32_t entryCount() const { return _entries; }
+
+private:
+    FILE* _file;
+    unsigned long _baud;
+    uint32_t _entries;
+    uint32_t _lastTimestamp;
+    uint64_t _wraps;                // Przekręcenia licznika przy odczycie
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "ArduinoHal.h"
+#include <EEPROM.h>
+
+uint32_t ArduinoClock::millis() {
+    return ::millis();
+}
+
+uint32_t ArduinoClock::micros() {
+    return ::micros();
+}
+
+void ArduinoClock::delay(uint32_t ms) {
+    ::delay(ms);
+}
+
+void ArduinoClock::delayMicroseconds(uint32_t us) {
+    ::delayMicroseconds(us);
+}
+
+void ArduinoGpio::pinMode(uint8_t pin, uint8_t mode) {
+    ::pinMode(pin, mode);
+}
+
+void ArduinoGpio::digitalWrite(uint8_t pin, uint8_t value) {
+    ::digitalWrite(pin, value);
+}
+
+int ArduinoGpio::digitalRead(uint8_t pin) {
+    return ::digitalRead(pin);
+}
+
+uint16_t ArduinoEeprom::length() {
+    return EEPROM.length();
+}
+
+uint8_t ArduinoEeprom::read(uint16_t address) {
+    return EEPROM.read(address);
+}
+
+void ArduinoEeprom::update(uint16_t address, uint8_t value) {
+    EEPROM.update(address, value);
+}
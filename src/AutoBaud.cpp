@@ -0,0 +1,124 @@
+#include "AutoBaud.h"
+
+const unsigned long AutoBaud::STANDARD_RATES[] PROGMEM = {
+    1200, 2400, 4800, 9600, 14400, 19200, 38400, 57600, 115200, 230400
+};
+const uint8_t AutoBaud::STANDARD_COUNT = sizeof(STANDARD_RATES) / sizeof(STANDARD_RATES[0]);
+
+#if defined(__AVR_ATmega32U4__)
+static AutoBaud* activeAutoBaud = nullptr;
+static uint16_t lastEdgeTicks = 0;
+static uint8_t savedTccr3a = 0;
+static uint8_t savedTccr3b = 0;
+
+ISR(INT2_vect) {
+    uint16_t now = TCNT3;
+    // Przepełnienie od ostatniego zbocza = impuls dłuższy niż 4 ms
+    bool overflow = TIFR3 & _BV(TOV3);
+    if (overflow) TIFR3 = _BV(TOV3);
+    uint16_t pulse = now - lastEdgeTicks;
+    lastEdgeTicks = now;
+    if (!overflow && activeAutoBaud) {
+        activeAutoBaud->recordPulse(pulse);
+    }
+}
+#endif
+
+AutoBaud::AutoBaud()
+    : _active(false)
+{
+    reset();
+}
+
+void AutoBaud::begin() {
+    noInterrupts();
+    reset();
+    _active = true;
+#if defined(__AVR_ATmega32U4__)
+    savedTccr3a = TCCR3A;
+    savedTccr3b = TCCR3B;
+    TCCR3A = 0;
+    TCCR3B = _BV(CS30);                     // Tryb normalny, clk/1
+    TIFR3 = _BV(TOV3);
+    lastEdgeTicks = TCNT3;
+    EICRA = (EICRA & ~(_BV(ISC21) | _BV(ISC20))) | _BV(ISC20);  // Każde zbocze
+    EIFR = _BV(INTF2);
+    EIMSK |= _BV(INT2);
+    activeAutoBaud = this;
+#endif
+    interrupts();
+}
+
+void AutoBaud::end() {
+    noInterrupts();
+    _active = false;
+#if defined(__AVR_ATmega32U4__)
+    EIMSK &= ~_BV(INT2);
+    TCCR3A = savedTccr3a;
+    TCCR3B = savedTccr3b;
+    activeAutoBaud = nullptr;
+#endif
+    interrupts();
+}
+
+void AutoBaud::reset() {
+    _edges = 0;
+    _minTicks = 0;
+    _sumTicks = 0;
+    _bitPulses = 0;
+}
+
+void AutoBaud::recordPulse(uint16_t ticks) {
+    if (!_active || ticks < MIN_PULSE_TICKS) return;
+    if (_edges < UINT16_MAX) _edges++;
+
+    uint16_t margin = _minTicks / 8;
+    if (_minTicks == 0 || ticks < _minTicks - margin) {
+        _minTicks = ticks;
+        _sumTicks = ticks;
+        _bitPulses = 1;
+    } else if (ticks <= _minTicks + margin) {
+        _sumTicks += ticks;
+        if (_bitPulses < UINT8_MAX) _bitPulses++;
+    }
+}
+
+bool AutoBaud::ready() const {
+    noInterrupts();
+    bool result = _edges >= MIN_EDGES && _bitPulses >= MIN_BIT_PULSES;
+    interrupts();
+    return result;
+}
+
+uint16_t AutoBaud::edgeCount() const {
+    noInterrupts();
+    uint16_t edges = _edges;
+    interrupts();
+    return edges;
+}
+
+unsigned long AutoBaud::measuredBaud() const {
+    noInterrupts();
+    uint32_t sum = _sumTicks;
+    uint8_t count = _bitPulses;
+    interrupts();
+
+    if (sum == 0) return 0;
+    // baud = TICK_HZ / (sum / count), zaokrąglone
+    return ((uint32_t)AUTOBAUD_TICK_HZ * count + sum / 2) / sum;
+}
+
+unsigned long AutoBaud::estimateBaud() const {
+    unsigned long measured = measuredBaud();
+    if (measured == 0) return 0;
+
+    for (uint8_t i = 0; i < STANDARD_COUNT; i++) {
+        unsigned long rate = pgm_read_dword(&STANDARD_RATES[i]);
+        unsigned long diff = measured > rate ? measured - rate : rate - measured;
+        if (diff * 100 <= rate * TOLERANCE_PERCENT) {
+            return rate;
+        }
+    }
+    // Prędkość niestandardowa - Rs485Uart::begin() dobierze UBRR
+    return measured;
+}
@@ -0,0 +1,150 @@
+#include "BusLoad.h"
+
+// 1.5, 3.5, 5, 10, 20, 50, 100 i 1000 znaków
+const uint16_t BusLoad::GAP_LIMITS[GAP_BUCKETS - 1] PROGMEM = {3, 7, 10, 20, 40, 100, 200, 2000};
+
+BusLoad::BusLoad(const RtuTiming& timing)
+    : _timing(timing)
+{
+    reset(0);
+}
+
+void BusLoad::reset(uint32_t now) {
+    _slotStartUs = now;
+    memset(_shortSlots, 0, sizeof(_shortSlots));
+    memset(_longSlots, 0, sizeof(_longSlots));
+    memset(_gaps, 0, sizeof(_gaps));
+    _shortIndex = 0;
+    _longIndex = 0;
+    _shortBytes = 0;
+    _longBytes = 0;
+    _lastShortBytes = 0;
+    _lastLongBytes = 0;
+    _slotCount = 0;
+    _peakShortBytes = 0;
+    _peakLongBytes = 0;
+    _totalBytes = 0;
+}
+
+void BusLoad::onByte(uint32_t timestamp) {
+    advance(timestamp);
+    if (_shortSlots[_shortIndex] < UINT16_MAX) _shortSlots[_shortIndex]++;
+    _shortBytes++;
+    _totalBytes++;
+}
+
+void BusLoad::onFrameGap(uint32_t idleUs) {
+    uint32_t halfChars = idleUs * 2 / _timing.charUs;
+    uint8_t bucket = 0;
+    while (bucket < GAP_BUCKETS - 1 && halfChars >= pgm_read_word(&GAP_LIMITS[bucket])) bucket++;
+    if (_gaps[bucket] < UINT16_MAX) _gaps[bucket]++;
+}
+
+void BusLoad::advance(uint32_t now) {
+    // Znacznik z przerwania bywa późniejszy niż odczyt micros() w pętli
+    if ((int32_t)(now - _slotStartUs) < (int32_t)SLOT_US) return;
+
+    // Po długiej ciszy oba okna są puste - bez przechodzenia po przedziałach
+    uint32_t elapsed = (now - _slotStartUs) / SLOT_US;
+    if (elapsed > (uint32_t)SLOTS * SLOTS) {
+        closeSlot();
+        memset(_shortSlots, 0, sizeof(_shortSlots));
+        memset(_longSlots, 0, sizeof(_longSlots));
+        _shortBytes = 0;
+        _longBytes = 0;
+        _lastShortBytes = 0;
+        _lastLongBytes = 0;
+        _slotCount += elapsed - 1;
+        _slotStartUs += elapsed * SLOT_US;
+        return;
+    }
+    while (elapsed--) {
+        closeSlot();
+        _slotStartUs += SLOT_US;
+    }
+}
+
+void BusLoad::closeSlot() {
+    _slotCount++;
+    // Pełna sekunda: suma okna 1 s to dokładnie ruch tej sekundy
+    if (_slotCount % SLOTS == 0) closeLongSlot();
+    if (_slotCount >= SLOTS) {
+        _lastShortBytes = _shortBytes;
+        if (_shortBytes > _peakShortBytes) _peakShortBytes = _shortBytes;
+    }
+
+    _shortIndex = (_shortIndex + 1) % SLOTS;
+    _shortBytes -= _shortSlots[_shortIndex];
+    _shortSlots[_shortIndex] = 0;
+}
+
+void BusLoad::closeLongSlot() {
+    _longSlots[_longIndex] = _shortBytes > UINT16_MAX ? UINT16_MAX : _shortBytes;
+    _longBytes += _longSlots[_longIndex];
+    if (_slotCount >= (uint32_t)SLOTS * SLOTS) {
+        _lastLongBytes = _longBytes;
+        if (_longBytes > _peakLongBytes) _peakLongBytes = _longBytes;
+    }
+
+    _longIndex = (_longIndex + 1) % SLOTS;
+    _longBytes -= _longSlots[_longIndex];
+    _longSlots[_longIndex] = 0;
+}
+
+uint8_t BusLoad::percentOf(uint32_t bytes, uint32_t windowMs) const {
+    if (windowMs == 0) return 0;
+    uint32_t percent = (uint32_t)((uint64_t)bytes * _timing.charUs / (windowMs * 10UL));
+    return percent > 100 ? 100 : percent;
+}
+
+void BusLoad::printWindow(const __FlashStringHelper* label, uint32_t bytes, uint32_t windowMs) const {
+    Serial.print(label);
+    if (windowMs == 0) {
+        Serial.println(F("-"));
+        return;
+    }
+    Serial.print((uint32_t)((uint64_t)bytes * 1000 / windowMs));
+    Serial.print(F(" B/s ("));
+    Serial.print(percentOf(bytes, windowMs));
+    Serial.println(F("%)"));
+}
+
+void BusLoad::printHalfChars(uint16_t halfChars) {
+    Serial.print(halfChars / 2);
+    if (halfChars & 1) Serial.print(F(".5"));
+}
+
+void BusLoad::print() const {
+    const uint32_t shortMs = SLOTS * SLOT_US / 1000;
+    const uint32_t longMs = shortMs * SLOTS;
+    bool shortReady = _slotCount >= SLOTS;
+    bool longReady = _slotCount >= (uint32_t)SLOTS * SLOTS;
+
+    Serial.println(F("\nObciazenie magistrali:"));
+    Serial.print(F("Przepustowosc: "));
+    Serial.print(1000000UL / _timing.charUs);
+    Serial.println(F(" B/s"));
+    printWindow(F("Srednio: "), _totalBytes, _slotCount * (SLOT_US / 1000));
+    printWindow(F("Ostatnia 1 s: "), _lastShortBytes, shortReady ? shortMs : 0);
+    printWindow(F("Ostatnie 10 s: "), _lastLongBytes, longReady ? longMs : 0);
+    printWindow(F("Szczyt 1 s: "), _peakShortBytes, shortReady ? shortMs : 0);
+    printWindow(F("Szczyt 10 s: "), _peakLongBytes, longReady ? longMs : 0);
+
+    Serial.println(F("Przerwy miedzy ramkami [znaki]:"));
+    for (uint8_t i = 0; i < GAP_BUCKETS; i++) {
+        Serial.print(F("  "));
+        if (i == 0) {
+            Serial.print('<');
+            printHalfChars(pgm_read_word(&GAP_LIMITS[0]));
+        } else if (i == GAP_BUCKETS - 1) {
+            Serial.print(F(">="));
+            printHalfChars(pgm_read_word(&GAP_LIMITS[i - 1]));
+        } else {
+            printHalfChars(pgm_read_word(&GAP_LIMITS[i - 1]));
+            Serial.print('-');
+            printHalfChars(pgm_read_word(&GAP_LIMITS[i]));
+        }
+        Serial.print(F("\t"));
+        Serial.println(_gaps[i]);
+    }
+}
@@ -0,0 +1,34 @@
+#include "Button.h"
+
+Button::Button(Gpio& gpio, uint8_t pin)
+    : _gpio(gpio)
+    , _pin(pin)
+    , _reading(false)
+    , _stable(false)
+    , _event(false)
+    , _changeMs(0)
+{
+}
+
+void Button::begin() {
+    _gpio.pinMode(_pin, INPUT_PULLUP);
+}
+
+void Button::update(uint32_t nowMs) {
+    bool reading = _gpio.digitalRead(_pin) == LOW;
+    if (reading != _reading) {
+        _reading = reading;
+        _changeMs = nowMs;
+        return;
+    }
+    if (reading != _stable && nowMs - _changeMs >= DEBOUNCE_MS) {
+        _stable = reading;
+        if (_stable) _event = true;
+    }
+}
+
+bool Button::pressed() {
+    bool event = _event;
+    _event = false;
+    return event;
+}
@@ -0,0 +1,40 @@
+#include "CaptureStream.h"
+
+CaptureStream::CaptureStream(Print& output)
+    : _output(output)
+    , _sequence(0)
+    , _records(0)
+    , _dropped(0)
+{
+}
+
+void CaptureStream::reset() {
+    _sequence = 0;
+    _records = 0;
+    _dropped = 0;
+}
+
+bool CaptureStream::writeFrame(const uint8_t* frame, uint8_t length, uint32_t timestamp, uint8_t flags) {
+    uint16_t sequence = _sequence++;
+
+    if (_output.availableForWrite() < HEADER_SIZE + length) {
+        _dropped++;
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE] = {
+        SYNC,
+        length,
+        (uint8_t)(sequence & 0xFF),
+        (uint8_t)(sequence >> 8),
+        (uint8_t)(timestamp & 0xFF),
+        (uint8_t)((timestamp >> 8) & 0xFF),
+        (uint8_t)((timestamp >> 16) & 0xFF),
+        (uint8_t)(timestamp >> 24),
+        flags
+    };
+    _output.write(header, HEADER_SIZE);
+    _output.write(frame, length);
+    _records++;
+    return true;
+}
@@ -0,0 +1,73 @@
+#include "DeviceCache.h"
+#include "ModbusCRC.h"
+
+static const uint8_t MAGIC_0 = 'M';
+static const uint8_t MAGIC_1 = 'B';
+
+DeviceCache::DeviceCache(Storage& storage, uint16_t baseAddress)
+    : _storage(storage)
+    , _base(baseAddress)
+{
+}
+
+uint8_t DeviceCache::load(DeviceInfo* devices, uint8_t maxCount) {
+    if (_storage.read(_base) != MAGIC_0 || _storage.read(_base + 1) != MAGIC_1) return 0;
+    if (_storage.read(_base + 2) != VERSION) return 0;
+
+    uint8_t count = _storage.read(_base + 3);
+    if (count > MAX_ENTRIES) return 0;
+
+    uint16_t crcAt = crcAddress(count);
+    uint16_t stored = _storage.read(crcAt) | (_storage.read(crcAt + 1) << 8);
+    if (stored != computeCrc(count)) return 0;
+
+    if (count > maxCount) count = maxCount;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t at = _base + HEADER_SIZE + i * ENTRY_SIZE;
+        devices[i].address = _storage.read(at);
+        devices[i].baudRate = 0;
+        for (uint8_t b = 0; b < 4; b++) {
+            devices[i].baudRate |= (unsigned long)_storage.read(at + 1 + b) << (8 * b);
+        }
+    }
+    return count;
+}
+
+void DeviceCache::save(const DeviceInfo* devices, uint8_t count) {
+    if (count > MAX_ENTRIES) count = MAX_ENTRIES;
+
+    _storage.update(_base, MAGIC_0);
+    _storage.update(_base + 1, MAGIC_1);
+    _storage.update(_base + 2, VERSION);
+    _storage.update(_base + 3, count);
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t at = _base + HEADER_SIZE + i * ENTRY_SIZE;
+        _storage.update(at, devices[i].address);
+        for (uint8_t b = 0; b < 4; b++) {
+            _storage.update(at + 1 + b, (devices[i].baudRate >> (8 * b)) & 0xFF);
+        }
+    }
+
+    uint16_t crc = computeCrc(count);
+    uint16_t crcAt = crcAddress(count);
+    _storage.update(crcAt, crc & 0xFF);
+    _storage.update(crcAt + 1, crc >> 8);
+}
+
+void DeviceCache::clear() {
+    // Uszkodzony znacznik wystarcza - load() odrzuci całą listę
+    _storage.update(_base, 0xFF);
+}
+
+uint16_t DeviceCache::crcAddress(uint8_t count) const {
+    return _base + HEADER_SIZE + count * ENTRY_SIZE;
+}
+
+uint16_t DeviceCache::computeCrc(uint8_t count) {
+    ModbusCRC crc;
+    uint16_t end = crcAddress(count);
+    for (uint16_t at = _base; at < end; at++) {
+        crc.update(_storage.read(at));
+    }
+    return crc.value();
+}
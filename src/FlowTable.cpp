@@ -0,0 +1,148 @@
+#include "FlowTable.h"
+#include "BitSet.h"
+
+FlowTable::FlowTable() {
+    clear();
+}
+
+void FlowTable::clear() {
+    memset(_entries, 0, sizeof(_entries));
+    _size = 0;
+    _evictions = 0;
+}
+
+uint8_t FlowTable::hash(uint8_t address, uint8_t function, uint16_t startAddress,
+                        uint16_t quantity) {
+    uint16_t h = address * 31 + function * 7 + startAddress + quantity * 13;
+    return (h ^ (h >> 8)) & (CAPACITY - 1);
+}
+
+bool FlowTable::matches(const FlowEntry& entry, const ModbusTransaction& request) {
+    return entry.address == request.address && entry.function == request.function
+           && entry.startAddress == request.startAddress && entry.quantity == request.quantity;
+}
+
+uint8_t FlowTable::find(const ModbusTransaction& request) const {
+    uint8_t slot = hash(request.address, request.function, request.startAddress, request.quantity);
+    for (uint8_t probe = 0; probe < CAPACITY; probe++) {
+        const FlowEntry& entry = _entries[slot];
+        if (entry.requests == 0) return NOT_FOUND;
+        if (matches(entry, request)) return slot;
+        slot = (slot + 1) & (CAPACITY - 1);
+    }
+    return NOT_FOUND;
+}
+
+FlowEntry* FlowTable::recordRequest(const ModbusTransaction& request, uint32_t nowMs) {
+    uint8_t slot = find(request);
+    if (slot != NOT_FOUND) {
+        FlowEntry& entry = _entries[slot];
+        uint32_t interval = nowMs - entry.lastMs;
+        if (interval > UINT16_MAX) interval = UINT16_MAX;
+        // Pierwszy odstęp od razu jako średnia, potem mean += (odstęp - mean) / 8
+        if (entry.requests == 1) {
+            entry.meanInterval = interval << MEAN_SHIFT;
+        } else {
+            entry.meanInterval += interval - (entry.meanInterval >> MEAN_SHIFT);
+        }
+        if (entry.requests < UINT16_MAX) entry.requests++;
+        entry.lastMs = nowMs;
+        return &entry;
+    }
+
+    if (_size == CAPACITY) evictOldest(nowMs);
+    slot = hash(request.address, request.function, request.startAddress, request.quantity);
+    while (_entries[slot].requests) slot = (slot + 1) & (CAPACITY - 1);
+
+    FlowEntry& entry = _entries[slot];
+    entry.address = request.address;
+    entry.function = request.function;
+    entry.startAddress = request.startAddress;
+    entry.quantity = request.quantity;
+    entry.requests = 1;
+    entry.errors = 0;
+    entry.meanInterval = 0;
+    entry.lastMs = nowMs;
+    _size++;
+    return &entry;
+}
+
+void FlowTable::recordError(const ModbusTransaction& request) {
+    // Przepływ mógł zostać wypchnięty, zanim minął timeout
+    uint8_t slot = find(request);
+    if (slot != NOT_FOUND && _entries[slot].errors < UINT16_MAX) _entries[slot].errors++;
+}
+
+void FlowTable::evictOldest(uint32_t nowMs) {
+    uint8_t oldest = 0;
+    uint32_t oldestAge = 0;
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+        uint32_t age = nowMs - _entries[i].lastMs;
+        if (age >= oldestAge) {
+            oldestAge = age;
+            oldest = i;
+        }
+    }
+    remove(oldest);
+    _evictions++;
+}
+
+void FlowTable::remove(uint8_t slot) {
+    // Przesunięcie wstecz zamiast znacznika usunięcia: wpisy dalej w łańcuchu
+    // wracają bliżej swojego miejsca, wyszukiwanie nadal kończy się na pustym
+    _entries[slot].requests = 0;
+    _size--;
+    uint8_t next = slot;
+    for (;;) {
+        next = (next + 1) & (CAPACITY - 1);
+        const FlowEntry& entry = _entries[next];
+        if (entry.requests == 0) return;
+        uint8_t home = hash(entry.address, entry.function, entry.startAddress, entry.quantity);
+        bool stays = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (stays) continue;
+        _entries[slot] = entry;
+        _entries[next].requests = 0;
+        slot = next;
+    }
+}
+
+void FlowTable::print(uint8_t topCount, uint32_t nowMs) const {
+    Serial.print(F("Przeplywy: "));
+    Serial.print(_size);
+    Serial.print(F(" z "));
+    Serial.print(CAPACITY);
+    Serial.print(F(", wypchniete: "));
+    Serial.println(_evictions);
+    if (_size == 0) return;
+    Serial.println(F("ID\tFunkcja\tRejestr\tIlosc\tZapyt.\tBledy\tOdstep\tOstatnio [ms]"));
+
+    // Wybór kolejnego maksimum - bez sortowania i dodatkowej tablicy
+    BitSet<CAPACITY> printed;
+    printed.clear();
+    if (topCount > _size) topCount = _size;
+    for (uint8_t row = 0; row < topCount; row++) {
+        uint8_t best = NOT_FOUND;
+        for (uint8_t i = 0; i < CAPACITY; i++) {
+            if (_entries[i].requests == 0 || printed.test(i)) continue;
+            if (best == NOT_FOUND || _entries[i].requests > _entries[best].requests) best = i;
+        }
+        printed.set(best);
+
+        const FlowEntry& entry = _entries[best];
+        Serial.print(entry.address);
+        Serial.print(F("\t0x"));
+        Serial.print(entry.function, HEX);
+        Serial.print(F("\t"));
+        Serial.print(entry.startAddress);
+        Serial.print(F("\t"));
+        Serial.print(entry.quantity);
+        Serial.print(F("\t"));
+        Serial.print(entry.requests);
+        Serial.print(F("\t"));
+        Serial.print(entry.errors);
+        Serial.print(F("\t"));
+        Serial.print(entry.meanInterval >> MEAN_SHIFT);
+        Serial.print(F("\t"));
+        Serial.println(nowMs - entry.lastMs);
+    }
+}
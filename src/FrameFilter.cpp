@@ -0,0 +1,138 @@
+#include "FrameFilter.h"
+
+FrameFilter::FrameFilter()
+    : _count(0)
+    , _fields(0)
+{
+}
+
+void FrameFilter::clear() {
+    _count = 0;
+    _fields = 0;
+}
+
+bool FrameFilter::compile(const char* expression) {
+    // Kompilacja do kopii - błędne wyrażenie nie psuje działającego filtra
+    Predicate compiled[MAX_PREDICATES];
+    uint8_t count = 0;
+    uint8_t fields = 0;
+    const char* p = expression;
+
+    while (*p) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+
+        if (strncmp(p, "err", 3) == 0 && (p[3] == ' ' || p[3] == '\0')) {
+            if (count >= MAX_PREDICATES) return false;
+            compiled[count++] = {ERROR, 0, 0};
+            fields |= 1 << ERROR;
+            p += 3;
+            continue;
+        }
+
+        if (p[0] == 't' && p[1] == '>') {
+            char* end;
+            unsigned long ms = strtoul(p + 2, &end, 10);
+            if (end == p + 2 || ms > UINT16_MAX || count >= MAX_PREDICATES) return false;
+            compiled[count++] = {SLOW, (uint16_t)ms, 0};
+            fields |= 1 << SLOW;
+            p = end;
+            continue;
+        }
+
+        uint8_t field;
+        uint16_t limit;
+        switch (p[0]) {
+            case 'a': field = ADDRESS; limit = 247; break;
+            case 'f': field = FUNCTION; limit = 0x7F; break;
+            case 'r': field = REGISTER; limit = UINT16_MAX; break;
+            default: return false;
+        }
+        if (p[1] != '=') return false;
+        p += 2;
+
+        // Lista wartości i zakresów: 1,5-9,0x10
+        while (true) {
+            char* end;
+            unsigned long low = strtoul(p, &end, 0);
+            if (end == p) return false;
+            unsigned long high = low;
+            p = end;
+            if (*p == '-') {
+                high = strtoul(p + 1, &end, 0);
+                if (end == p + 1) return false;
+                p = end;
+            }
+            if (low > high || high > limit || count >= MAX_PREDICATES) return false;
+            compiled[count++] = {field, (uint16_t)low, (uint16_t)high};
+            fields |= 1 << field;
+            if (*p != ',') break;
+            p++;
+        }
+        if (*p != ' ' && *p != '\0') return false;
+    }
+
+    memcpy(_predicates, compiled, count * sizeof(Predicate));
+    _count = count;
+    _fields = fields;
+    return true;
+}
+
+bool FrameFilter::matches(const FrameSummary& frame) const {
+    uint8_t matched = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        const Predicate& predicate = _predicates[i];
+        uint8_t bit = 1 << predicate.field;
+        if (matched & bit) continue;
+        if (test(predicate, frame)) matched |= bit;
+    }
+    return matched == _fields;
+}
+
+bool FrameFilter::test(const Predicate& predicate, const FrameSummary& frame) {
+    switch (predicate.field) {
+        case ADDRESS:
+            return frame.address >= predicate.low && frame.address <= predicate.high;
+        case FUNCTION:
+            return frame.function >= predicate.low && frame.function <= predicate.high;
+        case REGISTER:
+            // Część wspólna z zakresem ramki
+            return frame.quantity
+                && frame.startAddress <= predicate.high
+                && (uint32_t)frame.startAddress + frame.quantity - 1 >= predicate.low;
+        case ERROR:
+            return frame.flags || frame.exception;
+        case SLOW:
+            return frame.responseUs > predicate.low * 1000UL;
+    }
+    return false;
+}
+
+void FrameFilter::print() const {
+    if (_count == 0) {
+        Serial.println(F("wszystkie ramki"));
+        return;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        const Predicate& predicate = _predicates[i];
+        if (i) Serial.print(' ');
+        switch (predicate.field) {
+            case ADDRESS: Serial.print(F("a=")); break;
+            case FUNCTION: Serial.print(F("f=")); break;
+            case REGISTER: Serial.print(F("r=")); break;
+            case ERROR: Serial.print(F("err")); continue;
+            case SLOW:
+                Serial.print(F("t>"));
+                Serial.print(predicate.low);
+                continue;
+        }
+        Serial.print(predicate.low);
+        if (predicate.high != predicate.low) {
+            Serial.print('-');
+            Serial.print(predicate.high);
+        }
+    }
+    Serial.println();
+}
@@ -0,0 +1,54 @@
+#include "FrameRing.h"
+
+FrameRing::FrameRing() {
+    clear();
+}
+
+void FrameRing::clear() {
+    _head = 0;
+    _tail = 0;
+    _used = 0;
+    _frames = 0;
+}
+
+void FrameRing::push(const uint8_t* frame, uint8_t length, uint32_t timestamp, uint8_t flags) {
+    uint16_t size = HEADER_SIZE + length;
+    if (size > SIZE) return;
+    while (SIZE - _used < size) dropOldest();
+
+    put(length);
+    put(flags);
+    for (uint8_t i = 0; i < 4; i++) put(timestamp >> (8 * i));
+    for (uint8_t i = 0; i < length; i++) put(frame[i]);
+    _frames++;
+}
+
+bool FrameRing::pop(uint8_t* frame, uint8_t& length, uint32_t& timestamp, uint8_t& flags) {
+    if (_frames == 0) return false;
+    length = take();
+    flags = take();
+    timestamp = 0;
+    for (uint8_t i = 0; i < 4; i++) timestamp |= (uint32_t)take() << (8 * i);
+    for (uint8_t i = 0; i < length; i++) frame[i] = take();
+    _frames--;
+    return true;
+}
+
+void FrameRing::dropOldest() {
+    uint8_t length = take();
+    for (uint8_t i = 1; i < HEADER_SIZE + length; i++) take();
+    _frames--;
+}
+
+void FrameRing::put(uint8_t value) {
+    _data[_head] = value;
+    _head = (_head + 1) % SIZE;
+    _used++;
+}
+
+uint8_t FrameRing::take() {
+    uint8_t value = _data[_tail];
+    _tail = (_tail + 1) % SIZE;
+    _used--;
+    return value;
+}
@@ -0,0 +1,237 @@
+#include "LoadTester.h"
+
+LoadTester::LoadTester(RtuTransport& transport, Clock& clock)
+    : _transport(transport)
+    , _clock(clock)
+    , _running(false)
+    , _deviceCount(0)
+    , _skipped(0)
+    , _next(0)
+    , _holdingWeight(1)
+    , _inputWeight(0)
+    , _registers(10)
+    , _mixBalance(0)
+    , _address(0)
+    , _function(0x03)
+    , _pending(false)
+    , _startMs(0)
+    , _elapsedMs(0)
+    , _lastProgressMs(0)
+    , _transactions(0)
+    , _timeouts(0)
+    , _crcErrors(0)
+    , _exceptions(0)
+    , _invalid(0)
+    , _busBytes(0)
+{
+    _turnaround.reset();
+}
+
+void LoadTester::configure(uint8_t holdingWeight, uint8_t inputWeight, uint8_t registers) {
+    if (holdingWeight == 0 && inputWeight == 0) holdingWeight = 1;
+    _holdingWeight = holdingWeight;
+    _inputWeight = inputWeight;
+    if (registers < 1) registers = 1;
+    _registers = registers > MAX_REGISTERS ? MAX_REGISTERS : registers;
+}
+
+bool LoadTester::start(const DeviceInfo* devices, uint8_t count) {
+    // Segment magistrali pracuje z jedną prędkością - wybieramy najczęstszą
+    unsigned long baud = 0;
+    uint8_t best = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t same = 0;
+        for (uint8_t j = 0; j < count; j++) {
+            if (devices[j].baudRate == devices[i].baudRate) same++;
+        }
+        if (same > best) {
+            best = same;
+            baud = devices[i].baudRate;
+        }
+    }
+    if (best == 0) {
+        Serial.println(F("Brak urzadzen - najpierw skanowanie"));
+        return false;
+    }
+
+    _deviceCount = 0;
+    for (uint8_t i = 0; i < count && _deviceCount < MAX_DEVICES; i++) {
+        if (devices[i].baudRate == baud) _addresses[_deviceCount++] = devices[i].address;
+    }
+    _skipped = count - _deviceCount;
+
+    _next = 0;
+    _mixBalance = 0;
+    _pending = false;
+    _transactions = 0;
+    _timeouts = 0;
+    _crcErrors = 0;
+    _exceptions = 0;
+    _invalid = 0;
+    _busBytes = 0;
+    _elapsedMs = 0;
+    _turnaround.reset();
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _running = true;
+    _startMs = _clock.millis();
+    _lastProgressMs = _startMs;
+
+    Serial.print(F("\nTest obciazenia: "));
+    Serial.print(_deviceCount);
+    Serial.print(F(" urzadzen @ "));
+    Serial.print(baud);
+    Serial.print(F(" baud, 0x03:0x04 = "));
+    Serial.print(_holdingWeight);
+    Serial.print(':');
+    Serial.print(_inputWeight);
+    Serial.print(F(", rejestrow: "));
+    Serial.println(_registers);
+    if (_skipped) {
+        Serial.print(F("Pominiete (inna predkosc): "));
+        Serial.println(_skipped);
+    }
+    return true;
+}
+
+void LoadTester::stop() {
+    if (!_running) return;
+    _running = false;
+    _elapsedMs = _clock.millis() - _startMs;
+    _transport.cancel();
+    Serial.println(F("Test obciazenia zatrzymany"));
+}
+
+void LoadTester::update() {
+    if (!_running) return;
+
+    _transport.poll();
+    if (_transport.busy()) return;
+
+    if (_pending) handleResult();
+    sendNext();
+
+    uint32_t now = _clock.millis();
+    if (now - _lastProgressMs >= PROGRESS_INTERVAL_MS) {
+        _lastProgressMs = now;
+        Serial.print(F("Transakcje/s: "));
+        printTenths(ratePerSecondTenths(_transactions, now - _startMs));
+        Serial.println();
+    }
+}
+
+uint8_t LoadTester::nextFunction() {
+    // Rozkład równomierny bez losowania: przy 3:1 co czwarte zapytanie to 0x04
+    _mixBalance += _inputWeight;
+    if (_mixBalance * 2 >= (int16_t)(_holdingWeight + _inputWeight)) {
+        _mixBalance -= _holdingWeight + _inputWeight;
+        return 0x04;
+    }
+    return 0x03;
+}
+
+void LoadTester::sendNext() {
+    _address = _addresses[_next];
+    if (++_next >= _deviceCount) _next = 0;
+    _function = nextFunction();
+
+    const uint8_t query[] = {_address, _function, 0x00, 0x00, 0x00, _registers};
+    uint32_t windowUs = RESPONSE_TIMEOUT_MS * 1000UL;
+    _pending = _transport.request(query, sizeof(query), windowUs);
+}
+
+void LoadTester::handleResult() {
+    _pending = false;
+    _transactions++;
+    _busBytes += REQUEST_LENGTH + _transport.responseLength();
+
+    switch (_transport.result()) {
+        case RtuTransport::Result::TIMEOUT:
+            _timeouts++;
+            return;
+        case RtuTransport::Result::CRC_ERROR:
+            _crcErrors++;
+            return;
+        default:
+            break;
+    }
+
+    const uint8_t* reply = _transport.response();
+    _turnaround.record(_transport.turnaroundUs());
+    if (reply[0] == _address && reply[1] == (_function | 0x80)) {
+        _exceptions++;
+    } else if (reply[0] != _address || reply[1] != _function
+               || _transport.responseLength() != 5 + 2 * _registers) {
+        _invalid++;
+    }
+}
+
+uint32_t LoadTester::errorCount() const {
+    return _timeouts + _crcErrors + _exceptions + _invalid;
+}
+
+uint32_t LoadTester::ratePerSecondTenths(uint32_t count, uint32_t ms) {
+    return ms ? (uint32_t)((uint64_t)count * 10000 / ms) : 0;
+}
+
+void LoadTester::printTenths(uint32_t tenths) {
+    // Jedno miejsce po przecinku bez liczb zmiennoprzecinkowych
+    Serial.print(tenths / 10);
+    Serial.print('.');
+    Serial.print(tenths % 10);
+}
+
+void LoadTester::showSummary() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+    const RtuTiming& timing = _transport.timing();
+    uint32_t capacity = 1000000UL / timing.charUs;
+    uint32_t achieved = elapsedMs ? (uint32_t)((uint64_t)_busBytes * 1000 / elapsedMs) : 0;
+    // Górna granica: same znaki i cisza t3.5 przed każdą ramką, slave odpowiada od razu
+    uint32_t frameUs = (uint32_t)(REQUEST_LENGTH + 5 + 2 * _registers) * timing.charUs
+                       + 2 * timing.t35Us;
+
+    Serial.println(F("\n=== Test obciazenia ==="));
+    Serial.print(F("Predkosc: "));
+    Serial.print(_transport.baud());
+    Serial.print(F(" baud, czas testu: "));
+    Serial.print(elapsedMs);
+    Serial.println(F(" ms"));
+    Serial.print(F("Transakcje: "));
+    Serial.println(_transactions);
+    Serial.print(F("Transakcje/s: "));
+    printTenths(ratePerSecondTenths(_transactions, elapsedMs));
+    Serial.print(F(" (limit magistrali: "));
+    printTenths(10000000UL / frameUs);
+    Serial.println(F(")"));
+    Serial.print(F("Bajty/s: "));
+    Serial.print(achieved);
+    Serial.print(F(" z "));
+    Serial.print(capacity);
+    Serial.print(F(" ("));
+    Serial.print(capacity ? achieved * 100 / capacity : 0);
+    Serial.println(F("%)"));
+
+    Serial.print(F("Czas reakcji slave'a p50/p99/max [us]: "));
+    Serial.print(_turnaround.percentileUs(50));
+    Serial.print('/');
+    Serial.print(_turnaround.percentileUs(99));
+    Serial.print('/');
+    Serial.println(_turnaround.maxUs);
+
+    uint32_t errors = errorCount();
+    Serial.print(F("Bledy: "));
+    Serial.print(errors);
+    Serial.print(F(" ("));
+    printTenths(_transactions ? (uint32_t)((uint64_t)errors * 1000 / _transactions) : 0);
+    Serial.println(F("%)"));
+    Serial.print(F("  Timeout: "));
+    Serial.println(_timeouts);
+    Serial.print(F("  CRC: "));
+    Serial.println(_crcErrors);
+    Serial.print(F("  Wyjatki: "));
+    Serial.println(_exceptions);
+    Serial.print(F("  Nieprawidlowe odpowiedzi: "));
+    Serial.println(_invalid);
+    Serial.println(F("======================="));
+}
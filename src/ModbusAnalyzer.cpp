@@ -1,96 +1,490 @@
 #include "ModbusAnalyzer.h"
+#include "Profiler.h"
 
-const unsigned long ModbusAnalyzer::BAUD_RATES[] = {9600, 19200, 38400, 57600, 115200};
+const unsigned long ModbusAnalyzer::BAUD_RATES[] PROGMEM = {9600, 19200, 38400, 57600, 115200};
 const uint8_t ModbusAnalyzer::BAUD_COUNT = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
 
-ModbusAnalyzer::ModbusAnalyzer(HardwareSerial& modbusSerial)
-    : _serial(modbusSerial)
+// Liczniki slave'ów są 16-bitowe - zatrzymują się na 65535 zamiast wracać do 0
+static void countUp(uint16_t& counter) {
+    if (counter < UINT16_MAX) counter++;
+}
+
+ModbusAnalyzer::ModbusAnalyzer(RtuTransport& transport, Clock& clock)
+    : _transport(transport)
+    , _clock(clock)
     , _analyzing(false)
     , _baudIndex(0)
+    , _currentBaud(pgm_read_dword(&BAUD_RATES[0]))
+    , _autoBaud(nullptr)
+    , _baudState(BaudState::ROTATING)
+    , _lockStartTime(0)
+    , _capture(nullptr)
     , _bufferIndex(0)
+    , _timing(transport.timing())
+    , _busLoad(_timing)
+    , _rxState(RxState::SYNC)
+    , _lastByteMicros(0)
+    , _frameStartMicros(0)
+    , _frameOverflow(false)
+    , _frameT15Violation(false)
+    , _frameStatus(0)
+    , _lastValidFrameTime(0)
+    , _lastOverflowCount(0)
     , _lastActivityTime(0)
     , _lastFrameTime(0)
+    , _slaveStatsCount(0)
+    , _pending(false)
+    , _pendingEndMicros(0)
+    , _pendingTime(0)
+    , _triggerArmed(false)
+    , _postFrames(0)
+    , _postRemaining(0)
+    , _triggerCount(0)
+    , _flowPeriodMs(0)
+    , _lastFlowReport(0)
+    , _flowTop(0)
 {
     memset(&_masterInfo, 0, sizeof(MasterInfo));
+    memset(&_pendingRequest, 0, sizeof(ModbusTransaction));
     _masterInfo.minQueryInterval = UINT32_MAX;
     _masterInfo.maxQueryInterval = 0;
 }
 
 void ModbusAnalyzer::begin() {
-    _serial.begin(BAUD_RATES[0]);
+    _transport.begin(pgm_read_dword(&BAUD_RATES[0]));
 }
 
 void ModbusAnalyzer::startAnalysis() {
     _analyzing = true;
     _baudIndex = 0;
-    _bufferIndex = 0;
-    _lastActivityTime = millis();
-    _lastFrameTime = millis();
+    resetFrame();
+    _rxState = RxState::SYNC;
+    _lastByteMicros = _clock.micros();
+    _lastActivityTime = _clock.millis();
+    _lastFrameTime = _clock.millis();
+    _lastValidFrameTime = _clock.millis();
     memset(&_masterInfo, 0, sizeof(MasterInfo));
     _masterInfo.minQueryInterval = UINT32_MAX;
     _masterInfo.maxQueryInterval = 0;
-    _serial.begin(BAUD_RATES[0]);
+    resetSlaveStats();
+    _history.clear();
+    _postRemaining = 0;
+    _triggerCount = 0;
+    _flows.clear();
+    _lastFlowReport = _clock.millis();
+    _lastOverflowCount = _transport.overflowCount();
+    _currentBaud = pgm_read_dword(&BAUD_RATES[0]);
+    _transport.setBaud(_currentBaud);
+    _busLoad.reset(_lastByteMicros);
     Serial.println(F("\nRozpoczynam nasluchiwanie magistrali..."));
+    restartBaudDetection();
+}
+
+void ModbusAnalyzer::setAutoBaud(AutoBaud* autoBaud) {
+    _autoBaud = autoBaud;
+}
+
+void ModbusAnalyzer::setCaptureStream(CaptureStream* capture) {
+    _capture = capture;
+    if (_capture) _capture->reset();
+}
+
+bool ModbusAnalyzer::setFilter(const char* expression) {
+    return _filter.compile(expression);
+}
+
+bool ModbusAnalyzer::setTrigger(const char* expression, uint8_t postFrames) {
+    if (!_trigger.compile(expression)) return false;
+    // Pusty wyzwalacz pasowałby do każdej ramki - oznacza wyłączenie
+    _triggerArmed = !_trigger.isEmpty();
+    _postFrames = postFrames;
+    _postRemaining = 0;
+    _history.clear();
+    return true;
+}
+
+void ModbusAnalyzer::setFlowReport(uint16_t periodS, uint8_t topCount) {
+    _flowPeriodMs = periodS * 1000UL;
+    _flowTop = topCount;
+    _lastFlowReport = _clock.millis();
+}
+
+void ModbusAnalyzer::showOutputSettings() const {
+    Serial.print(F("Filtr: "));
+    _filter.print();
+    Serial.print(F("Wyzwalacz: "));
+    if (!_triggerArmed) {
+        Serial.println(F("wylaczony"));
+        return;
+    }
+    _trigger.print();
+    Serial.print(F("Ramki po wyzwoleniu: "));
+    Serial.println(_postFrames);
+}
+
+void ModbusAnalyzer::checkFlowReport() {
+    if (!flowReport()) return;
+    uint32_t nowMs = _clock.millis();
+    if (nowMs - _lastFlowReport < _flowPeriodMs) return;
+    _lastFlowReport = nowMs;
+
+    PROFILE_SCOPE(PRINT);
+    Serial.print(F("\n=== Przeplywy, "));
+    Serial.print(nowMs / 1000);
+    Serial.println(F(" s ==="));
+    _flows.print(_flowTop, nowMs);
 }
 
 void ModbusAnalyzer::stop() {
     _analyzing = false;
+    if (_autoBaud) _autoBaud->end();
     Serial.println(F("Zatrzymano nasluchiwanie"));
 }
 
 void ModbusAnalyzer::update() {
     if (!_analyzing) return;
 
-    if (_serial.available()) {
-        checkCollision();
-        
-        while (_serial.available() && _bufferIndex < MAX_BUFFER) {
-            _buffer[_bufferIndex++] = _serial.read();
-            _lastActivityTime = millis();
+    // Czas pobrany przed opróżnieniem pierścienia - bajty z ISR mogą
+    // mieć późniejszy znacznik, stąd porównanie ze znakiem w checkSilence
+    uint32_t now = _clock.micros();
+    RxEvent event;
+    while (_transport.readEvent(event)) {
+        onByte(event);
+    }
+    _busLoad.advance(now);
+
+    uint32_t overflows = _transport.overflowCount();
+    if (overflows != _lastOverflowCount) {
+        _masterInfo.rxOverflows += overflows - _lastOverflowCount;
+        _lastOverflowCount = overflows;
+        if (_rxState == RxState::RECEIVING) {
+            _frameOverflow = true;
+            _frameStatus |= RX_STATUS_OVERRUN;
         }
-        
-        _masterInfo.totalFrames++;
-        
-        if (_bufferIndex >= 8) {
-            if (processFrame()) {
-                _masterInfo.baudRate = BAUD_RATES[_baudIndex];
-                updateMasterInfo();
-                updateTimingStats();
-                _lastFrameTime = millis();
-                _bufferIndex = 0;
-            } else {
-                _masterInfo.invalidFrames++;
+    }
+
+    checkSilence(now);
+    checkResponseTimeout();
+    checkFlowReport();
+    updateBaudLock();
+}
+
+void ModbusAnalyzer::updateBaudLock() {
+    uint32_t nowMs = _clock.millis();
+
+    switch (_baudState) {
+        case BaudState::DETECTING:
+            if (_autoBaud->ready()) {
+                unsigned long measured = _autoBaud->measuredBaud();
+                unsigned long baud = _autoBaud->estimateBaud();
+                _autoBaud->end();
+                if (textOutput()) {
+                    Serial.print(F("\nAutobaud: pomiar "));
+                    Serial.print(measured);
+                    Serial.print(F(" baud -> "));
+                    Serial.print(baud);
+                    Serial.println(F(" baud"));
+                }
+                applyBaud(baud);
+                _baudState = BaudState::CONFIRMING;
+                _lastValidFrameTime = nowMs;
+            } else if (nowMs - _lockStartTime > AUTOBAUD_TIMEOUT_MS) {
+                _autoBaud->end();
+                if (textOutput()) {
+                    Serial.println(F("\nAutobaud: brak zboczy, przeszukiwanie predkosci"));
+                }
+                _baudState = BaudState::ROTATING;
+                _lastValidFrameTime = nowMs;
+            }
+            break;
+
+        case BaudState::CONFIRMING:
+            // Pomiar zawiódł (np. zakłócenia) - ponowny pomiar
+            if (nowMs - _lastValidFrameTime > CONFIRM_TIMEOUT_MS) {
+                restartBaudDetection();
+            }
+            break;
+
+        case BaudState::LOCKED:
+            // Ruch bez poprawnych ramek oznacza zmianę prędkości mastera;
+            // sama cisza nie zrywa synchronizacji
+            if (nowMs - _lastValidFrameTime > ROTATE_INTERVAL_MS
+                && (int32_t)(_lastActivityTime - _lastValidFrameTime) > 0) {
+                restartBaudDetection();
+            }
+            break;
+
+        case BaudState::ROTATING:
+            if (nowMs - _lastValidFrameTime > ROTATE_INTERVAL_MS && _rxState != RxState::RECEIVING) {
+                changeBaudRate();
+                _lastValidFrameTime = _clock.millis();
+            }
+            break;
+    }
+}
+
+void ModbusAnalyzer::restartBaudDetection() {
+    _lockStartTime = _clock.millis();
+    _lastValidFrameTime = _lockStartTime;
+    if (_autoBaud) {
+        _autoBaud->begin();
+        _baudState = BaudState::DETECTING;
+    } else {
+        _baudState = BaudState::ROTATING;
+    }
+}
+
+void ModbusAnalyzer::confirmBaud() {
+    if (_baudState == BaudState::LOCKED) return;
+    if (_autoBaud) _autoBaud->end();
+
+    _baudState = BaudState::LOCKED;
+    _masterInfo.baudLockTime = _clock.millis() - _lockStartTime;
+    if (!textOutput()) return;
+    Serial.print(F("\nPredkosc potwierdzona CRC: "));
+    Serial.print(_currentBaud);
+    Serial.print(F(" baud po "));
+    Serial.print(_masterInfo.baudLockTime);
+    Serial.println(F(" ms"));
+}
+
+void ModbusAnalyzer::onByte(const RxEvent& event) {
+    uint8_t data = event.data;
+    uint32_t timestamp = event.timestamp;
+    countLineErrors(event.status);
+    uint32_t gap = timestamp - _lastByteMicros;
+    _lastByteMicros = timestamp;
+    _lastActivityTime = _clock.millis();
+    _busLoad.onByte(timestamp);
+
+    switch (_rxState) {
+        case RxState::SYNC:
+            // Bajty bez wcześniejszej ciszy t3.5 należą do niepełnej ramki
+            if (gap < _timing.t35Us) return;
+            _rxState = RxState::IDLE;
+            // fall through
+        case RxState::IDLE:
+            resetFrame();
+            _frameStartMicros = timestamp;
+            // Możliwe tylko po zamknięciu ramki przewidzianą długością;
+            // znaczniki to koniec znaku, więc cisza = odstęp - czas znaku
+            if (gap < _timing.t35Us + _timing.charUs) _masterInfo.t35Violations++;
+            _busLoad.onFrameGap(gap > _timing.charUs ? gap - _timing.charUs : 0);
+            // Odpowiedź oczekiwanego slave'a to nie kolizja
+            if (!_pending || data != _pendingRequest.address) checkCollision();
+            _rxState = RxState::RECEIVING;
+            break;
+        case RxState::RECEIVING:
+            if (gap > _timing.t15Us && !_frameT15Violation) {
+                _frameT15Violation = true;
+                _masterInfo.t15Violations++;
             }
+            break;
+    }
+
+    if (_bufferIndex < MAX_BUFFER) {
+        _buffer[_bufferIndex++] = data;
+    } else {
+        _frameOverflow = true;
+    }
+    _crc.update(data);
+    _frameStatus |= event.status;
+
+    // Ostatni bajt przewidzianej ramki - bez czekania na ciszę t3.5
+    if (frameComplete()) {
+        closeFrame();
+        _rxState = RxState::IDLE;
+    }
+}
+
+bool ModbusAnalyzer::frameComplete() const {
+    if (_frameOverflow || _bufferIndex < MIN_FRAME_SIZE || !_crc.isValid()) return false;
+    // Kierunek nie jest pewny (np. powtórzone zapytanie), więc wystarczy
+    // zgodność z którymkolwiek - poprawne CRC wyklucza przypadkowe trafienie
+    return _bufferIndex == ModbusPdu::expectedLength(_buffer, _bufferIndex, FrameDirection::REQUEST)
+        || _bufferIndex == ModbusPdu::expectedLength(_buffer, _bufferIndex, FrameDirection::RESPONSE);
+}
+
+void ModbusAnalyzer::checkSilence(uint32_t now) {
+    if ((int32_t)(now - _lastByteMicros) < (int32_t)_timing.t35Us) return;
+
+    if (_rxState == RxState::RECEIVING) {
+        closeFrame();
+    }
+    _rxState = RxState::IDLE;
+}
+
+void ModbusAnalyzer::closeFrame() {
+    PROFILE_SCOPE(FRAME);
+    _masterInfo.totalFrames++;
+    if (_baudState == BaudState::LOCKED) {
+        if (_frameStatus & (RX_STATUS_FRAMING | RX_STATUS_PARITY)) _masterInfo.lineErrorFrames++;
+        if (_frameStatus & RX_STATUS_OVERRUN) _masterInfo.lostByteFrames++;
+    }
+
+    FrameSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.address = _buffer[0];
+    summary.function = _buffer[1] & 0x7F;
+    summary.flags = frameFlags();
+    ModbusTransaction transaction;
+    FrameDirection direction = FrameDirection::REQUEST;
+    bool valid = false;
+
+    if (_frameOverflow || _bufferIndex < MIN_FRAME_SIZE) {
+        _masterInfo.invalidFrames++;
+    } else if (processFrame()) {
+        valid = true;
+        _masterInfo.baudRate = _currentBaud;
+        confirmBaud();
+        direction = pairTransaction(transaction, summary);
+        _lastFrameTime = _clock.millis();
+        _lastValidFrameTime = _lastFrameTime;
+    } else {
+        _masterInfo.invalidFrames++;
+    }
+
+    routeFrame(summary, valid ? &transaction : nullptr, direction);
+    resetFrame();
+}
+
+uint8_t ModbusAnalyzer::frameFlags() const {
+    uint8_t flags = 0;
+    if (_frameOverflow) flags |= CAPTURE_FLAG_OVERFLOW;
+    if (_frameT15Violation) flags |= CAPTURE_FLAG_T15;
+    if (_bufferIndex < MIN_FRAME_SIZE) flags |= CAPTURE_FLAG_SHORT;
+    if (!_crc.isValid()) flags |= CAPTURE_FLAG_CRC_ERROR;
+    if (_frameStatus & RX_STATUS_FRAMING) flags |= CAPTURE_FLAG_FRAMING;
+    if (_frameStatus & RX_STATUS_PARITY) flags |= CAPTURE_FLAG_PARITY;
+    if (_frameStatus & RX_STATUS_OVERRUN) flags |= CAPTURE_FLAG_LOST;
+    return flags;
+}
+
+void ModbusAnalyzer::routeFrame(const FrameSummary& summary, const ModbusTransaction* transaction,
+                                FrameDirection direction) {
+    // Statystyki są już policzone - filtr decyduje tylko o wyjściu,
+    // a przy zestawieniu przepływów ramki nie są wypisywane
+    if (flowReport() || !_filter.matches(summary)) return;
+    if (!_triggerArmed) {
+        outputFrame(summary, transaction, direction);
+        return;
+    }
+
+    if (_postRemaining) {
+        outputFrame(summary, transaction, direction);
+        if (--_postRemaining == 0 && textOutput()) {
+            Serial.println(F("=== Koniec wyzwolenia ==="));
         }
+        return;
     }
-    
-    if (millis() - _lastActivityTime > 1000) {
-        changeBaudRate();
-        _lastActivityTime = millis();
+
+    if (_trigger.matches(summary)) {
+        _triggerCount++;
+        if (textOutput()) {
+            Serial.print(F("\n=== Wyzwolenie "));
+            Serial.print(_triggerCount);
+            Serial.print(F(", ramki wczesniej: "));
+            Serial.print(_history.frameCount());
+            Serial.println(F(" ==="));
+        }
+        dumpHistory();
+        outputFrame(summary, transaction, direction);
+        _postRemaining = _postFrames;
+        return;
+    }
+
+    // Przed wyzwoleniem ramka trafia tylko do historii - bez wydruku
+    _history.push(_buffer, _bufferIndex, _frameStartMicros, summary.flags);
+}
+
+void ModbusAnalyzer::outputFrame(const FrameSummary& summary, const ModbusTransaction* transaction,
+                                 FrameDirection direction) {
+    PROFILE_SCOPE(PRINT);
+    if (_capture) {
+        _capture->writeFrame(_buffer, _bufferIndex, _frameStartMicros, summary.flags);
+        return;
+    }
+    // Bez filtra i wyzwalacza tekst pokazuje tylko poprawne ramki
+    if (!transaction && _filter.isEmpty() && !_triggerArmed) return;
+
+    printFrame(summary.flags);
+    if (!transaction) return;
+    if (summary.responseUs) {
+        Serial.print(F("Odpowiedz po "));
+        Serial.print(summary.responseUs);
+        Serial.println(F(" us"));
+    }
+    printTransaction(*transaction, direction);
+}
+
+void ModbusAnalyzer::dumpHistory() {
+    uint8_t frame[MAX_BUFFER];
+    uint8_t length;
+    uint8_t flags;
+    uint32_t timestamp;
+    while (_history.pop(frame, length, timestamp, flags)) {
+        if (_capture) {
+            _capture->writeFrame(frame, length, timestamp, flags);
+            continue;
+        }
+        Serial.print(F("[historia] "));
+        Serial.print(timestamp);
+        Serial.print(F(" us"));
+        if (flags) {
+            Serial.print(F(" flagi 0x"));
+            Serial.print(flags, HEX);
+        }
+        Serial.print(':');
+        printHex(frame, length);
     }
 }
 
+void ModbusAnalyzer::printHex(const uint8_t* data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        Serial.print(F(" "));
+        if (data[i] < 0x10) Serial.print('0');
+        Serial.print(data[i], HEX);
+    }
+    Serial.println();
+}
+
+void ModbusAnalyzer::resetFrame() {
+    _bufferIndex = 0;
+    _crc.reset();
+    _frameOverflow = false;
+    _frameT15Violation = false;
+    _frameStatus = 0;
+}
+
 bool ModbusAnalyzer::isAnalyzing() const {
     return _analyzing;
 }
 
 unsigned long ModbusAnalyzer::getCurrentBaudRate() const {
-    return BAUD_RATES[_baudIndex];
+    return _currentBaud;
 }
 
 void ModbusAnalyzer::changeBaudRate() {
     _baudIndex = (_baudIndex + 1) % BAUD_COUNT;
-    clearBuffer();
-    _serial.end();
-    delay(10);
-    _serial.begin(BAUD_RATES[_baudIndex]);
+    applyBaud(pgm_read_dword(&BAUD_RATES[_baudIndex]));
+    if (!textOutput()) return;
     Serial.print(F("\nZmiana predkosci na: "));
-    Serial.print(BAUD_RATES[_baudIndex]);
+    Serial.print(_currentBaud);
     Serial.println(F(" baud"));
 }
 
+void ModbusAnalyzer::applyBaud(unsigned long baud) {
+    _currentBaud = baud;
+    clearBuffer();
+    _transport.setBaud(baud);
+    _rxState = RxState::SYNC;
+    _lastByteMicros = _clock.micros();
+    // Bajty z poprzedniej prędkości nie mówią nic o obciążeniu
+    _busLoad.reset(_lastByteMicros);
+}
+
 void ModbusAnalyzer::updateTimingStats() {
-    uint32_t currentTime = millis();
+    uint32_t currentTime = _clock.millis();
     if (_masterInfo.queryCount > 0) {
         uint32_t interval = currentTime - _masterInfo.lastQueryTime;
         
@@ -108,11 +502,12 @@ void ModbusAnalyzer::updateTimingStats() {
 }
 
 void ModbusAnalyzer::checkCollision() {
-    uint32_t currentTime = millis();
+    uint32_t currentTime = _clock.millis();
     uint32_t timeSinceLastFrame = currentTime - _lastFrameTime;
     
     if (timeSinceLastFrame < COLLISION_THRESHOLD) {
         _masterInfo.collisions++;
+        if (!textOutput()) return;
         Serial.print(F("\n!!! Wykryto kolizje - "));
         Serial.print(timeSinceLastFrame);
         Serial.println(F("ms od ostatniej ramki"));
@@ -120,82 +515,215 @@ void ModbusAnalyzer::checkCollision() {
 }
 
 bool ModbusAnalyzer::processFrame() {
-    uint16_t receivedCrc = (_buffer[_bufferIndex-1] << 8) | _buffer[_bufferIndex-2];
-    uint16_t calculatedCrc = calculateCRC16(_buffer, _bufferIndex-2);
-    
-    if (receivedCrc != calculatedCrc) {
+    if (!_crc.isValid()) {
         _masterInfo.crcErrors++;
         return false;
     }
-    
+    return true;
+}
+
+void ModbusAnalyzer::printFrame(uint8_t flags) const {
+    if (flags & (CAPTURE_FLAG_CRC_ERROR | CAPTURE_FLAG_OVERFLOW | CAPTURE_FLAG_SHORT)) {
+        Serial.print(F("\nBledna ramka (flagi 0x"));
+        Serial.print(flags, HEX);
+        Serial.print(F("):"));
+        printHex(_buffer, _bufferIndex);
+        return;
+    }
+
     Serial.print(F("\nWykryto ramke Modbus:"));
     Serial.print(F("\nAdres: "));
     Serial.print(_buffer[0]);
     Serial.print(F(" Funkcja: 0x"));
     Serial.print(_buffer[1], HEX);
+    Serial.print(F(" ("));
+    Serial.print(ModbusPdu::functionName(_buffer[1]));
+    Serial.print(F(")"));
     Serial.print(F(" Predkosc: "));
-    Serial.print(BAUD_RATES[_baudIndex]);
+    Serial.print(_currentBaud);
     Serial.println(F(" baud"));
-    
-    Serial.print(F("Ramka HEX:"));
-    for (uint8_t i = 0; i < _bufferIndex; i++) {
-        Serial.print(F(" "));
-        if (_buffer[i] < 0x10) Serial.print('0');
-        Serial.print(_buffer[i], HEX);
+    if (flags & CAPTURE_FLAG_T15) {
+        Serial.println(F("Uwaga: przerwa > t1.5 wewnatrz ramki"));
+    }
+    if (flags & (CAPTURE_FLAG_FRAMING | CAPTURE_FLAG_PARITY)) {
+        Serial.println(F("Uwaga: bledy linii (FE/parzystosc) mimo poprawnego CRC"));
     }
-    Serial.println();
     
-    return true;
+    Serial.print(F("Ramka HEX:"));
+    printHex(_buffer, _bufferIndex);
 }
 
 void ModbusAnalyzer::updateMasterInfo() {
-    if (!isAddressInList(_buffer[0]) && _masterInfo.addressCount < 10) {
-        _masterInfo.slaveAddresses[_masterInfo.addressCount++] = _buffer[0];
-    }
-    
-    if (!isFunctionInList(_buffer[1]) && _masterInfo.functionCount < 5) {
-        _masterInfo.functions[_masterInfo.functionCount++] = _buffer[1];
+    if (_masterInfo.slaveAddresses.set(_buffer[0])) _masterInfo.addressCount++;
+    if (_masterInfo.functions.set(_buffer[1])) _masterInfo.functionCount++;
+
+    switch (_pendingRequest.function) {
+        case 0x05: case 0x06: case 0x0F: case 0x10: case 0x17:
+            _masterInfo.writeRequests++;
+            break;
     }
-    
-    _masterInfo.startRegister = (_buffer[2] << 8) | _buffer[3];
-    _masterInfo.registerCount = (_buffer[4] << 8) | _buffer[5];
 }
 
-void ModbusAnalyzer::clearBuffer() {
-    while (_serial.available()) {
-        _serial.read();
+FrameDirection ModbusAnalyzer::pairTransaction(ModbusTransaction& transaction, FrameSummary& summary) {
+    uint8_t address = _buffer[0];
+    uint8_t function = _buffer[1] & 0x7F;
+
+    // Długość niezgodna z odpowiedzią oznacza powtórzone zapytanie
+    if (_pending && address == _pendingRequest.address && function == _pendingRequest.function
+        && ModbusPdu::decode(_buffer, _bufferIndex, FrameDirection::RESPONSE, transaction)) {
+        // Odpowiedź: znaczniki to koniec znaku, więc odejmujemy czas
+        // pierwszego znaku, aby dostać ciszę między ramkami
+        uint32_t turnaround = _frameStartMicros - _pendingEndMicros;
+        turnaround = turnaround > _timing.charUs ? turnaround - _timing.charUs : 0;
+
+        SlaveStats* stats = findSlaveStats(address);
+        if (stats) {
+            stats->turnaround.record(turnaround);
+            if (transaction.exceptionCode) {
+                countUp(stats->exceptions);
+                stats->lastException = transaction.exceptionCode;
+            }
+        }
+        if (transaction.exceptionCode) _flows.recordError(_pendingRequest);
+        _pending = false;
+
+        // Zakres rejestrów odpowiedzi jest znany tylko z zapytania
+        summary.exception = transaction.exceptionCode != 0;
+        summary.startAddress = _pendingRequest.startAddress;
+        summary.quantity = _pendingRequest.quantity;
+        summary.responseUs = turnaround;
+        return FrameDirection::RESPONSE;
     }
-    _bufferIndex = 0;
-}
 
-bool ModbusAnalyzer::isAddressInList(uint8_t address) const {
-    for (uint8_t i = 0; i < _masterInfo.addressCount; i++) {
-        if (_masterInfo.slaveAddresses[i] == address) return true;
+    bool isRequest = !(_buffer[1] & 0x80)
+        && ModbusPdu::decode(_buffer, _bufferIndex, FrameDirection::REQUEST, transaction);
+    if (!isRequest && ModbusPdu::decode(_buffer, _bufferIndex, FrameDirection::RESPONSE, transaction)) {
+        // Odpowiedź bez zapytania (np. początek nasłuchu) nie otwiera transakcji
+        summary.exception = transaction.exceptionCode != 0;
+        return FrameDirection::RESPONSE;
+    }
+    if (!isRequest) {
+        // Długość nie pasuje do funkcji - bez zakresu rejestrów
+        transaction.address = address;
+        transaction.function = function;
     }
-    return false;
-}
 
-bool ModbusAnalyzer::isFunctionInList(uint8_t function) const {
-    for (uint8_t i = 0; i < _masterInfo.functionCount; i++) {
-        if (_masterInfo.functions[i] == function) return true;
+    // Zapytanie mastera; poprzednie bez odpowiedzi to timeout
+    if (_pending) {
+        SlaveStats* previous = findSlaveStats(_pendingRequest.address);
+        if (previous) countUp(previous->timeouts);
+        _flows.recordError(_pendingRequest);
     }
-    return false;
+
+    _pendingRequest = transaction;
+    summary.startAddress = transaction.startAddress;
+    summary.quantity = transaction.quantity;
+
+    updateMasterInfo();
+    updateTimingStats();
+    _flows.recordRequest(transaction, _clock.millis());
+
+    SlaveStats* stats = findSlaveStats(address);
+    if (stats) countUp(stats->requests);
+
+    // Adres 0 to rozgłoszenie - slave'y nie odpowiadają
+    _pending = address != 0;
+    _pendingEndMicros = _lastByteMicros;
+    _pendingTime = _clock.millis();
+    return FrameDirection::REQUEST;
 }
 
-uint16_t ModbusAnalyzer::calculateCRC16(uint8_t* buffer, uint8_t length) const {
-    uint16_t crc = 0xFFFF;
-    for (uint8_t pos = 0; pos < length; pos++) {
-        crc ^= (uint16_t)buffer[pos];
-        for (uint8_t i = 8; i != 0; i--) {
-            if ((crc & 0x0001) != 0) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
+void ModbusAnalyzer::printTransaction(const ModbusTransaction& transaction,
+                                      FrameDirection direction) const {
+    if (transaction.exceptionCode) {
+        Serial.print(F("Wyjatek 0x"));
+        Serial.print(transaction.exceptionCode, HEX);
+        Serial.print(F(": "));
+        Serial.println(ModbusPdu::exceptionName(transaction.exceptionCode));
+        return;
+    }
+    if (transaction.quantity == 0) return;
+
+    switch (transaction.function) {
+        case 0x05:
+            Serial.print(F("Cewka "));
+            Serial.print(transaction.startAddress);
+            Serial.println(transaction.value == 0xFF00 ? F(" = ON") : F(" = OFF"));
+            break;
+        case 0x06:
+            Serial.print(F("Rejestr "));
+            Serial.print(transaction.startAddress);
+            Serial.print(F(" = "));
+            Serial.println(transaction.value);
+            break;
+        case 0x17:
+            if (direction == FrameDirection::RESPONSE) {
+                Serial.print(F("Bajty danych: "));
+                Serial.println(transaction.quantity);
+                break;
             }
-        }
+            Serial.print(F("Odczyt "));
+            Serial.print(transaction.startAddress);
+            Serial.print(F(" x"));
+            Serial.print(transaction.quantity);
+            Serial.print(F(", zapis "));
+            Serial.print(transaction.writeAddress);
+            Serial.print(F(" x"));
+            Serial.println(transaction.writeQuantity);
+            break;
+        case 0x2B:
+            Serial.print(F("Obiekty identyfikacji: "));
+            Serial.println(transaction.quantity);
+            break;
+        default:
+            // Odpowiedź odczytu niesie tylko liczbę bajtów danych
+            if (direction == FrameDirection::RESPONSE && transaction.function <= 0x04) {
+                Serial.print(F("Bajty danych: "));
+                Serial.println(transaction.quantity);
+                break;
+            }
+            Serial.print(F("Zakres "));
+            Serial.print(transaction.startAddress);
+            Serial.print(F(" x"));
+            Serial.println(transaction.quantity);
+            break;
     }
-    return crc;
+}
+
+void ModbusAnalyzer::checkResponseTimeout() {
+    if (!_pending || _rxState == RxState::RECEIVING) return;
+    if (_clock.millis() - _pendingTime <= RESPONSE_TIMEOUT_MS) return;
+
+    SlaveStats* stats = findSlaveStats(_pendingRequest.address);
+    if (stats) countUp(stats->timeouts);
+    _flows.recordError(_pendingRequest);
+    _pending = false;
+}
+
+SlaveStats* ModbusAnalyzer::findSlaveStats(uint8_t address) {
+    for (uint8_t i = 0; i < _slaveStatsCount; i++) {
+        if (_slaveStats[i].address == address) return &_slaveStats[i];
+    }
+    if (_slaveStatsCount >= MAX_SLAVE_STATS) return nullptr;
+
+    SlaveStats* stats = &_slaveStats[_slaveStatsCount++];
+    stats->address = address;
+    stats->requests = 0;
+    stats->timeouts = 0;
+    stats->exceptions = 0;
+    stats->lastException = 0;
+    stats->turnaround.reset();
+    return stats;
+}
+
+void ModbusAnalyzer::resetSlaveStats() {
+    _slaveStatsCount = 0;
+    _pending = false;
+}
+
+void ModbusAnalyzer::clearBuffer() {
+    _transport.clear();
+    resetFrame();
 }
 
 void ModbusAnalyzer::showSummary() const {
@@ -205,25 +733,32 @@ void ModbusAnalyzer::showSummary() const {
     Serial.print(F("Predkosc transmisji: "));
     Serial.print(_masterInfo.baudRate);
     Serial.println(F(" baud"));
+    Serial.print(F("Czas ustalenia predkosci: "));
+    Serial.print(_masterInfo.baudLockTime);
+    Serial.println(F(" ms"));
     
-    Serial.println(F("\nOdpytywane adresy:"));
-    for (uint8_t i = 0; i < _masterInfo.addressCount; i++) {
+    Serial.print(F("\nOdpytywane adresy ("));
+    Serial.print(_masterInfo.addressCount);
+    Serial.println(F("):"));
+    for (uint16_t address = 0; address < MODBUS_ADDRESS_SPACE; address++) {
+        if (!_masterInfo.slaveAddresses.test(address)) continue;
         Serial.print(F("  ID: "));
-        Serial.println(_masterInfo.slaveAddresses[i]);
+        Serial.println(address);
     }
     
     Serial.println(F("\nUzywane funkcje:"));
-    for (uint8_t i = 0; i < _masterInfo.functionCount; i++) {
+    for (uint16_t function = 0; function < 256; function++) {
+        if (!_masterInfo.functions.test(function)) continue;
         Serial.print(F("  0x"));
-        Serial.print(_masterInfo.functions[i], HEX);
+        Serial.print(function, HEX);
         Serial.print(F(" - "));
-        Serial.println(getFunctionName(_masterInfo.functions[i]));
+        Serial.println(ModbusPdu::functionName(function));
     }
     
-    Serial.print(F("\nRejestr poczatkowy: "));
-    Serial.println(_masterInfo.startRegister);
-    Serial.print(F("Liczba rejestrow: "));
-    Serial.println(_masterInfo.registerCount);
+    Serial.println();
+    _flows.print(FlowTable::CAPACITY, _clock.millis());
+    Serial.print(F("Zapytania zapisu: "));
+    Serial.println(_masterInfo.writeRequests);
     
     // Statystyki czasowe
     Serial.println(F("\nStatystyki czasowe:"));
@@ -249,19 +784,104 @@ void ModbusAnalyzer::showSummary() const {
     Serial.println(_masterInfo.collisions);
     Serial.print(F("Nieprawidlowe ramki: "));
     Serial.println(_masterInfo.invalidFrames);
+    Serial.print(F("Naruszenia t1.5: "));
+    Serial.println(_masterInfo.t15Violations);
+    Serial.print(F("Naruszenia t3.5: "));
+    Serial.println(_masterInfo.t35Violations);
+    Serial.print(F("Przepelnienia bufora RX: "));
+    Serial.println(_masterInfo.rxOverflows);
+    showLineErrors();
+    if (_triggerArmed) {
+        Serial.print(F("Wyzwolenia: "));
+        Serial.println(_triggerCount);
+    }
+    if (_capture) {
+        Serial.print(F("Rekordy binarne: "));
+        Serial.print(_capture->recordCount());
+        Serial.print(F(", pominiete (pelny bufor): "));
+        Serial.println(_capture->droppedCount());
+    }
+    _busLoad.print();
+    showSlaveStats();
     Serial.println(F("==============================="));
 }
 
-const char* ModbusAnalyzer::getFunctionName(uint8_t function) const {
-    switch (function) {
-        case 0x01: return "Read Coils";
-        case 0x02: return "Read Discrete Inputs";
-        case 0x03: return "Read Holding Registers";
-        case 0x04: return "Read Input Registers";
-        case 0x05: return "Write Single Coil";
-        case 0x06: return "Write Single Register";
-        case 0x0F: return "Write Multiple Coils";
-        case 0x10: return "Write Multiple Registers";
-        default: return "Unknown Function";
+void ModbusAnalyzer::countLineErrors(uint8_t status) {
+    // Przed ustaleniem prędkości FE oznacza tylko złą prędkość
+    if (_baudState != BaudState::LOCKED) return;
+    if (status & RX_STATUS_FRAMING) _masterInfo.framingErrors++;
+    if (status & RX_STATUS_PARITY) _masterInfo.parityErrors++;
+    if (status & RX_STATUS_OVERRUN) _masterInfo.overruns++;
+}
+
+void ModbusAnalyzer::showLineErrors() const {
+    uint32_t line = _masterInfo.framingErrors + _masterInfo.parityErrors;
+    uint32_t lost = _masterInfo.overruns + _masterInfo.rxOverflows;
+
+    Serial.println(F("\nBledy linii (USART1):"));
+    Serial.print(F("Bledy ramki (FE): "));
+    Serial.println(_masterInfo.framingErrors);
+    Serial.print(F("Bledy parzystosci: "));
+    Serial.println(_masterInfo.parityErrors);
+    Serial.print(F("Przepelnienia USART (DOR): "));
+    Serial.println(_masterInfo.overruns);
+    Serial.print(F("Ramki z bledami linii: "));
+    Serial.println(_masterInfo.lineErrorFrames);
+    Serial.print(F("Ramki z utraconymi bajtami: "));
+    Serial.println(_masterInfo.lostByteFrames);
+
+    // Utrata bajtów to wina analizatora, FE/UPE - sygnału na linii
+    if (lost) {
+        Serial.println(F("Diagnoza: analizator nie nadaza - utracone bajty (DOR/bufor RX)"));
+    }
+    if (line) {
+        Serial.println(F("Diagnoza: bledy elektryczne - sprawdz okablowanie, terminacje, predkosc"));
+    }
+}
+
+void ModbusAnalyzer::showSlaveStats() const {
+    if (_slaveStatsCount == 0) return;
+
+    Serial.println(F("\nCzasy odpowiedzi slave'ow [us]:"));
+    Serial.println(F("ID\tZapyt.\tTimeout\tWyjatki\tMin\tSrednio\tMax"));
+    for (uint8_t i = 0; i < _slaveStatsCount; i++) {
+        const SlaveStats& stats = _slaveStats[i];
+        Serial.print(stats.address);
+        Serial.print(F("\t"));
+        Serial.print(stats.requests);
+        Serial.print(F("\t"));
+        Serial.print(stats.timeouts);
+        Serial.print(F("\t"));
+        Serial.print(stats.exceptions);
+        Serial.print(F("\t"));
+        if (stats.turnaround.samples == 0) {
+            Serial.println(F("-\t-\t-"));
+            continue;
+        }
+        Serial.print(stats.turnaround.minUs);
+        Serial.print(F("\t"));
+        Serial.print(stats.turnaround.averageUs());
+        Serial.print(F("\t"));
+        Serial.println(stats.turnaround.maxUs);
+    }
+
+    if (_masterInfo.addressCount > _slaveStatsCount) {
+        Serial.print(F("Adresy bez statystyk (limit "));
+        Serial.print(MAX_SLAVE_STATS);
+        Serial.print(F("): "));
+        Serial.println(_masterInfo.addressCount - _slaveStatsCount);
     }
-}
\ No newline at end of file
+
+    // Histogramy log2: kolejne kolumny to przedziały <256us, <512us, ...
+    Serial.println(F("\nHistogram (przedzialy log2 od 256 us):"));
+    for (uint8_t i = 0; i < _slaveStatsCount; i++) {
+        const SlaveStats& stats = _slaveStats[i];
+        Serial.print(stats.address);
+        Serial.print(F(":"));
+        for (uint8_t b = 0; b < LatencyHistogram::BUCKETS; b++) {
+            Serial.print(F(" "));
+            Serial.print(stats.turnaround.counts[b]);
+        }
+        Serial.println();
+    }
+}
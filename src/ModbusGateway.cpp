@@ -0,0 +1,266 @@
+#include "ModbusGateway.h"
+
+ModbusGateway::ModbusGateway(RtuTransport& transport, Clock& clock, Stream& host)
+    : _transport(transport)
+    , _clock(clock)
+    , _host(host)
+    , _running(false)
+    , _closing(false)
+    , _active(false)
+    , _rejected(false)
+    , _tag(0)
+    , _address(0)
+    , _head(0)
+    , _write(0)
+    , _used(0)
+    , _input(Input::SYNC)
+    , _inLength(0)
+    , _inRemaining(0)
+    , _inDiscard(false)
+    , _transactions(0)
+    , _ok(0)
+    , _crcErrors(0)
+    , _timeouts(0)
+    , _truncated(0)
+    , _invalid(0)
+    , _syncErrors(0)
+    , _maxQueued(0)
+    , _startMs(0)
+    , _elapsedMs(0)
+{
+}
+
+bool ModbusGateway::start(unsigned long baud) {
+    if (baud == 0) {
+        Serial.println(F("Bledna predkosc bramki"));
+        return false;
+    }
+    _closing = false;
+    _active = false;
+    _head = 0;
+    _write = 0;
+    _used = 0;
+    _input = Input::SYNC;
+    _transactions = 0;
+    _ok = 0;
+    _crcErrors = 0;
+    _timeouts = 0;
+    _truncated = 0;
+    _invalid = 0;
+    _syncErrors = 0;
+    _maxQueued = 0;
+    _elapsedMs = 0;
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _running = true;
+    _startMs = _clock.millis();
+
+    // Ostatni wiersz tekstu - dalej tylko rekordy binarne
+    Serial.print(F("Bramka RS485 @ "));
+    Serial.print(baud);
+    Serial.println(F(" baud, rekordy binarne (0x5A 0x00 - koniec)"));
+    return true;
+}
+
+void ModbusGateway::stop() {
+    if (!_running) return;
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+}
+
+void ModbusGateway::update() {
+    if (!_running) return;
+
+    readHost();
+    _transport.poll();
+    if (_active) {
+        if (!_rejected && _transport.busy()) return;
+        if (!reportResult()) return;
+        _active = false;
+    }
+    // Następne zapytanie od razu - transport sam odczeka t3.5
+    if (_used) {
+        startNext();
+        return;
+    }
+    if (_closing) finish();
+}
+
+void ModbusGateway::readHost() {
+    while (!_closing) {
+        if (_input == Input::ROOM) {
+            uint8_t size = ENTRY_HEADER + (_inDiscard ? 0 : _inLength);
+            if (QUEUE_SIZE - _used < size) return;
+            push(_inDiscard ? 0 : _inLength);
+            _input = Input::TAG;
+            continue;
+        }
+        if (_host.available() <= 0) return;
+        uint8_t data = _host.read();
+
+        switch (_input) {
+            case Input::SYNC:
+                if (data == REQUEST_SYNC) {
+                    _input = Input::LENGTH;
+                } else {
+                    _syncErrors++;
+                }
+                break;
+            case Input::LENGTH:
+                if (data == 0) {
+                    // Koniec: reszta kolejki jeszcze zostanie wykonana
+                    _closing = true;
+                    _input = Input::SYNC;
+                    return;
+                }
+                _inLength = data;
+                _inRemaining = data;
+                _inDiscard = data < 2 || data > MAX_REQUEST;
+                _input = Input::ROOM;
+                break;
+            case Input::TAG:
+                push(data);
+                _input = Input::TIMEOUT;
+                break;
+            case Input::TIMEOUT:
+                push(data);
+                _input = Input::DATA;
+                break;
+            default:
+                if (!_inDiscard) push(data);
+                if (--_inRemaining == 0) {
+                    _used += ENTRY_HEADER + (_inDiscard ? 0 : _inLength);
+                    if (_used > _maxQueued) _maxQueued = _used;
+                    _input = Input::SYNC;
+                }
+                break;
+        }
+    }
+}
+
+void ModbusGateway::startNext() {
+    uint8_t length = pop();
+    _tag = pop();
+    uint8_t timeoutMs = pop();
+    uint8_t frame[MAX_REQUEST];
+    for (uint8_t i = 0; i < length; i++) frame[i] = pop();
+    _used -= ENTRY_HEADER + length;
+    _active = true;
+
+    _rejected = length == 0;
+    if (_rejected) return;
+    _address = frame[0];
+    uint32_t windowUs = (timeoutMs ? timeoutMs : DEFAULT_TIMEOUT_MS) * 1000UL;
+    _transport.request(frame, length, windowUs, this);
+    _transactions++;
+}
+
+bool ModbusGateway::reportResult() {
+    if (_rejected) {
+        if (_host.availableForWrite() < RESULT_HEADER_SIZE) return false;
+        _invalid++;
+        writeResult(Status::INVALID, 0, nullptr, 0);
+        return true;
+    }
+
+    const uint8_t* reply = _transport.response();
+    uint16_t count = _transport.responseCount();
+    uint8_t length = _transport.responseLength();
+    Status status;
+    uint32_t timeUs = 0;
+    uint8_t size = 0;
+    switch (_transport.result()) {
+        case RtuTransport::Result::RESPONSE:
+            timeUs = _transport.turnaroundUs();
+            if (count > length) {
+                status = Status::TRUNCATED;
+                size = length;
+            } else {
+                status = Status::OK;
+                size = length - 2;
+            }
+            break;
+        case RtuTransport::Result::TIMEOUT:
+            status = _address == 0 ? Status::BROADCAST : Status::TIMEOUT;
+            break;
+        default:
+            status = Status::CRC_ERROR;
+            timeUs = _transport.turnaroundUs();
+            size = length;
+            break;
+    }
+    // Wynik czeka na miejsce w USB zamiast przepaść
+    if (_host.availableForWrite() < RESULT_HEADER_SIZE + size) return false;
+
+    switch (status) {
+        case Status::OK: _ok++; break;
+        case Status::TRUNCATED: _truncated++; break;
+        case Status::TIMEOUT: _timeouts++; break;
+        case Status::CRC_ERROR: _crcErrors++; break;
+        default: break;
+    }
+    writeResult(status, timeUs, reply, size);
+    return true;
+}
+
+void ModbusGateway::writeResult(Status status, uint32_t timeUs, const uint8_t* data, uint8_t length) {
+    uint8_t header[RESULT_HEADER_SIZE] = {
+        RESULT_SYNC,
+        length,
+        _tag,
+        (uint8_t)status,
+        (uint8_t)(timeUs & 0xFF),
+        (uint8_t)((timeUs >> 8) & 0xFF),
+        (uint8_t)((timeUs >> 16) & 0xFF),
+        (uint8_t)(timeUs >> 24)
+    };
+    _host.write(header, RESULT_HEADER_SIZE);
+    if (length) _host.write(data, length);
+}
+
+void ModbusGateway::push(uint8_t data) {
+    _queue[_write] = data;
+    if (++_write == QUEUE_SIZE) _write = 0;
+}
+
+uint8_t ModbusGateway::pop() {
+    uint8_t data = _queue[_head];
+    if (++_head == QUEUE_SIZE) _head = 0;
+    return data;
+}
+
+void ModbusGateway::finish() {
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+}
+
+void ModbusGateway::showSummary() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+
+    Serial.println(F("\n=== Bramka RS485 ==="));
+    Serial.print(F("Transakcje: "));
+    Serial.print(_transactions);
+    Serial.print(F(", poprawne: "));
+    Serial.print(_ok);
+    Serial.print(F(", transakcje/s: "));
+    Serial.println(elapsedMs ? _transactions * 1000 / elapsedMs : 0);
+    Serial.print(F("Bledy CRC: "));
+    Serial.print(_crcErrors);
+    Serial.print(F(", bez odpowiedzi: "));
+    Serial.print(_timeouts);
+    Serial.print(F(", obciete: "));
+    Serial.print(_truncated);
+    Serial.print(F(", bledne zapytania: "));
+    Serial.println(_invalid);
+    Serial.print(F("Bajty poza rekordami: "));
+    Serial.print(_syncErrors);
+    Serial.print(F(", kolejka maks.: "));
+    Serial.print(_maxQueued);
+    Serial.print('/');
+    Serial.print(QUEUE_SIZE);
+    Serial.print(F(" B, czas: "));
+    Serial.print(elapsedMs);
+    Serial.println(F(" ms"));
+}
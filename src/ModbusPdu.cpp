@@ -0,0 +1,161 @@
+#include "ModbusPdu.h"
+
+static uint16_t readWord(const uint8_t* data) {
+    return ((uint16_t)data[0] << 8) | data[1];
+}
+
+uint16_t ModbusPdu::expectedLength(const uint8_t* frame, uint16_t received, FrameDirection direction) {
+    if (received < 2) return LENGTH_NEED_MORE;
+
+    uint8_t function = frame[1];
+    // Odpowiedź wyjątkiem: adres, funkcja | 0x80, kod wyjątku, CRC
+    if (function & 0x80) return 5;
+
+    if (direction == FrameDirection::REQUEST) {
+        switch (function) {
+            case 0x01: case 0x02: case 0x03:
+            case 0x04: case 0x05: case 0x06:
+                return 8;
+            case 0x0F: case 0x10:
+                // Adres, funkcja, start, ilość, liczba bajtów, dane, CRC
+                if (received < 7) return LENGTH_NEED_MORE;
+                return 9 + frame[6];
+            case 0x17:
+                if (received < 11) return LENGTH_NEED_MORE;
+                return 13 + frame[10];
+            case 0x2B:
+                if (received < 3) return LENGTH_NEED_MORE;
+                return frame[2] == 0x0E ? 7 : LENGTH_UNKNOWN;
+            default:
+                return LENGTH_UNKNOWN;
+        }
+    }
+
+    switch (function) {
+        case 0x01: case 0x02: case 0x03:
+        case 0x04: case 0x17:
+            if (received < 3) return LENGTH_NEED_MORE;
+            return 5 + frame[2];
+        case 0x05: case 0x06: case 0x0F: case 0x10:
+            return 8;
+        case 0x2B:
+            if (received < 3) return LENGTH_NEED_MORE;
+            return frame[2] == 0x0E ? deviceIdLength(frame, received) : LENGTH_UNKNOWN;
+        default:
+            return LENGTH_UNKNOWN;
+    }
+}
+
+// Odpowiedź 0x2B/0x0E: nagłówek 8 bajtów, potem obiekty (id, długość, wartość)
+uint16_t ModbusPdu::deviceIdLength(const uint8_t* frame, uint16_t received) {
+    const uint8_t HEADER = 8;
+    if (received < HEADER) return LENGTH_NEED_MORE;
+
+    uint8_t objects = frame[7];
+    uint16_t position = HEADER;
+    for (uint8_t i = 0; i < objects; i++) {
+        if (received < position + 2) return LENGTH_NEED_MORE;
+        position += 2 + frame[position + 1];
+    }
+    return position + 2;
+}
+
+bool ModbusPdu::decode(const uint8_t* frame, uint16_t length, FrameDirection direction,
+                       ModbusTransaction& out) {
+    out.address = 0;
+    out.function = 0;
+    out.exceptionCode = 0;
+    out.startAddress = 0;
+    out.quantity = 0;
+    out.value = 0;
+    out.writeAddress = 0;
+    out.writeQuantity = 0;
+    if (length < 4) return false;
+
+    uint16_t expected = expectedLength(frame, length, direction);
+    if (expected != LENGTH_UNKNOWN && expected != length) return false;
+
+    out.address = frame[0];
+    out.function = frame[1] & 0x7F;
+    if (frame[1] & 0x80) {
+        out.exceptionCode = frame[2];
+        return true;
+    }
+    // Nieznana funkcja: tylko adres i kod funkcji
+    if (expected == LENGTH_UNKNOWN) return true;
+
+    if (direction == FrameDirection::REQUEST) {
+        switch (out.function) {
+            case 0x01: case 0x02: case 0x03: case 0x04:
+            case 0x0F: case 0x10:
+                out.startAddress = readWord(&frame[2]);
+                out.quantity = readWord(&frame[4]);
+                break;
+            case 0x05: case 0x06:
+                out.startAddress = readWord(&frame[2]);
+                out.quantity = 1;
+                out.value = readWord(&frame[4]);
+                break;
+            case 0x17:
+                out.startAddress = readWord(&frame[2]);
+                out.quantity = readWord(&frame[4]);
+                out.writeAddress = readWord(&frame[6]);
+                out.writeQuantity = readWord(&frame[8]);
+                break;
+            case 0x2B:
+                out.value = frame[4];   // Identyfikator obiektu
+                break;
+        }
+        return true;
+    }
+
+    switch (out.function) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x17:
+            out.quantity = frame[2];    // Liczba bajtów danych
+            break;
+        case 0x05: case 0x06:
+            out.startAddress = readWord(&frame[2]);
+            out.quantity = 1;
+            out.value = readWord(&frame[4]);
+            break;
+        case 0x0F: case 0x10:
+            out.startAddress = readWord(&frame[2]);
+            out.quantity = readWord(&frame[4]);
+            break;
+        case 0x2B:
+            out.quantity = frame[7];    // Liczba obiektów
+            break;
+    }
+    return true;
+}
+
+const __FlashStringHelper* ModbusPdu::functionName(uint8_t function) {
+    switch (function & 0x7F) {
+        case 0x01: return F("Read Coils");
+        case 0x02: return F("Read Discrete Inputs");
+        case 0x03: return F("Read Holding Registers");
+        case 0x04: return F("Read Input Registers");
+        case 0x05: return F("Write Single Coil");
+        case 0x06: return F("Write Single Register");
+        case 0x0F: return F("Write Multiple Coils");
+        case 0x10: return F("Write Multiple Registers");
+        case 0x17: return F("Read/Write Multiple Registers");
+        case 0x2B: return F("Read Device Identification");
+        default: return F("Unknown Function");
+    }
+}
+
+const __FlashStringHelper* ModbusPdu::exceptionName(uint8_t code) {
+    switch (code) {
+        case 0x01: return F("Illegal Function");
+        case 0x02: return F("Illegal Data Address");
+        case 0x03: return F("Illegal Data Value");
+        case 0x04: return F("Server Device Failure");
+        case 0x05: return F("Acknowledge");
+        case 0x06: return F("Server Device Busy");
+        case 0x08: return F("Memory Parity Error");
+        case 0x0A: return F("Gateway Path Unavailable");
+        case 0x0B: return F("Gateway Target No Response");
+        default: return F("Unknown Exception");
+    }
+}
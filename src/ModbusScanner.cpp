@@ -1,203 +1,356 @@
 #include "ModbusScanner.h"
 
-const unsigned long ModbusScanner::BAUD_RATES[] = {9600, 19200, 38400, 57600, 115200};
+const unsigned long ModbusScanner::BAUD_RATES[] PROGMEM = {9600, 19200, 38400, 57600, 115200};
 const uint8_t ModbusScanner::BAUD_COUNT = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
 
-ModbusScanner::ModbusScanner(HardwareSerial& modbusSerial, uint8_t dirPin)
-    : _serial(modbusSerial)
-    , _dirPin(dirPin)
+void ScanTiming::set(uint16_t turnaround, uint8_t retries, uint16_t slowTimeout) {
+    turnaroundMs = turnaround;
+    slowRetries = retries;
+    slowTimeoutMs = slowTimeout ? slowTimeout : LEGACY_TIMEOUT_MS;
+}
+
+void ScanTiming::show() const {
+    Serial.print(F("Okno odpowiedzi: "));
+    if (turnaroundMs) {
+        Serial.print(turnaroundMs);
+        Serial.print(F(" ms + czas ramki"));
+    } else {
+        Serial.print(LEGACY_TIMEOUT_MS);
+        Serial.print(F(" ms (stale)"));
+    }
+    Serial.print(F(", spoznione adresy: "));
+    Serial.print(slowRetries);
+    Serial.print(F(" x "));
+    Serial.print(slowTimeoutMs);
+    Serial.println(F(" ms"));
+}
+
+ModbusScanner::ModbusScanner(RtuTransport& transport, Clock& clock, ScanResult& result,
+                             const ScanTiming& timing)
+    : _transport(transport)
+    , _clock(clock)
     , _scanning(false)
+    , _mode(ScanMode::FULL)
+    , _step(Step::NEXT)
+    , _target(0)
+    , _targetBaud(0)
+    , _targetKnown(false)
+    , _targetSlow(false)
+    , _lateAddress(0)
+    , _attempt(0)
+    , _attempts(0)
     , _currentAddress(1)
     , _currentBaudIndex(0)
-    , _foundDevices(0)
-    , _bufferIndex(0)
+    , _sweepBaudCount(BAUD_COUNT)
+    , _scanStartTime(0)
+    , _result(result)
     , _lastActivityTime(0)
+    , _timing(timing)
+    , _cache(nullptr)
+    , _knownCount(0)
+    , _verifyIndex(0)
 {
-    _devices = new DeviceInfo[MAX_DEVICES];
 }
 
 void ModbusScanner::begin() {
-    pinMode(_dirPin, OUTPUT);
-    digitalWrite(_dirPin, LOW);
-    _serial.begin(BAUD_RATES[0]);
+    _transport.begin(pgm_read_dword(&BAUD_RATES[0]));
 }
 
-void ModbusScanner::startScan() {
+void ModbusScanner::setDeviceCache(DeviceCache* cache) {
+    _cache = cache;
+}
+
+void ModbusScanner::startScan(ScanMode mode) {
     _scanning = true;
+    _mode = mode;
     _currentAddress = 1;
     _currentBaudIndex = 0;
-    _foundDevices = 0;
-    _bufferIndex = 0;
-    _lastActivityTime = millis();
-    _serial.begin(BAUD_RATES[0]);
-    clearBuffer();
+    _result.count = 0;
+    _step = Step::NEXT;
+    _knownCount = 0;
+    _verifyIndex = 0;
+    _lateAddress = 0;
+    _lastActivityTime = _clock.millis();
+    _scanStartTime = _lastActivityTime;
+
+    if (_mode != ScanMode::FULL) {
+        _knownCount = _cache ? _cache->load(_known, MAX_DEVICES) : 0;
+        if (_knownCount == 0) {
+            Serial.println(F("Brak zapamietanych urzadzen - pelne skanowanie"));
+            _mode = ScanMode::FULL;
+        }
+    }
+
+    switch (_mode) {
+        case ScanMode::FULL:
+            _sweepBaudCount = BAUD_COUNT;
+            break;
+        case ScanMode::VERIFY:
+            _sweepBaudCount = 0;
+            break;
+        case ScanMode::INCREMENTAL:
+            _sweepBaudCount = countKnownBauds();
+            break;
+    }
+
+    unsigned long firstBaud = _knownCount ? _known[0].baudRate : pgm_read_dword(&BAUD_RATES[0]);
+    _transport.cancel();
+    if (firstBaud != _transport.baud()) _transport.setBaud(firstBaud);
+    _transport.clear();
     Serial.println(F("Start skanowania..."));
+    if (_knownCount) {
+        Serial.print(F("Zapamietane urzadzenia: "));
+        Serial.println(_knownCount);
+    }
 }
 
 void ModbusScanner::stopScan() {
     _scanning = false;
-    digitalWrite(_dirPin, LOW);
+    _transport.cancel();
     Serial.println(F("Skanowanie zatrzymane"));
 }
 
 void ModbusScanner::update() {
     if (!_scanning) return;
 
-    if (testDevice(_currentAddress)) {
-        if (_foundDevices < MAX_DEVICES) {
-            _devices[_foundDevices].address = _currentAddress;
-            _devices[_foundDevices].baudRate = BAUD_RATES[_currentBaudIndex];
-            
-            Serial.print(F("\n*** Znaleziono urzadzenie "));
-            Serial.print(_foundDevices + 1);
-            Serial.println(F(" ***"));
-            Serial.print(F("Adres: "));
-            Serial.print(_currentAddress);
-            Serial.print(F(", Predkosc: "));
-            Serial.print(BAUD_RATES[_currentBaudIndex]);
-            Serial.println(F(" baud"));
-            
-            // Odczyt rejestrów po znalezieniu urządzenia
-            readRegisters(_currentAddress);
-            
-            _foundDevices++;
+    _transport.poll();
+    if (_transport.busy()) return;
+
+    switch (_step) {
+        case Step::NEXT:
+            startNextTarget();
+            break;
+        case Step::PROBING:
+            handleProbe();
+            break;
+        case Step::READING:
+            handleRegisters();
+            _step = Step::NEXT;
+            break;
+    }
+}
+
+void ModbusScanner::startNextTarget() {
+    // Najpierw zapamiętane urządzenia, potem przeszukiwanie adresów
+    if (_verifyIndex < _knownCount) {
+        const DeviceInfo& device = _known[_verifyIndex++];
+        beginTarget(device.address, device.baudRate, VERIFY_RETRIES, true);
+        return;
+    }
+
+    // Adres, którego odpowiedź przyszła w oknie następnego: powolny slave,
+    // sprawdzany jeszcze raz z długim oknem na tej samej prędkości
+    if (_lateAddress) {
+        uint8_t address = _lateAddress;
+        _lateAddress = 0;
+        if (_timing.slowRetries) {
+            beginTarget(address, _targetBaud, _timing.slowRetries, false, true);
+            return;
         }
     }
 
-    _currentAddress++;
-    if (_currentAddress > MAX_MODBUS_ADDRESS) {
-        _currentAddress = 1;
-        _currentBaudIndex++;
-        if (_currentBaudIndex >= BAUD_COUNT) {
-            _scanning = false;
-            Serial.println(F("\nSkanowanie zakonczone"));
-        } else {
-            changeBaudRate();
+    while (_currentBaudIndex < _sweepBaudCount) {
+        unsigned long baud = sweepBaud(_currentBaudIndex);
+        uint8_t address = _currentAddress;
+        if (++_currentAddress > MAX_MODBUS_ADDRESS) {
+            _currentAddress = 1;
+            _currentBaudIndex++;
         }
+        // Zapamiętane adresy nie są ponownie odpytywane w przeszukiwaniu
+        if (isKnown(address, baud)) continue;
+
+        beginTarget(address, baud, 1, false);
+        return;
     }
-}
 
-bool ModbusScanner::isScanning() const {
-    return _scanning;
+    finishScan();
 }
 
-uint8_t ModbusScanner::getFoundDevicesCount() const {
-    return _foundDevices;
+void ModbusScanner::beginTarget(uint8_t address, unsigned long baud, uint8_t attempts, bool known,
+                                bool slow) {
+    _target = address;
+    _targetBaud = baud;
+    _targetKnown = known;
+    _targetSlow = slow;
+    _attempt = 0;
+    _attempts = attempts;
+    if (baud != _transport.baud()) setBaud(baud);
+    sendProbe();
 }
 
-const DeviceInfo* ModbusScanner::getFoundDevices() const {
-    return _devices;
+void ModbusScanner::sendProbe() {
+    const uint8_t query[] = {_target, 0x03, 0x00, 0x00, 0x00, 0x01};
+    uint32_t windowUs = _targetSlow
+        ? _timing.slowTimeoutMs * 1000UL
+        : responseWindowUs(PROBE_REPLY_SIZE);
+    _transport.request(query, sizeof(query), windowUs);
+    _step = Step::PROBING;
 }
 
-void ModbusScanner::changeBaudRate() {
-    clearBuffer();
-    _serial.end();
-    delay(10);
-    _serial.begin(BAUD_RATES[_currentBaudIndex]);
-    Serial.print(F("\nZmiana predkosci na: "));
-    Serial.print(BAUD_RATES[_currentBaudIndex]);
-    Serial.println(F(" baud"));
-}
+void ModbusScanner::handleProbe() {
+    const uint8_t* reply = _transport.response();
+    // Odpowiedź wyjątkiem (0x83) także potwierdza obecność urządzenia
+    bool found = _transport.result() == RtuTransport::Result::RESPONSE
+        && reply[0] == _target
+        && (reply[1] & 0x7F) == 0x03;
 
-bool ModbusScanner::testDevice(uint8_t address) {
-    digitalWrite(_dirPin, HIGH);
-    delay(1);
-
-    uint8_t query[] = {address, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
-    uint16_t crc = calculateCRC16(query, 6);
-    query[6] = crc & 0xFF;
-    query[7] = (crc >> 8) & 0xFF;
-
-    _serial.write(query, 8);
-    _serial.flush();
-    digitalWrite(_dirPin, LOW);
-    delay(20);
-
-    _bufferIndex = 0;
-    uint32_t startTime = millis();
-
-    while ((millis() - startTime) < 100 && _bufferIndex < MAX_FRAME_SIZE) {
-        if (_serial.available()) {
-            _buffer[_bufferIndex++] = _serial.read();
-            if (_bufferIndex >= 5) {
-                if (_buffer[0] == address && _buffer[1] == 0x03) {
-                    clearBuffer();
-                    return true;
-                }
-            }
+    if (found) {
+        if (addDevice(_target, _targetBaud)) {
+            // Odczyt rejestrów po znalezieniu urządzenia
+            const uint8_t query[] = {_target, 0x03, 0x00, 0x00, 0x00, 0x0A};
+            _transport.request(query, sizeof(query), responseWindowUs(REGISTERS_REPLY_SIZE));
+            _step = Step::READING;
+            return;
         }
+        _step = Step::NEXT;
+        return;
     }
 
-    clearBuffer();
-    return false;
+    // Poprawna odpowiedź innego adresu w przeszukiwaniu: spóźniona odpowiedź
+    // na poprzednie zapytanie. Bieżący adres dostaje jeszcze jedną próbę,
+    // bo jego odpowiedź mogła zostać zagłuszona
+    if (!_targetKnown && !_targetSlow && !_lateAddress
+        && _transport.result() == RtuTransport::Result::RESPONSE
+        && reply[0] != _target && reply[0] >= 1 && reply[0] <= MAX_MODBUS_ADDRESS
+        && (reply[1] & 0x7F) == 0x03 && !isFound(reply[0], _targetBaud)) {
+        _lateAddress = reply[0];
+        sendProbe();
+        return;
+    }
+
+    if (++_attempt < _attempts) {
+        sendProbe();
+        return;
+    }
+
+    if (_targetKnown) {
+        Serial.print(F("\nBrak odpowiedzi zapamietanego urzadzenia: adres "));
+        Serial.print(_target);
+        Serial.print(F(" @ "));
+        Serial.print(_targetBaud);
+        Serial.println(F(" baud"));
+    }
+    _step = Step::NEXT;
 }
 
-bool ModbusScanner::readRegisters(uint8_t deviceAddr) {
-    digitalWrite(_dirPin, HIGH);
-    delay(1);
-    
-    uint8_t query[] = {deviceAddr, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00};
-    uint16_t crc = calculateCRC16(query, 6);
-    query[6] = crc & 0xFF;
-    query[7] = (crc >> 8) & 0xFF;
-    
-    _serial.write(query, 8);
-    _serial.flush();
-    digitalWrite(_dirPin, LOW);
-    delay(100);
+void ModbusScanner::handleRegisters() {
+    const uint8_t* reply = _transport.response();
+    if (_transport.result() != RtuTransport::Result::RESPONSE
+        || _transport.responseLength() != REGISTERS_REPLY_SIZE
+        || reply[0] != _target || reply[1] != 0x03 || reply[2] != 20) {
+        return;
+    }
 
-    _bufferIndex = 0;
-    uint32_t startTime = millis();
+    Serial.println(F("\nRejestr | Wartosc"));
+    Serial.println(F("------------------"));
     
-    while ((millis() - startTime) < 200 && _bufferIndex < MAX_FRAME_SIZE) {
-        if (_serial.available()) {
-            _buffer[_bufferIndex++] = _serial.read();
-        }
+    for (uint8_t i = 0; i < 10; i++) {
+        uint16_t value = (reply[3 + i*2] << 8) | reply[4 + i*2];
+        Serial.print(i);
+        Serial.print(F("\t"));
+        Serial.print(value);
+        Serial.print(F("\t(0x"));
+        if (value < 0x1000) Serial.print('0');
+        if (value < 0x100) Serial.print('0');
+        if (value < 0x10) Serial.print('0');
+        Serial.print(value, HEX);
+        Serial.println(F(")"));
     }
-    
-    if (_bufferIndex >= 5 && _buffer[0] == deviceAddr && _buffer[1] == 0x03) {
-        Serial.println(F("\nRejestr | Wartosc"));
-        Serial.println(F("------------------"));
-        
-        for (uint8_t i = 0; i < 10; i++) {
-            uint16_t value = (_buffer[3 + i*2] << 8) | _buffer[4 + i*2];
-            Serial.print(i);
-            Serial.print(F("\t"));
-            Serial.print(value);
-            Serial.print(F("\t(0x"));
-            if (value < 0x1000) Serial.print('0');
-            if (value < 0x100) Serial.print('0');
-            if (value < 0x10) Serial.print('0');
-            Serial.print(value, HEX);
-            Serial.println(F(")"));
-        }
-        clearBuffer();
-        return true;
+}
+
+void ModbusScanner::finishScan() {
+    _scanning = false;
+    Serial.print(F("\nSkanowanie zakonczone w "));
+    Serial.print(_clock.millis() - _scanStartTime);
+    Serial.println(F(" ms"));
+
+    // Weryfikacja tylko sprawdza listę, nie nadpisuje jej
+    if (_cache && _mode != ScanMode::VERIFY) {
+        _cache->save(_result.devices, _result.count);
+        Serial.println(F("Lista urzadzen zapisana w EEPROM"));
     }
+}
+
+bool ModbusScanner::addDevice(uint8_t address, unsigned long baud) {
+    if (_result.count >= MAX_DEVICES) return false;
 
-    clearBuffer();
+    DeviceInfo& device = _result.devices[_result.count++];
+    device.address = address;
+    device.baudRate = baud;
+
+    Serial.print(F("\n*** Znaleziono urzadzenie "));
+    Serial.print(_result.count);
+    Serial.println(F(" ***"));
+    Serial.print(F("Adres: "));
+    Serial.print(address);
+    Serial.print(F(", Predkosc: "));
+    Serial.print(baud);
+    Serial.println(F(" baud"));
+    return true;
+}
+
+bool ModbusScanner::isKnown(uint8_t address, unsigned long baud) const {
+    for (uint8_t i = 0; i < _knownCount; i++) {
+        if (_known[i].address == address && _known[i].baudRate == baud) return true;
+    }
     return false;
 }
 
-uint16_t ModbusScanner::calculateCRC16(uint8_t* buffer, uint8_t length) const {
-    uint16_t crc = 0xFFFF;
-    for (uint8_t pos = 0; pos < length; pos++) {
-        crc ^= (uint16_t)buffer[pos];
-        for (uint8_t i = 8; i != 0; i--) {
-            if ((crc & 0x0001) != 0) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
+bool ModbusScanner::isFound(uint8_t address, unsigned long baud) const {
+    for (uint8_t i = 0; i < _result.count; i++) {
+        const DeviceInfo& device = _result.devices[i];
+        if (device.address == address && device.baudRate == baud) return true;
     }
-    return crc;
+    return isKnown(address, baud);
 }
 
-void ModbusScanner::clearBuffer() {
-    while (_serial.available()) {
-        _serial.read();
+bool ModbusScanner::isFirstAtBaud(uint8_t i) const {
+    for (uint8_t j = 0; j < i; j++) {
+        if (_known[j].baudRate == _known[i].baudRate) return false;
     }
-    _bufferIndex = 0;
-}
\ No newline at end of file
+    return true;
+}
+
+uint8_t ModbusScanner::countKnownBauds() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < _knownCount; i++) {
+        if (isFirstAtBaud(i)) count++;
+    }
+    return count;
+}
+
+// Prędkość nr index przeszukiwania: z tabeli albo kolejna różna z listy
+// zapamiętanych (bez osobnej tablicy prędkości w obiekcie)
+unsigned long ModbusScanner::sweepBaud(uint8_t index) const {
+    if (_mode == ScanMode::FULL) return pgm_read_dword(&BAUD_RATES[index]);
+    for (uint8_t i = 0; i < _knownCount; i++) {
+        if (isFirstAtBaud(i) && index-- == 0) return _known[i].baudRate;
+    }
+    return 0;
+}
+
+bool ModbusScanner::isScanning() const {
+    return _scanning;
+}
+
+uint8_t ModbusScanner::getFoundDevicesCount() const {
+    return _result.count;
+}
+
+const DeviceInfo* ModbusScanner::getFoundDevices() const {
+    return _result.devices;
+}
+
+void ModbusScanner::setBaud(unsigned long baud) {
+    // Transport odczeka BAUD_SETTLE_MS przed nadaniem, bez blokowania pętli
+    _transport.setBaud(baud);
+    Serial.print(F("\nZmiana predkosci na: "));
+    Serial.print(baud);
+    Serial.println(F(" baud"));
+}
+
+uint32_t ModbusScanner::responseWindowUs(uint8_t replySize) const {
+    if (_timing.turnaroundMs == 0) return ScanTiming::LEGACY_TIMEOUT_MS * 1000UL;
+    // Czas reakcji slave'a + nadanie całej oczekiwanej odpowiedzi
+    return _timing.turnaroundMs * 1000UL + replySize * _transport.timing().charUs;
+}
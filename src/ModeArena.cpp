@@ -0,0 +1,102 @@
+#include <new>
+#include "ModeArena.h"
+
+ModeArena::ModeArena(RtuTransport& transport, Clock& clock, Stream& host, DeviceCache& cache)
+    : _transport(transport)
+    , _clock(clock)
+    , _host(host)
+    , _cache(cache)
+    , _kind(Kind::NONE)
+{
+}
+
+ModeArena::~ModeArena() {
+    release();
+}
+
+ModbusScanner& ModeArena::scanner() {
+    if (occupy(Kind::SCANNER)) {
+        new (&_slot.scanner) ModbusScanner(_transport, _clock, _scanResult, _scanTiming);
+        _slot.scanner.setDeviceCache(&_cache);
+    }
+    return _slot.scanner;
+}
+
+LoadTester& ModeArena::loadTester() {
+    if (occupy(Kind::LOAD_TEST)) new (&_slot.loadTester) LoadTester(_transport, _clock);
+    return _slot.loadTester;
+}
+
+RegisterMapper& ModeArena::mapper() {
+    if (occupy(Kind::MAPPER)) new (&_slot.mapper) RegisterMapper(_transport, _clock);
+    return _slot.mapper;
+}
+
+RegisterDump& ModeArena::registerDump() {
+    if (occupy(Kind::DUMP)) new (&_slot.registerDump) RegisterDump(_transport, _clock);
+    return _slot.registerDump;
+}
+
+SlaveEmulator& ModeArena::emulator() {
+    if (occupy(Kind::EMULATOR)) new (&_slot.emulator) SlaveEmulator(_transport, _clock, _emulatorFaults);
+    return _slot.emulator;
+}
+
+ModbusGateway& ModeArena::gateway() {
+    if (occupy(Kind::GATEWAY)) new (&_slot.gateway) ModbusGateway(_transport, _clock, _host);
+    return _slot.gateway;
+}
+
+RegisterWatch& ModeArena::registerWatch() {
+    if (occupy(Kind::WATCH)) new (&_slot.registerWatch) RegisterWatch(_transport, _clock, _watchBlocks);
+    return _slot.registerWatch;
+}
+
+#ifdef SD_LOG
+ModeArena::SdLog& ModeArena::sdLog() {
+    if (occupy(Kind::SD_LOGGER)) new (&_slot.sdLog) SdLog(_clock);
+    return _slot.sdLog;
+}
+#endif
+
+// true - obszar przekazany nowemu rodzajowi, obiekt trzeba utworzyć
+bool ModeArena::occupy(Kind kind) {
+    if (_kind == kind) return false;
+    release();
+    _kind = kind;
+    return true;
+}
+
+void ModeArena::release() {
+    switch (_kind) {
+        case Kind::SCANNER:
+            _slot.scanner.~ModbusScanner();
+            break;
+        case Kind::LOAD_TEST:
+            _slot.loadTester.~LoadTester();
+            break;
+        case Kind::MAPPER:
+            _slot.mapper.~RegisterMapper();
+            break;
+        case Kind::DUMP:
+            _slot.registerDump.~RegisterDump();
+            break;
+        case Kind::EMULATOR:
+            _slot.emulator.~SlaveEmulator();
+            break;
+        case Kind::GATEWAY:
+            _slot.gateway.~ModbusGateway();
+            break;
+        case Kind::WATCH:
+            _slot.registerWatch.~RegisterWatch();
+            break;
+#ifdef SD_LOG
+        case Kind::SD_LOGGER:
+            _slot.sdLog.~SdLog();
+            break;
+#endif
+        default:
+            break;
+    }
+    _kind = Kind::NONE;
+}
@@ -0,0 +1,75 @@
+#include "Profiler.h"
+
+#ifdef PROFILE
+
+Clock* Profiler::_clock = nullptr;
+Profiler::StageStats Profiler::_stages[Profiler::STAGE_COUNT];
+uint32_t Profiler::_slowLoops = 0;
+uint32_t Profiler::_charUs = 0;
+
+void Profiler::begin(Clock& clock) {
+    _clock = &clock;
+    reset();
+}
+
+void Profiler::record(ProfileStage stage, uint32_t startUs) {
+    if (!_clock) return;
+    uint32_t elapsed = _clock->micros() - startUs;
+    StageStats& stats = _stages[(uint8_t)stage];
+    stats.count++;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxUs) stats.maxUs = elapsed;
+}
+
+void Profiler::endLoop(uint32_t startUs, uint32_t charUs) {
+    if (!_clock) return;
+    uint32_t elapsed = _clock->micros() - startUs;
+    StageStats& stats = _stages[(uint8_t)ProfileStage::LOOP];
+    stats.count++;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxUs) stats.maxUs = elapsed;
+    _charUs = charUs;
+    if (elapsed > charUs) _slowLoops++;
+}
+
+void Profiler::reset() {
+    memset(_stages, 0, sizeof(_stages));
+    _slowLoops = 0;
+}
+
+void Profiler::printStageName(ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::LOOP: Serial.print(F("petla   ")); break;
+        case ProfileStage::BUS: Serial.print(F("tryb    ")); break;
+        case ProfileStage::FRAME: Serial.print(F("ramka   ")); break;
+        case ProfileStage::PRINT: Serial.print(F("wydruk  ")); break;
+        case ProfileStage::COMMANDS: Serial.print(F("komendy ")); break;
+        case ProfileStage::BUTTONS: Serial.print(F("przyciski")); break;
+        default: Serial.print(F("LED     ")); break;
+    }
+}
+
+void Profiler::showStats() {
+    Serial.println(F("\n=== Profil petli [us] ==="));
+    Serial.println(F("Etap\t\twywolania\tsrednio\tmaks\tsuma ms"));
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const StageStats& stats = _stages[i];
+        printStageName((ProfileStage)i);
+        Serial.print(F("\t"));
+        Serial.print(stats.count);
+        Serial.print(F("\t\t"));
+        Serial.print(stats.count ? stats.totalUs / stats.count : 0);
+        Serial.print(F("\t"));
+        Serial.print(stats.maxUs);
+        Serial.print(F("\t"));
+        Serial.println(stats.totalUs / 1000);
+    }
+    Serial.print(F("Petle dluzsze niz znak ("));
+    Serial.print(_charUs);
+    Serial.print(F(" us): "));
+    Serial.print(_slowLoops);
+    Serial.print(F(" z "));
+    Serial.println(_stages[(uint8_t)ProfileStage::LOOP].count);
+}
+
+#endif
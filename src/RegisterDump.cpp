@@ -0,0 +1,215 @@
+#include "RegisterDump.h"
+
+RegisterDump::RegisterDump(RtuTransport& transport, Clock& clock)
+    : _transport(transport)
+    , _clock(clock)
+    , _running(false)
+    , _pending(false)
+    , _address(0)
+    , _function(0x03)
+    , _next(0)
+    , _remaining(0)
+    , _blockCount(0)
+    , _attempt(0)
+    , _accepted(false)
+    , _high(0)
+    , _requests(0)
+    , _registers(0)
+    , _crcErrors(0)
+    , _timeouts(0)
+    , _exceptions(0)
+    , _busBytes(0)
+    , _startMs(0)
+    , _elapsedMs(0)
+{
+}
+
+bool RegisterDump::start(uint8_t address, unsigned long baud, uint8_t function,
+                         uint16_t first, uint16_t count) {
+    if (address < 1 || address > 247 || baud == 0 || (function != 0x03 && function != 0x04)) {
+        Serial.println(F("Bledne parametry zrzutu"));
+        return false;
+    }
+    // Zakres nie może wyjść poza przestrzeń adresów
+    uint32_t room = 0x10000UL - first;
+    if (count == 0) count = 1;
+    if (count > room) count = room;
+
+    _address = address;
+    _function = function;
+    _next = first;
+    _remaining = count;
+    _attempt = 0;
+    _requests = 0;
+    _registers = 0;
+    _crcErrors = 0;
+    _timeouts = 0;
+    _exceptions = 0;
+    _busBytes = 0;
+    _elapsedMs = 0;
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _running = true;
+    _startMs = _clock.millis();
+
+    Serial.println(F("\nRejestr | Wartosc"));
+    Serial.println(F("------------------"));
+    sendBlock();
+    return true;
+}
+
+void RegisterDump::stop() {
+    if (!_running) return;
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+    _pending = false;
+}
+
+void RegisterDump::update() {
+    if (!_running) return;
+
+    _transport.poll();
+    if (_transport.busy() || !_pending) return;
+    _pending = false;
+    handleResult();
+}
+
+void RegisterDump::sendBlock() {
+    _blockCount = _remaining < MAX_REGISTERS ? _remaining : MAX_REGISTERS;
+    const uint8_t query[REQUEST_LENGTH] = {
+        _address, _function,
+        (uint8_t)(_next >> 8), (uint8_t)(_next & 0xFF),
+        0, _blockCount
+    };
+    uint16_t replySize = HEADER_SIZE + 2 * _blockCount + 2;
+    uint32_t windowUs = TURNAROUND_MS * 1000UL + replySize * _transport.timing().charUs;
+    _accepted = false;
+    _transport.request(query, REQUEST_LENGTH, windowUs, this);
+    _pending = true;
+    _requests++;
+}
+
+void RegisterDump::responseByte(uint16_t offset, uint8_t data) {
+    // Nagłówek decyduje, czy dane należą do tego zapytania
+    switch (offset) {
+        case 0:
+            _accepted = data == _address;
+            return;
+        case 1:
+            _accepted = _accepted && data == _function;
+            return;
+        case 2:
+            _accepted = _accepted && data == 2 * _blockCount;
+            return;
+    }
+    uint16_t index = offset - HEADER_SIZE;
+    if (!_accepted || index >= 2 * _blockCount) return;
+    if ((index & 1) == 0) {
+        _high = data;
+        return;
+    }
+    printRegister(_next + index / 2, ((uint16_t)_high << 8) | data);
+}
+
+void RegisterDump::handleResult() {
+    RtuTransport::Result result = _transport.result();
+    const uint8_t* reply = _transport.response();
+    if (result != RtuTransport::Result::TIMEOUT) {
+        _busBytes += REQUEST_LENGTH + 2 + _transport.responseCount();
+    }
+
+    if (result == RtuTransport::Result::RESPONSE && reply[0] == _address
+        && reply[1] == (_function | 0x80) && _transport.responseCount() == 5) {
+        // Wyjątek dotyczy całego bloku - ponowienie nic nie zmieni
+        _exceptions++;
+        Serial.print(F("Wyjatek 0x"));
+        if (reply[2] < 0x10) Serial.print('0');
+        Serial.print(reply[2], HEX);
+        Serial.print(F(" dla rejestrow "));
+        Serial.print(_next);
+        Serial.print('-');
+        Serial.println(_next + _blockCount - 1);
+        nextBlock();
+        return;
+    }
+    if (result == RtuTransport::Result::RESPONSE && _accepted
+        && _transport.responseCount() == HEADER_SIZE + 2 * _blockCount + 2) {
+        _registers += _blockCount;
+        nextBlock();
+        return;
+    }
+
+    if (result == RtuTransport::Result::TIMEOUT) {
+        _timeouts++;
+    } else {
+        _crcErrors++;
+        // Wartości już wypisane - oznaczenie, że są niepewne
+        if (_accepted) {
+            Serial.print(F("Blad CRC - rejestry "));
+            Serial.print(_next);
+            Serial.print('-');
+            Serial.print(_next + _blockCount - 1);
+            Serial.println(F(" niepewne"));
+        }
+    }
+    if (++_attempt <= RETRIES) {
+        sendBlock();
+        return;
+    }
+    Serial.print(F("Pominieto rejestry "));
+    Serial.print(_next);
+    Serial.print('-');
+    Serial.println(_next + _blockCount - 1);
+    nextBlock();
+}
+
+void RegisterDump::nextBlock() {
+    _next += _blockCount;
+    _remaining -= _blockCount;
+    _attempt = 0;
+    if (_remaining == 0) {
+        _elapsedMs = _clock.millis() - _startMs;
+        _running = false;
+        return;
+    }
+    sendBlock();
+}
+
+void RegisterDump::printRegister(uint16_t reg, uint16_t value) {
+    Serial.print(reg);
+    Serial.print(F("\t"));
+    Serial.print(value);
+    Serial.print(F("\t(0x"));
+    if (value < 0x1000) Serial.print('0');
+    if (value < 0x100) Serial.print('0');
+    if (value < 0x10) Serial.print('0');
+    Serial.print(value, HEX);
+    Serial.println(F(")"));
+}
+
+void RegisterDump::showSummary() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+
+    Serial.println(F("\n=== Zrzut rejestrow ==="));
+    Serial.print(F("Rejestry: "));
+    Serial.print(_registers);
+    Serial.print(F(", zapytania: "));
+    Serial.print(_requests);
+    Serial.print(F(" (do "));
+    Serial.print(MAX_REGISTERS);
+    Serial.println(F(" rejestrow w zapytaniu)"));
+    Serial.print(F("Bledy CRC: "));
+    Serial.print(_crcErrors);
+    Serial.print(F(", bez odpowiedzi: "));
+    Serial.print(_timeouts);
+    Serial.print(F(", wyjatki: "));
+    Serial.println(_exceptions);
+    Serial.print(F("Czas: "));
+    Serial.print(elapsedMs);
+    Serial.print(F(" ms, rejestry/s: "));
+    Serial.print(elapsedMs ? _registers * 1000 / elapsedMs : 0);
+    Serial.print(F(", bajty na magistrali: "));
+    Serial.println(_busBytes);
+}
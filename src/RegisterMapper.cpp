@@ -0,0 +1,397 @@
+#include "RegisterMapper.h"
+
+// Adresy startowe: początek tablicy (od 0 i od 1) i typowe bazy map
+// producentów, także z notacji 3xxxx/4xxxx
+static const uint16_t SEEDS[] PROGMEM = {
+    0, 1, 100, 1000, 2000, 3000, 4000, 5000, 10000, 20000, 30000, 30001, 40000, 40001, 50000
+};
+static const uint8_t SEED_COUNT = sizeof(SEEDS) / sizeof(SEEDS[0]);
+
+RegisterMapper::RegisterMapper(RtuTransport& transport, Clock& clock)
+    : _transport(transport)
+    , _clock(clock)
+    , _running(false)
+    , _pending(false)
+    , _address(0)
+    , _baud(0)
+    , _table(0)
+    , _seed(0)
+    , _step(Step::SEED)
+    , _first(0)
+    , _last(0)
+    , _block(0)
+    , _limit(0)
+    , _good(0)
+    , _bad(0)
+    , _probeStart(0)
+    , _probeCount(0)
+    , _supported(0)
+    , _unsupported(0)
+    , _timeouts(0)
+    , _lost(false)
+    , _rangeCount(0)
+    , _dropped(0)
+    , _requests(0)
+    , _exceptions(0)
+    , _noReply(0)
+    , _startMs(0)
+    , _elapsedMs(0)
+{
+}
+
+bool RegisterMapper::start(uint8_t address, unsigned long baud) {
+    if (address < 1 || address > 247 || baud == 0) {
+        Serial.println(F("Bledny adres urzadzenia"));
+        return false;
+    }
+    _address = address;
+    _baud = baud;
+    _pending = false;
+    _supported = 0;
+    _unsupported = 0;
+    _timeouts = 0;
+    _lost = false;
+    _rangeCount = 0;
+    _dropped = 0;
+    _requests = 0;
+    _exceptions = 0;
+    _noReply = 0;
+    _elapsedMs = 0;
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _running = true;
+    _startMs = _clock.millis();
+
+    Serial.print(F("Mapa rejestrow: adres "));
+    Serial.print(address);
+    Serial.print(F(" @ "));
+    Serial.print(baud);
+    Serial.println(F(" baud"));
+    beginTable(0);
+    return true;
+}
+
+void RegisterMapper::stop() {
+    if (!_running) return;
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+    _pending = false;
+}
+
+void RegisterMapper::update() {
+    if (!_running) return;
+
+    _transport.poll();
+    if (_transport.busy() || !_pending) return;
+    _pending = false;
+
+    Reply reply = readReply();
+    if (reply == Reply::NONE) {
+        // Powtórzenie tego samego zapytania - zgubiona odpowiedź nie może
+        // skrócić zakresu
+        if (++_timeouts >= MAX_TIMEOUTS) {
+            _lost = true;
+            finish();
+            return;
+        }
+        probe(_probeStart, _probeCount);
+        return;
+    }
+    _timeouts = 0;
+    handleReply(reply);
+}
+
+void RegisterMapper::handleReply(Reply reply) {
+    if (reply == Reply::VALID) _supported |= 1 << _table;
+
+    switch (_step) {
+        case Step::SEED:
+            if (reply == Reply::VALID) {
+                _first = _probeStart;
+                _last = _probeStart;
+                _block = _limit < INITIAL_BLOCK ? _limit : INITIAL_BLOCK;
+                extendDown();
+            } else if (reply == Reply::UNSUPPORTED && !(_supported & (1 << _table))) {
+                _unsupported |= 1 << _table;
+                beginTable(_table + 1);
+            } else {
+                nextSeed();
+            }
+            break;
+
+        case Step::DOWN:
+            if (reply == Reply::VALID) {
+                _first -= _probeCount;
+                grow(_probeCount);
+                extendDown();
+            } else if (reply == Reply::TOO_LONG && _probeCount > 1) {
+                _limit = _probeCount / 2;
+                _block = _limit;
+                extendDown();
+            } else {
+                _good = 0;
+                _bad = _probeCount;
+                searchDown();
+            }
+            break;
+
+        case Step::DOWN_SEARCH:
+            if (reply == Reply::VALID) {
+                _good = _probeCount;
+            } else {
+                _bad = _probeCount;
+            }
+            searchDown();
+            break;
+
+        case Step::UP:
+            if (reply == Reply::VALID) {
+                _last += _probeCount;
+                grow(_probeCount);
+                extendUp();
+            } else if (reply == Reply::TOO_LONG && _probeCount > 1) {
+                _limit = _probeCount / 2;
+                _block = _limit;
+                extendUp();
+            } else {
+                _good = 0;
+                _bad = _probeCount;
+                searchUp();
+            }
+            break;
+
+        case Step::UP_SEARCH:
+            if (reply == Reply::VALID) {
+                _good = _probeCount;
+            } else {
+                _bad = _probeCount;
+            }
+            searchUp();
+            break;
+    }
+}
+
+void RegisterMapper::beginTable(uint8_t table) {
+    if (table >= TABLE_COUNT) {
+        finish();
+        return;
+    }
+    _table = table;
+    _seed = 0;
+    _limit = maxBlock();
+    nextSeed();
+}
+
+void RegisterMapper::nextSeed() {
+    // Adresy startowe wewnątrz znalezionego zakresu nic nowego nie dadzą
+    while (_seed < SEED_COUNT && isMapped(pgm_read_word(&SEEDS[_seed]))) _seed++;
+    if (_seed >= SEED_COUNT) {
+        beginTable(_table + 1);
+        return;
+    }
+    _step = Step::SEED;
+    probe(pgm_read_word(&SEEDS[_seed++]), 1);
+}
+
+void RegisterMapper::extendDown() {
+    if (_first == 0) {
+        startUp();
+        return;
+    }
+    _step = Step::DOWN;
+    uint16_t count = _first < _block ? _first : _block;
+    probe(_first - count, count);
+}
+
+void RegisterMapper::searchDown() {
+    // _good adresów poniżej _first na pewno istnieje, _bad już nie
+    if (_bad - _good <= 1) {
+        _first -= _good;
+        startUp();
+        return;
+    }
+    _step = Step::DOWN_SEARCH;
+    uint16_t count = _good + (_bad - _good) / 2;
+    probe(_first - count, count);
+}
+
+void RegisterMapper::startUp() {
+    _block = _limit < INITIAL_BLOCK ? _limit : INITIAL_BLOCK;
+    extendUp();
+}
+
+void RegisterMapper::extendUp() {
+    if (_last == 0xFFFF) {
+        finishRange();
+        return;
+    }
+    _step = Step::UP;
+    uint16_t room = 0xFFFF - _last;
+    probe(_last + 1, room < _block ? room : _block);
+}
+
+void RegisterMapper::searchUp() {
+    if (_bad - _good <= 1) {
+        _last += _good;
+        finishRange();
+        return;
+    }
+    _step = Step::UP_SEARCH;
+    probe(_last + 1, _good + (_bad - _good) / 2);
+}
+
+void RegisterMapper::grow(uint16_t accepted) {
+    // Poprawny blok pełnej długości - następny dwa razy dłuższy
+    if (accepted < _block) return;
+    _block = _block > _limit / 2 ? _limit : _block * 2;
+}
+
+void RegisterMapper::finishRange() {
+    if (_rangeCount < MAX_RANGES) {
+        RegisterRange& range = _ranges[_rangeCount++];
+        range.function = function();
+        range.first = _first;
+        range.last = _last;
+    } else {
+        _dropped++;
+    }
+
+    printFunctionName(function());
+    Serial.print(F(": "));
+    Serial.print(_first);
+    Serial.print('-');
+    Serial.print(_last);
+    Serial.print(F(" ("));
+    Serial.print((uint32_t)_last - _first + 1);
+    Serial.println(F(")"));
+    nextSeed();
+}
+
+void RegisterMapper::finish() {
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+    _pending = false;
+}
+
+void RegisterMapper::probe(uint16_t start, uint16_t count) {
+    const uint8_t query[REQUEST_LENGTH] = {
+        _address, function(),
+        (uint8_t)(start >> 8), (uint8_t)(start & 0xFF),
+        (uint8_t)(count >> 8), (uint8_t)(count & 0xFF)
+    };
+    _probeStart = start;
+    _probeCount = count;
+    uint32_t windowUs = TURNAROUND_MS * 1000UL + replySize(count) * _transport.timing().charUs;
+    _transport.request(query, REQUEST_LENGTH, windowUs, this);
+    _pending = true;
+    _requests++;
+}
+
+RegisterMapper::Reply RegisterMapper::readReply() {
+    if (_transport.result() != RtuTransport::Result::RESPONSE) {
+        _noReply++;
+        return Reply::NONE;
+    }
+    const uint8_t* reply = _transport.response();
+    uint16_t length = _transport.responseCount();
+    if (reply[0] != _address) {
+        _noReply++;
+        return Reply::NONE;
+    }
+
+    if (reply[1] == (function() | 0x80) && length == 5) {
+        _exceptions++;
+        switch (reply[2]) {
+            case 0x01: return Reply::UNSUPPORTED;
+            case 0x03: return Reply::TOO_LONG;
+            default: return Reply::INVALID;
+        }
+    }
+
+    // CRC sprawdził transport; liczba bajtów musi pasować do zapytania
+    uint16_t size = replySize(_probeCount);
+    if (reply[1] != function() || length != size || reply[2] != size - 5) {
+        _noReply++;
+        return Reply::NONE;
+    }
+    return Reply::VALID;
+}
+
+uint16_t RegisterMapper::replySize(uint16_t count) const {
+    // Adres, funkcja, liczba bajtów, dane, CRC
+    uint16_t bytes = function() <= 0x02 ? (count + 7) / 8 : count * 2;
+    return 5 + bytes;
+}
+
+uint16_t RegisterMapper::maxBlock() const {
+    return function() <= 0x02 ? MAX_BITS : MAX_REGISTERS;
+}
+
+bool RegisterMapper::isMapped(uint16_t address) const {
+    for (uint8_t i = 0; i < _rangeCount; i++) {
+        const RegisterRange& range = _ranges[i];
+        if (range.function == function() && address >= range.first && address <= range.last) return true;
+    }
+    return false;
+}
+
+void RegisterMapper::printFunctionName(uint8_t function) {
+    switch (function) {
+        case 0x01: Serial.print(F("0x01 cewki")); break;
+        case 0x02: Serial.print(F("0x02 wejscia binarne")); break;
+        case 0x03: Serial.print(F("0x03 rejestry holding")); break;
+        default: Serial.print(F("0x04 rejestry wejsciowe")); break;
+    }
+}
+
+void RegisterMapper::showMap() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+
+    Serial.print(F("\n=== Mapa rejestrow: adres "));
+    Serial.print(_address);
+    Serial.println(F(" ==="));
+    for (uint8_t table = 0; table < TABLE_COUNT; table++) {
+        uint8_t code = table + 1;
+        printFunctionName(code);
+        Serial.print(F(": "));
+        bool any = false;
+        for (uint8_t i = 0; i < _rangeCount; i++) {
+            const RegisterRange& range = _ranges[i];
+            if (range.function != code) continue;
+            if (any) Serial.print(F(", "));
+            Serial.print(range.first);
+            if (range.last != range.first) {
+                Serial.print('-');
+                Serial.print(range.last);
+            }
+            any = true;
+        }
+        if (!any) {
+            if (_unsupported & (1 << table)) {
+                Serial.print(F("nieobslugiwane"));
+            } else {
+                Serial.print(F("brak"));
+            }
+        }
+        Serial.println();
+    }
+    if (_dropped) {
+        Serial.print(F("Zakresy poza mapa (brak miejsca): "));
+        Serial.println(_dropped);
+    }
+    if (_lost) {
+        Serial.println(F("Przerwano - urzadzenie nie odpowiada"));
+    }
+    Serial.print(F("Zapytania: "));
+    Serial.print(_requests);
+    Serial.print(F(", wyjatki: "));
+    Serial.print(_exceptions);
+    Serial.print(F(", bez odpowiedzi: "));
+    Serial.print(_noReply);
+    Serial.print(F(", czas: "));
+    Serial.print(elapsedMs);
+    Serial.println(F(" ms"));
+}
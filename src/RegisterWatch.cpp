@@ -0,0 +1,278 @@
+#include "RegisterWatch.h"
+
+bool WatchBlocks::add(uint8_t address, uint8_t function, uint16_t first, uint8_t count) {
+    if (address < 1 || address > 247 || (function != 0x03 && function != 0x04)
+        || count == 0 || count > MAX_BLOCK_REGISTERS || first + (uint32_t)count > 0x10000UL) {
+        Serial.print(F("Bledny blok (do "));
+        Serial.print(MAX_BLOCK_REGISTERS);
+        Serial.println(F(" rejestrow 0x03/0x04)"));
+        return false;
+    }
+    if (_blockCount >= MAX_BLOCKS || _registerCount + count > MAX_REGISTERS) {
+        Serial.print(F("Brak miejsca: do "));
+        Serial.print(MAX_BLOCKS);
+        Serial.print(F(" blokow, "));
+        Serial.print(MAX_REGISTERS);
+        Serial.println(F(" rejestrow"));
+        return false;
+    }
+
+    Block& block = _blocks[_blockCount++];
+    block.address = address;
+    block.function = function;
+    block.first = first;
+    block.count = count;
+    block.offset = _registerCount;
+    for (uint8_t i = 0; i < count; i++) _deadbands[_registerCount + i] = 0;
+    _registerCount += count;
+    return true;
+}
+
+bool WatchBlocks::setDeadband(uint8_t address, uint16_t reg, uint16_t band) {
+    bool found = false;
+    for (uint8_t i = 0; i < _blockCount; i++) {
+        const Block& block = _blocks[i];
+        if (block.address != address || reg < block.first || reg - block.first >= block.count) {
+            continue;
+        }
+        _deadbands[block.offset + (reg - block.first)] = band;
+        found = true;
+    }
+    if (!found) Serial.println(F("Rejestr nie jest obserwowany"));
+    return found;
+}
+
+void WatchBlocks::clear() {
+    _blockCount = 0;
+    _registerCount = 0;
+}
+
+void WatchBlocks::show() const {
+    Serial.println(F("Obserwowane bloki:"));
+    for (uint8_t i = 0; i < _blockCount; i++) {
+        const Block& block = _blocks[i];
+        Serial.print(F("  ID "));
+        Serial.print(block.address);
+        Serial.print(F(" 0x0"));
+        Serial.print(block.function);
+        Serial.print(F(" "));
+        Serial.print(block.first);
+        Serial.print('-');
+        Serial.print(block.first + block.count - 1);
+        for (uint8_t r = 0; r < block.count; r++) {
+            uint16_t band = _deadbands[block.offset + r];
+            if (band == 0) continue;
+            Serial.print(F(", pasmo "));
+            Serial.print(block.first + r);
+            Serial.print(F(": "));
+            Serial.print(band);
+        }
+        Serial.println();
+    }
+}
+
+RegisterWatch::RegisterWatch(RtuTransport& transport, Clock& clock, const WatchBlocks& blocks)
+    : _transport(transport)
+    , _clock(clock)
+    , _blocks(blocks)
+    , _running(false)
+    , _pending(false)
+    , _current(0)
+    , _polls(0)
+    , _changes(0)
+    , _records(0)
+    , _readValues(0)
+    , _crcErrors(0)
+    , _timeouts(0)
+    , _exceptions(0)
+    , _startMs(0)
+    , _elapsedMs(0)
+{
+}
+
+bool RegisterWatch::start(unsigned long baud) {
+    if (_blocks.count() == 0) {
+        Serial.println(F("Brak blokow - watch add <adres> <rejestr> [ilosc] [4]"));
+        return false;
+    }
+    if (baud == 0) return false;
+
+    _known.clear();
+    for (uint8_t i = 0; i < _blocks.count(); i++) _states[i] = BlockState::OK;
+    _current = 0;
+    _polls = 0;
+    _changes = 0;
+    _records = 0;
+    _readValues = 0;
+    _crcErrors = 0;
+    _timeouts = 0;
+    _exceptions = 0;
+    _elapsedMs = 0;
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _running = true;
+    _startMs = _clock.millis();
+
+    Serial.print(F("\nObserwacja: "));
+    Serial.print(_blocks.registerCount());
+    Serial.print(F(" rejestrow, "));
+    Serial.print(baud);
+    Serial.println(F(" baud, tylko zmiany (STOP - raport)"));
+    sendBlock();
+    return true;
+}
+
+void RegisterWatch::stop() {
+    if (!_running) return;
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+    _pending = false;
+}
+
+void RegisterWatch::update() {
+    if (!_running) return;
+
+    _transport.poll();
+    if (_transport.busy()) return;
+    if (_pending) {
+        _pending = false;
+        handleResult();
+        _current = (_current + 1) % _blocks.count();
+    }
+    // Następny blok od razu - tempo wyznacza tylko magistrala
+    sendBlock();
+}
+
+void RegisterWatch::sendBlock() {
+    const Block& block = _blocks.block(_current);
+    const uint8_t query[REQUEST_LENGTH] = {
+        block.address, block.function,
+        (uint8_t)(block.first >> 8), (uint8_t)(block.first & 0xFF),
+        0, block.count
+    };
+    uint8_t replySize = HEADER_SIZE + 2 * block.count + 2;
+    uint32_t windowUs = TURNAROUND_MS * 1000UL + replySize * _transport.timing().charUs;
+    _pending = _transport.request(query, REQUEST_LENGTH, windowUs);
+    if (_pending) _polls++;
+}
+
+void RegisterWatch::handleResult() {
+    const Block& block = _blocks.block(_current);
+    RtuTransport::Result result = _transport.result();
+    const uint8_t* reply = _transport.response();
+    uint8_t length = _transport.responseLength();
+
+    if (result == RtuTransport::Result::TIMEOUT) {
+        _timeouts++;
+        reportState(_current, BlockState::TIMEOUT, 0);
+        return;
+    }
+    if (result != RtuTransport::Result::RESPONSE || reply[0] != block.address) {
+        _crcErrors++;
+        reportState(_current, BlockState::CRC_ERROR, 0);
+        return;
+    }
+    if (reply[1] == (block.function | 0x80) && length == 5) {
+        _exceptions++;
+        reportState(_current, BlockState::EXCEPTION, reply[2]);
+        return;
+    }
+    if (reply[1] != block.function || reply[2] != 2 * block.count
+        || length != HEADER_SIZE + 2 * block.count + 2) {
+        _crcErrors++;
+        reportState(_current, BlockState::CRC_ERROR, 0);
+        return;
+    }
+
+    _states[_current] = BlockState::OK;
+    _readValues += block.count;
+    reportValues(block, &reply[HEADER_SIZE]);
+}
+
+void RegisterWatch::reportValues(const Block& block, const uint8_t* data) {
+    bool printed = false;
+    for (uint8_t i = 0; i < block.count; i++) {
+        uint8_t index = block.offset + i;
+        uint16_t value = ((uint16_t)data[2 * i] << 8) | data[2 * i + 1];
+        uint16_t last = _values[index];
+        uint16_t change = value > last ? value - last : last - value;
+        if (_known.test(index) && change <= _blocks.deadband(index)) continue;
+
+        _values[index] = value;
+        _known.set(index);
+        _changes++;
+        if (!printed) {
+            printRecordStart(block);
+            printed = true;
+        }
+        Serial.print(' ');
+        Serial.print(block.first + i);
+        Serial.print('=');
+        Serial.print(value);
+    }
+    if (!printed) return;
+    Serial.println();
+    _records++;
+}
+
+void RegisterWatch::reportState(uint8_t index, BlockState state, uint8_t exceptionCode) {
+    if (_states[index] == state) return;
+    _states[index] = state;
+    const Block& block = _blocks.block(index);
+
+    printRecordStart(block);
+    switch (state) {
+        case BlockState::TIMEOUT:
+            Serial.print(F(" brak odpowiedzi"));
+            break;
+        case BlockState::CRC_ERROR:
+            Serial.print(F(" blad ramki"));
+            break;
+        default:
+            Serial.print(F(" wyjatek 0x"));
+            if (exceptionCode < 0x10) Serial.print('0');
+            Serial.print(exceptionCode, HEX);
+            break;
+    }
+    Serial.print(F(" ("));
+    Serial.print(block.first);
+    Serial.print('-');
+    Serial.print(block.first + block.count - 1);
+    Serial.println(F(")"));
+    _records++;
+}
+
+void RegisterWatch::printRecordStart(const Block& block) const {
+    Serial.print(_clock.millis() - _startMs);
+    Serial.print(' ');
+    Serial.print(block.address);
+    Serial.print(':');
+}
+
+void RegisterWatch::showSummary() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+
+    Serial.println(F("\n=== Obserwacja rejestrow ==="));
+    Serial.print(F("Odczyty blokow: "));
+    Serial.print(_polls);
+    Serial.print(F(" ("));
+    Serial.print(elapsedMs ? _polls * 1000 / elapsedMs : 0);
+    Serial.println(F("/s)"));
+    Serial.print(F("Zmiany: "));
+    Serial.print(_changes);
+    Serial.print(F(" z "));
+    Serial.print(_readValues);
+    Serial.print(F(" odczytanych wartosci, wiersze: "));
+    Serial.println(_records);
+    Serial.print(F("Bledy ramki: "));
+    Serial.print(_crcErrors);
+    Serial.print(F(", bez odpowiedzi: "));
+    Serial.print(_timeouts);
+    Serial.print(F(", wyjatki: "));
+    Serial.println(_exceptions);
+    Serial.print(F("Czas: "));
+    Serial.print(elapsedMs);
+    Serial.println(F(" ms"));
+}
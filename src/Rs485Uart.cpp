@@ -0,0 +1,132 @@
+#include "Rs485Uart.h"
+
+static Rs485Uart* activeUart = nullptr;
+
+static_assert(F_CPU <= 16000000UL, "Status bajtu w znaczniku wymaga rozdzielczosci micros() >= 4 us");
+
+// Kod statusu w znaczniku: 0 - poprawny, 1..3 - flaga RX_STATUS_*
+static const uint8_t STATUS_FLAGS[] PROGMEM = {0, RX_STATUS_FRAMING, RX_STATUS_PARITY, RX_STATUS_OVERRUN};
+
+ISR(USART1_RX_vect) {
+    if (activeUart) {
+        activeUart->handleRxInterrupt();
+    } else {
+        (void)UDR1;
+    }
+}
+
+Rs485Uart::Rs485Uart()
+    : _head(0)
+    , _tail(0)
+    , _overflows(0)
+    , _written(false)
+{
+}
+
+void Rs485Uart::begin(unsigned long baud) {
+    end();
+
+    // Ten sam dobór dzielnika co w HardwareSerial::begin()
+    uint16_t baudSetting = (F_CPU / 4 / baud - 1) / 2;
+    uint8_t statusA = _BV(U2X1);
+    if (((F_CPU == 16000000UL) && (baud == 57600)) || (baudSetting > 4095)) {
+        statusA = 0;
+        baudSetting = (F_CPU / 8 / baud - 1) / 2;
+    }
+
+    UBRR1H = baudSetting >> 8;
+    UBRR1L = baudSetting;
+    UCSR1A = statusA;
+    UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);     // 8N1
+
+    _head = 0;
+    _tail = 0;
+    _written = false;
+    activeUart = this;
+    UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+}
+
+void Rs485Uart::end() {
+    if (activeUart == this) {
+        flush();
+    }
+    UCSR1B = 0;
+    activeUart = nullptr;
+    _head = 0;
+    _tail = 0;
+}
+
+int Rs485Uart::available() {
+    return (uint8_t)(_head - _tail) & RING_MASK;
+}
+
+int Rs485Uart::read() {
+    RxEvent event;
+    if (!readEvent(event)) return -1;
+    return event.data;
+}
+
+bool Rs485Uart::readEvent(RxEvent& event) {
+    uint8_t tail = _tail;
+    if (tail == _head) return false;
+
+    uint16_t stamp = _timestamps[tail];
+    uint32_t now = micros();
+    event.data = _data[tail];
+    event.status = pgm_read_byte(&STATUS_FLAGS[stamp & STATUS_MASK]);
+    // Wiek bajtu liczony modulo 2^16 us
+    event.timestamp = now - (uint16_t)((uint16_t)now - (stamp & ~STATUS_MASK));
+    _tail = (tail + 1) & RING_MASK;
+    return true;
+}
+
+size_t Rs485Uart::write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        while (!(UCSR1A & _BV(UDRE1))) {}
+        // Kasowanie TXC przed wysłaniem, aby flush() czekał na ten bajt
+        UCSR1A = (UCSR1A & (_BV(U2X1) | _BV(MPCM1))) | _BV(TXC1);
+        UDR1 = data[i];
+        _written = true;
+    }
+    return length;
+}
+
+void Rs485Uart::flush() {
+    while (!txComplete()) {}
+}
+
+bool Rs485Uart::txReady() {
+    return UCSR1A & _BV(UDRE1);
+}
+
+bool Rs485Uart::txComplete() {
+    if (!_written || !(UCSR1B & _BV(TXEN1))) return true;
+    return (UCSR1A & _BV(UDRE1)) && (UCSR1A & _BV(TXC1));
+}
+
+uint32_t Rs485Uart::overflowCount() const {
+    noInterrupts();
+    uint32_t overflows = _overflows;
+    interrupts();
+    return overflows;
+}
+
+void Rs485Uart::handleRxInterrupt() {
+    uint32_t timestamp = micros();
+    // Flagi błędów dotyczą bajtu w UDR1 - odczyt UCSR1A przed UDR1
+    uint8_t flags = UCSR1A;
+    uint8_t data = UDR1;
+    // Utrata bajtów jest ważniejsza od błędu elektrycznego tego bajtu
+    uint8_t code = (flags & _BV(DOR1)) ? 3 : (flags & _BV(FE1)) ? 1 : (flags & _BV(UPE1)) ? 2 : 0;
+    uint8_t head = _head;
+    uint8_t next = (head + 1) & RING_MASK;
+
+    if (next == _tail) {
+        _overflows++;
+        return;
+    }
+
+    _data[head] = data;
+    _timestamps[head] = ((uint16_t)timestamp & ~STATUS_MASK) | code;
+    _head = next;
+}
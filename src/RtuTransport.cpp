@@ -0,0 +1,224 @@
+#include "RtuTransport.h"
+#include "ModbusPdu.h"
+
+RtuTransport::RtuTransport(SerialPort& serial, Gpio& gpio, Clock& clock, uint8_t dirPin)
+    : _serial(serial)
+    , _gpio(gpio)
+    , _clock(clock)
+    , _dirPin(dirPin)
+    , _baud(9600)
+    , _state(State::IDLE)
+    , _result(Result::NONE)
+    , _settleStartMs(0)
+    , _baudChanged(false)
+    , _stateStartUs(0)
+    , _windowUs(0)
+    , _txStartUs(0)
+    , _txEndUs(0)
+    , _rxStartUs(0)
+    , _lastByteUs(0)
+    , _txLength(0)
+    , _txIndex(0)
+    , _txSource(nullptr)
+    , _slave(false)
+    , _rxLength(0)
+    , _rxCount(0)
+    , _stream(nullptr)
+    , _rxOverflow(false)
+{
+    _timing.setBaud(_baud);
+}
+
+void RtuTransport::begin(unsigned long baud) {
+    _gpio.pinMode(_dirPin, OUTPUT);
+    _gpio.digitalWrite(_dirPin, LOW);
+    _baud = baud;
+    _timing.setBaud(baud);
+    _serial.begin(baud);
+    _state = State::IDLE;
+    _result = Result::NONE;
+    _baudChanged = false;
+}
+
+void RtuTransport::setBaud(unsigned long baud) {
+    cancel();
+    _serial.end();
+    _serial.begin(baud);
+    _baud = baud;
+    _timing.setBaud(baud);
+    _settleStartMs = _clock.millis();
+    _baudChanged = true;
+}
+
+bool RtuTransport::request(const uint8_t* frame, uint8_t length, uint32_t responseWindowUs,
+                           ResponseStream* stream) {
+    if (busy() || length + 2 > FRAME_SIZE) return false;
+
+    memcpy(_txBuffer, frame, length);
+    ModbusCRC::append(_txBuffer, length);
+    _txLength = length + 2;
+    _txIndex = 0;
+    _txSource = nullptr;
+    _slave = false;
+    _windowUs = responseWindowUs;
+    resetReceive();
+    _stream = stream;
+    _result = Result::PENDING;
+    _state = State::SETTLING;
+    return true;
+}
+
+bool RtuTransport::listen() {
+    if (busy()) return false;
+    _slave = true;
+    resetReceive();
+    _result = Result::PENDING;
+    _state = State::LISTENING;
+    return true;
+}
+
+bool RtuTransport::send(FrameSource& source, uint8_t length) {
+    if (busy()) return false;
+    _txSource = &source;
+    _txLength = length;
+    _txIndex = 0;
+    _slave = true;
+    _result = Result::PENDING;
+    _state = State::SETTLING;
+    return true;
+}
+
+void RtuTransport::resetReceive() {
+    _rxLength = 0;
+    _rxCount = 0;
+    _rxCrc.reset();
+    _stream = nullptr;
+    _rxOverflow = false;
+}
+
+void RtuTransport::poll() {
+    // Czas pobrany przed opróżnieniem pierścienia, jak w analizatorze
+    uint32_t now = _clock.micros();
+
+    switch (_state) {
+        case State::IDLE:
+            return;
+
+        case State::SETTLING:
+            if (_baudChanged && _clock.millis() - _settleStartMs < BAUD_SETTLE_MS) return;
+            // Zapytania jedno po drugim: cisza t3.5 od ostatniego znaku na linii
+            if ((int32_t)(now - _lastByteUs) < (int32_t)_timing.t35Us) return;
+            _baudChanged = false;
+            // Resztki poprzedniej wymiany nie mogą trafić do odpowiedzi
+            clear();
+            _gpio.digitalWrite(_dirPin, HIGH);
+            _stateStartUs = now;
+            _state = State::ENABLING;
+            return;
+
+        case State::ENABLING:
+            if (now - _stateStartUs < DIR_SETTLE_US) return;
+            _state = State::TRANSMITTING;
+            // fall through
+        case State::TRANSMITTING:
+            while (_txIndex < _txLength && _serial.txReady()) {
+                if (_txIndex == 0) _txStartUs = _clock.micros();
+                uint8_t data = _txSource ? _txSource->frameByte(_txIndex) : _txBuffer[_txIndex];
+                _serial.write(&data, 1);
+                _txIndex++;
+            }
+            if (_txIndex < _txLength) return;
+            _state = State::DRAINING;
+            // fall through
+        case State::DRAINING:
+            if (!_serial.txComplete()) return;
+            _gpio.digitalWrite(_dirPin, LOW);
+            _txEndUs = _clock.micros();
+            _lastByteUs = _txEndUs;
+            _stateStartUs = _txEndUs;
+            // Slave po odpowiedzi nie czeka na nic
+            if (_slave) {
+                finish(Result::SENT);
+                return;
+            }
+            _state = State::WAITING;
+            return;
+
+        case State::WAITING:
+        case State::LISTENING:
+        case State::RECEIVING:
+            receive(now);
+            return;
+    }
+}
+
+void RtuTransport::receive(uint32_t now) {
+    RxEvent event;
+    while (_serial.readEvent(event)) {
+        if (_state != State::RECEIVING) {
+            _state = State::RECEIVING;
+            _rxStartUs = event.timestamp;
+        }
+        if (_rxLength < FRAME_SIZE) {
+            _rxBuffer[_rxLength++] = event.data;
+        } else if (!_stream) {
+            _rxOverflow = true;
+        }
+        if (_stream) _stream->responseByte(_rxCount, event.data);
+        _rxCount++;
+        _rxCrc.update(event.data);
+        _lastByteUs = event.timestamp;
+
+        // Cała przewidziana odpowiedź odebrana - bez czekania na t3.5;
+        // długość wynika z nagłówka, który zawsze jest w buforze. Slave
+        // słyszy też odpowiedzi innych urządzeń: bez zgodnego CRC czeka
+        // na ciszę, żeby nie zacząć nasłuchu w środku cudzej ramki
+        FrameDirection direction = _slave ? FrameDirection::REQUEST : FrameDirection::RESPONSE;
+        if (!_rxOverflow && _rxCount == ModbusPdu::expectedLength(_rxBuffer, _rxLength, direction)
+            && (!_slave || _rxCrc.isValid())) {
+            finish(_rxCrc.isValid() ? validResult() : Result::CRC_ERROR);
+            return;
+        }
+    }
+
+    if (_state == State::LISTENING) return;
+
+    if (_state == State::WAITING) {
+        if (now - _stateStartUs >= _windowUs) finish(Result::TIMEOUT);
+        return;
+    }
+    // Ramka zamknięta ciszą t3.5; ucięta ramka liczy się jak błąd CRC
+    if ((int32_t)(now - _lastByteUs) >= (int32_t)_timing.t35Us) {
+        bool valid = !_rxOverflow && _rxCount >= 4 && _rxCrc.isValid();
+        finish(valid ? validResult() : Result::CRC_ERROR);
+    }
+}
+
+void RtuTransport::finish(Result result) {
+    _result = result;
+    _state = State::IDLE;
+}
+
+bool RtuTransport::busy() const {
+    return _state != State::IDLE;
+}
+
+uint32_t RtuTransport::turnaroundUs() const {
+    // Znaczniki to koniec znaku - odejmujemy czas pierwszego znaku
+    uint32_t gap = _rxStartUs - _txEndUs;
+    return gap > _timing.charUs ? gap - _timing.charUs : 0;
+}
+
+void RtuTransport::cancel() {
+    if (_state != State::IDLE) {
+        _gpio.digitalWrite(_dirPin, LOW);
+    }
+    _state = State::IDLE;
+    _result = Result::NONE;
+}
+
+void RtuTransport::clear() {
+    while (_serial.available()) {
+        _serial.read();
+    }
+}
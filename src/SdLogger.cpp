@@ -0,0 +1,189 @@
+#include "SdLogger.h"
+
+static const uint32_t DRAIN_TIMEOUT_MS = 1000;  // Najdłuższe programowanie bloku
+
+SdLogger::SdLogger(Clock& clock)
+    : _clock(clock)
+    , _device(nullptr)
+    , _active(0)
+    , _length(0)
+    , _chunk(0)
+    , _pending(false)
+    , _full(false)
+    , _session(0)
+    , _blocks(0)
+    , _sector(0)
+    , _pendingSince(0)
+    , _maxWaitUs(0)
+    , _sectorsWritten(0)
+    , _error(false)
+{
+}
+
+bool SdLogger::begin(BlockDevice& device, uint32_t session, uint32_t blocks, bool force) {
+    _device = nullptr;
+    if (!force && hasFileSystem(device)) {
+        Serial.println(F("Log SD: karta ma MBR/FAT - \"sd force\" nadpisze ja od bloku 0"));
+        return false;
+    }
+    uint32_t available = device.blockCount();
+    if (blocks == 0 || blocks > available) blocks = available;
+    _active = 0;
+    _length = 0;
+    _chunk = 0;
+    _pending = false;
+    _full = blocks == 0;
+    _session = session;
+    _blocks = blocks;
+    _sector = 0;
+    _maxWaitUs = 0;
+    _sectorsWritten = 0;
+    _error = false;
+    // Cały obszar przydzielony z góry - karta nie szuka wolnych bloków w trakcie
+    if (_full || !device.startWrite(0, blocks)) {
+        Serial.println(F("Log SD: blad zapisu karty"));
+        return false;
+    }
+    _device = &device;
+    return true;
+}
+
+// Blok 0 zakończony 0x55AA to MBR albo sektor startowy FAT; nasz log zaczyna
+// się od "MBLG" i może być nadpisany bez pytania
+bool SdLogger::hasFileSystem(BlockDevice& device) {
+    uint8_t magic[4];
+    uint8_t signature[2];
+    if (!device.readData(0, 0, magic, sizeof(magic))
+        || !device.readData(0, SECTOR_SIZE - 2, signature, sizeof(signature))) {
+        return false;
+    }
+    if (memcmp(magic, "MBLG", sizeof(magic)) == 0) return false;
+    return signature[0] == 0x55 && signature[1] == 0xAA;
+}
+
+void SdLogger::end() {
+    if (!_device) return;
+    // Niepełny sektor dopełniany zerami - parser pomija bajty bez SYNC
+    while ((_length > 0 || _chunk > 0) && !_full && !_error) {
+        memset(_buffers[_active] + _length, 0, BUFFER_SIZE - _length);
+        _length = BUFFER_SIZE;
+        if (!_pending) swap();
+        drain();
+    }
+    drain();
+    if (!_error && !_device->stopWrite()) _error = true;
+    _device = nullptr;
+}
+
+void SdLogger::poll() {
+    if (!_device || !_pending || !cardReady()) return;
+    send();
+}
+
+// Czeka, aż bufor oczekujący trafi na kartę
+void SdLogger::drain() {
+    uint32_t start = _clock.millis();
+    while (_pending && !_error) {
+        if (cardReady()) {
+            send();
+        } else if (_clock.millis() - start > DRAIN_TIMEOUT_MS) {
+            _error = true;
+        }
+    }
+}
+
+size_t SdLogger::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t SdLogger::write(const uint8_t* data, size_t length) {
+    if (!_device || _full) return 0;
+    size_t written = 0;
+    while (written < length) {
+        if (_length == BUFFER_SIZE) break;
+        uint8_t* buffer = _buffers[_active];
+        if (_length == 0 && _chunk == 0) {
+            buffer[0] = 'M';
+            buffer[1] = 'B';
+            buffer[2] = 'L';
+            buffer[3] = 'G';
+            for (uint8_t i = 0; i < 4; i++) buffer[4 + i] = _session >> (8 * i);
+            _length = HEADER_SIZE;
+        }
+        size_t count = BUFFER_SIZE - _length;
+        if (count > length - written) count = length - written;
+        memcpy(buffer + _length, data + written, count);
+        _length += count;
+        written += count;
+        // Przy zajętej karcie pełny bufor czeka na send()
+        if (_length < BUFFER_SIZE || _pending) continue;
+        swap();
+        if (_full) break;
+    }
+    return written;
+}
+
+int SdLogger::availableForWrite() {
+    if (!_device || _full) return 0;
+    int room = _length == 0 ? chunkRoom(_chunk) : BUFFER_SIZE - _length;
+    if (!_pending) {
+        uint8_t next = _chunk + 1 < CHUNKS ? _chunk + 1 : 0;
+        if (next != 0 || _sector + 1 < _blocks) room += chunkRoom(next);
+    }
+    return room;
+}
+
+// Miejsce na dane w pustym buforze danej części sektora
+uint16_t SdLogger::chunkRoom(uint8_t chunk) const {
+    return chunk == 0 ? BUFFER_SIZE - HEADER_SIZE : BUFFER_SIZE;
+}
+
+// Pełny bufor aktywny staje się oczekującym
+void SdLogger::swap() {
+    _pending = true;
+    _pendingSince = _clock.micros();
+    _active ^= 1;
+    _length = 0;
+    if (++_chunk == CHUNKS) {
+        _chunk = 0;
+        if (++_sector >= _blocks) _full = true;
+    }
+}
+
+void SdLogger::send() {
+    if (!_device->writeData(_buffers[_active ^ 1], BUFFER_SIZE)) {
+        _error = true;
+        _full = true;
+        _pending = false;
+        return;
+    }
+    uint32_t wait = _clock.micros() - _pendingSince;
+    if (wait > _maxWaitUs) _maxWaitUs = wait;
+    _pending = false;
+    if (_chunk == 0) _sectorsWritten = _sector;
+
+    // Aktywny zapełnił się w trakcie czekania
+    if (_length == BUFFER_SIZE) swap();
+}
+
+// Zajętość karty ma sens tylko przed nowym blokiem - dalsze części sektora
+// idą od razu za poprzednimi
+bool SdLogger::cardReady() {
+    uint8_t pendingChunk = _chunk ? _chunk - 1 : CHUNKS - 1;
+    return pendingChunk != 0 || !_device->busy();
+}
+
+void SdLogger::showSummary() const {
+    Serial.print(F("Log SD: sektory "));
+    Serial.print(_sectorsWritten);
+    Serial.print(F(" ("));
+    Serial.print(_sectorsWritten / 2);
+    Serial.print(F(" KB), najdluzsze czekanie na karte "));
+    Serial.print(_maxWaitUs / 1000);
+    Serial.println(F(" ms"));
+    if (_error) {
+        Serial.println(F("Log SD: blad zapisu karty"));
+    } else if (_full) {
+        Serial.println(F("Log SD: koniec obszaru logu"));
+    }
+}
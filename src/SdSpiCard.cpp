@@ -0,0 +1,240 @@
+#include <SPI.h>
+#include "SdSpiCard.h"
+
+// Komendy SD w trybie SPI
+static const uint8_t CMD0 = 0;      // GO_IDLE_STATE
+static const uint8_t CMD8 = 8;      // SEND_IF_COND
+static const uint8_t CMD9 = 9;      // SEND_CSD
+static const uint8_t CMD16 = 16;    // SET_BLOCKLEN
+static const uint8_t CMD17 = 17;    // READ_SINGLE_BLOCK
+static const uint8_t CMD25 = 25;    // WRITE_MULTIPLE_BLOCK
+static const uint8_t CMD55 = 55;    // APP_CMD
+static const uint8_t CMD58 = 58;    // READ_OCR
+static const uint8_t ACMD23 = 23;   // SET_WR_BLK_ERASE_COUNT
+static const uint8_t ACMD41 = 41;   // SD_SEND_OP_COND
+
+static const uint32_t ACMD23_MAX_BLOCKS = 0x7FFFFFUL;  // Pole 23-bitowe, ~4 GB
+
+static const uint8_t R1_IDLE = 0x01;
+static const uint8_t R1_ILLEGAL_COMMAND = 0x04;
+static const uint8_t TOKEN_DATA = 0xFE;
+static const uint8_t TOKEN_WRITE_MULTIPLE = 0xFC;
+static const uint8_t TOKEN_STOP_TRAN = 0xFD;
+static const uint8_t DATA_ACCEPTED = 0x05;
+
+SdSpiCard::SdSpiCard(uint8_t csPin)
+    : _csPin(csPin)
+    , _spiClock(250000)
+    , _highCapacity(false)
+    , _blocks(0)
+    , _offset(0)
+    , _writing(false)
+    , _selected(false)
+{
+}
+
+bool SdSpiCard::begin() {
+    _spiClock = 250000;
+    _blocks = 0;
+    _writing = false;
+    pinMode(_csPin, OUTPUT);
+    digitalWrite(_csPin, HIGH);
+    SPI.begin();
+
+    // Co najmniej 74 takty zegara z CS w stanie wysokim
+    SPI.beginTransaction(SPISettings(_spiClock, MSBFIRST, SPI_MODE0));
+    for (uint8_t i = 0; i < 10; i++) SPI.transfer(0xFF);
+    SPI.endTransaction();
+
+    uint32_t start = millis();
+    while (command(CMD0, 0) != R1_IDLE) {
+        if (millis() - start > INIT_TIMEOUT_MS) {
+            deselect();
+            return false;
+        }
+    }
+
+    // Karta v2 odsyła wzorzec 0xAA; v1 nie zna CMD8
+    bool version2 = false;
+    if ((command(CMD8, 0x1AA) & R1_ILLEGAL_COMMAND) == 0) {
+        uint8_t echo = 0;
+        for (uint8_t i = 0; i < 4; i++) echo = SPI.transfer(0xFF);
+        if (echo != 0xAA) {
+            deselect();
+            return false;
+        }
+        version2 = true;
+    }
+
+    start = millis();
+    while (appCommand(ACMD41, version2 ? 0x40000000UL : 0) != 0) {
+        if (millis() - start > INIT_TIMEOUT_MS) {
+            deselect();
+            return false;
+        }
+    }
+
+    _highCapacity = false;
+    if (version2) {
+        if (command(CMD58, 0) != 0) {
+            deselect();
+            return false;
+        }
+        _highCapacity = (SPI.transfer(0xFF) & 0x40) != 0;
+        for (uint8_t i = 0; i < 3; i++) SPI.transfer(0xFF);
+    }
+    if (!_highCapacity && command(CMD16, BLOCK_SIZE) != 0) {
+        deselect();
+        return false;
+    }
+
+    bool ok = readCsd();
+    deselect();
+    _spiClock = 8000000;
+    return ok;
+}
+
+bool SdSpiCard::readCsd() {
+    if (command(CMD9, 0) != 0 || !waitDataToken()) return false;
+
+    uint8_t csd[16];
+    for (uint8_t i = 0; i < 16; i++) csd[i] = SPI.transfer(0xFF);
+    SPI.transfer(0xFF);             // CRC16
+    SPI.transfer(0xFF);
+
+    if ((csd[0] >> 6) == 1) {
+        // CSD 2.0: (C_SIZE + 1) * 512 KB
+        uint32_t size = ((uint32_t)(csd[7] & 0x3F) << 16) | ((uint16_t)csd[8] << 8) | csd[9];
+        _blocks = (size + 1) << 10;
+    } else {
+        uint8_t readBlockLength = csd[5] & 0x0F;
+        uint16_t size = ((uint16_t)(csd[6] & 0x03) << 10) | ((uint16_t)csd[7] << 2) | (csd[8] >> 6);
+        uint8_t multiplier = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        _blocks = (uint32_t)(size + 1) << (multiplier + 2 + readBlockLength - 9);
+    }
+    return _blocks > 0;
+}
+
+bool SdSpiCard::startWrite(uint32_t block, uint32_t count) {
+    if (_writing || block >= _blocks) return false;
+    // Wstępne wymazanie - karta nie kasuje bloków w trakcie zapisu. Na kartach
+    // > 4 GB tylko początek obszaru, dalsze bloki karta kasuje sama
+    if (count > ACMD23_MAX_BLOCKS) count = ACMD23_MAX_BLOCKS;
+    if (count && appCommand(ACMD23, count) != 0) {
+        deselect();
+        return false;
+    }
+    if (command(CMD25, _highCapacity ? block : block << 9) != 0) {
+        deselect();
+        return false;
+    }
+    // CS zostaje aktywny do stopWrite() - karta jest jedynym urządzeniem SPI
+    _offset = 0;
+    _writing = true;
+    return true;
+}
+
+bool SdSpiCard::writeData(const uint8_t* data, uint16_t length) {
+    if (!_writing || _offset + length > BLOCK_SIZE) return false;
+    if (_offset == 0) SPI.transfer(TOKEN_WRITE_MULTIPLE);
+    for (uint16_t i = 0; i < length; i++) SPI.transfer(data[i]);
+    _offset += length;
+    if (_offset < BLOCK_SIZE) return true;
+
+    // Koniec bloku: CRC (ignorowane w SPI) i odpowiedź karty
+    _offset = 0;
+    SPI.transfer(0xFF);
+    SPI.transfer(0xFF);
+    return (SPI.transfer(0xFF) & 0x1F) == DATA_ACCEPTED;
+}
+
+bool SdSpiCard::busy() {
+    // W trakcie bloku 0xFF byłby kolejnym bajtem danych, a karta i tak
+    // programuje blok dopiero po ostatnim bajcie
+    if (_offset != 0) return false;
+    // Karta trzyma MISO w stanie niskim do końca programowania
+    return _writing && SPI.transfer(0xFF) != 0xFF;
+}
+
+bool SdSpiCard::stopWrite() {
+    if (!_writing) return false;
+    _writing = false;
+    bool ok = waitReady(BUSY_TIMEOUT_MS);
+    SPI.transfer(TOKEN_STOP_TRAN);
+    SPI.transfer(0xFF);
+    ok = waitReady(BUSY_TIMEOUT_MS) && ok && _offset == 0;
+    deselect();
+    return ok;
+}
+
+bool SdSpiCard::readData(uint32_t block, uint16_t offset, uint8_t* data, uint16_t length) {
+    if (_writing || block >= _blocks || offset + length > BLOCK_SIZE) return false;
+    bool ok = command(CMD17, _highCapacity ? block : block << 9) == 0 && waitDataToken();
+    if (ok) {
+        // Blok zawsze w całości, zostają tylko żądane bajty
+        for (uint16_t i = 0; i < BLOCK_SIZE; i++) {
+            uint8_t value = SPI.transfer(0xFF);
+            if (i >= offset && i - offset < length) data[i - offset] = value;
+        }
+        SPI.transfer(0xFF);         // CRC16
+        SPI.transfer(0xFF);
+    }
+    deselect();
+    return ok;
+}
+
+void SdSpiCard::select() {
+    if (_selected) return;
+    _selected = true;
+    SPI.beginTransaction(SPISettings(_spiClock, MSBFIRST, SPI_MODE0));
+    digitalWrite(_csPin, LOW);
+}
+
+void SdSpiCard::deselect() {
+    if (!_selected) return;
+    _selected = false;
+    digitalWrite(_csPin, HIGH);
+    SPI.transfer(0xFF);             // Karta zwalnia MISO po takcie z CS wysokim
+    SPI.endTransaction();
+}
+
+bool SdSpiCard::waitReady(uint16_t timeoutMs) {
+    uint32_t start = millis();
+    while (SPI.transfer(0xFF) != 0xFF) {
+        if (millis() - start > timeoutMs) return false;
+    }
+    return true;
+}
+
+// Czeka na początek bloku danych po komendzie odczytu
+bool SdSpiCard::waitDataToken() {
+    uint32_t start = millis();
+    uint8_t token;
+    while ((token = SPI.transfer(0xFF)) == 0xFF) {
+        if (millis() - start > INIT_TIMEOUT_MS) return false;
+    }
+    return token == TOKEN_DATA;
+}
+
+// Wysyła komendę i zwraca odpowiedź R1; CS zostaje aktywny dla danych
+uint8_t SdSpiCard::command(uint8_t index, uint32_t argument) {
+    select();
+    if (index != CMD0) waitReady(BUSY_TIMEOUT_MS);
+
+    SPI.transfer(0x40 | index);
+    for (int8_t shift = 24; shift >= 0; shift -= 8) SPI.transfer(argument >> shift);
+    // CRC wymagane tylko przed włączeniem trybu SPI (CMD0) i dla CMD8
+    uint8_t crc = 0xFF;
+    if (index == CMD0) crc = 0x95;
+    if (index == CMD8) crc = 0x87;
+    SPI.transfer(crc);
+
+    uint8_t response = 0xFF;
+    for (uint8_t i = 0; i < 10 && (response & 0x80); i++) response = SPI.transfer(0xFF);
+    return response;
+}
+
+uint8_t SdSpiCard::appCommand(uint8_t index, uint32_t argument) {
+    command(CMD55, 0);
+    return command(index, argument);
+}
@@ -0,0 +1,330 @@
+#include "SlaveEmulator.h"
+
+// Rejestry wejściowe: okres sinusoidy 0..2000, jak odczyt czujnika
+static const uint16_t INPUT_REGISTERS[SlaveEmulator::INPUT_COUNT] PROGMEM = {
+    1000, 1098, 1195, 1290, 1383, 1471, 1556, 1634,
+    1707, 1773, 1831, 1882, 1924, 1957, 1981, 1995,
+    2000, 1995, 1981, 1957, 1924, 1882, 1831, 1773,
+    1707, 1634, 1556, 1471, 1383, 1290, 1195, 1098,
+    1000, 902, 805, 710, 617, 529, 444, 366,
+    293, 227, 169, 118, 76, 43, 19, 5,
+    0, 5, 19, 43, 76, 118, 169, 227,
+    293, 366, 444, 529, 617, 710, 805, 902,
+};
+
+void EmulatorFaults::set(uint8_t crc, uint8_t exception, uint8_t drop, uint16_t delay, uint8_t code) {
+    crcPercent = crc > 100 ? 100 : crc;
+    exceptionPercent = exception > 100 ? 100 : exception;
+    dropPercent = drop > 100 ? 100 : drop;
+    delayMs = delay;
+    exceptionCode = code ? code : BUSY_EXCEPTION;
+}
+
+void EmulatorFaults::show() const {
+    Serial.print(F("Bledy: CRC "));
+    Serial.print(crcPercent);
+    Serial.print(F("%, wyjatek 0x"));
+    if (exceptionCode < 0x10) Serial.print('0');
+    Serial.print(exceptionCode, HEX);
+    Serial.print(' ');
+    Serial.print(exceptionPercent);
+    Serial.print(F("%, brak odpowiedzi "));
+    Serial.print(dropPercent);
+    Serial.print(F("%, opoznienie "));
+    Serial.print(delayMs);
+    Serial.println(F(" ms"));
+}
+
+SlaveEmulator::SlaveEmulator(RtuTransport& transport, Clock& clock, const EmulatorFaults& faults)
+    : _transport(transport)
+    , _clock(clock)
+    , _running(false)
+    , _step(Step::LISTENING)
+    , _firstAddress(1)
+    , _slaveCount(1)
+    , _replyAddress(0)
+    , _replyFunction(0)
+    , _replyException(0)
+    , _replyStart(0)
+    , _replyLength(0)
+    , _replyBadCrc(false)
+    , _requestEndUs(0)
+    , _faults(faults)
+    , _random(1)
+    , _requests(0)
+    , _responses(0)
+    , _badRequests(0)
+    , _exceptions(0)
+    , _injectedExceptions(0)
+    , _injectedCrc(0)
+    , _dropped(0)
+    , _broadcasts(0)
+    , _latencyMinUs(0)
+    , _latencyMaxUs(0)
+    , _latencySumUs(0)
+    , _late(0)
+    , _startMs(0)
+    , _elapsedMs(0)
+{
+    for (uint8_t i = 0; i < HOLDING_COUNT; i++) _holding[i] = i;
+}
+
+bool SlaveEmulator::start(uint8_t firstAddress, uint8_t count, unsigned long baud) {
+    if (count == 0) count = 1;
+    if (firstAddress < 1 || count > MAX_SLAVES || firstAddress + count - 1 > 247 || baud == 0) {
+        Serial.println(F("Bledne adresy emulatora"));
+        return false;
+    }
+    _firstAddress = firstAddress;
+    _slaveCount = count;
+    _requests = 0;
+    _responses = 0;
+    _badRequests = 0;
+    _exceptions = 0;
+    _injectedExceptions = 0;
+    _injectedCrc = 0;
+    _dropped = 0;
+    _broadcasts = 0;
+    _latencyMinUs = 0;
+    _latencyMaxUs = 0;
+    _latencySumUs = 0;
+    _late = 0;
+    _elapsedMs = 0;
+    _random = (uint16_t)_clock.micros() | 1;
+
+    _transport.cancel();
+    if (baud != _transport.baud()) _transport.setBaud(baud);
+    _transport.clear();
+    _transport.listen();
+    _step = Step::LISTENING;
+    _running = true;
+    _startMs = _clock.millis();
+
+    Serial.print(F("Emulator slave: adresy "));
+    Serial.print(firstAddress);
+    if (count > 1) {
+        Serial.print('-');
+        Serial.print(firstAddress + count - 1);
+    }
+    Serial.print(F(" @ "));
+    Serial.print(baud);
+    Serial.println(F(" baud, STOP - raport"));
+    _faults.show();
+    return true;
+}
+
+void SlaveEmulator::stop() {
+    if (!_running) return;
+    _transport.cancel();
+    _elapsedMs = _clock.millis() - _startMs;
+    _running = false;
+}
+
+void SlaveEmulator::update() {
+    if (!_running) return;
+
+    _transport.poll();
+    if (_step == Step::DELAYING) {
+        uint32_t waitUs = _transport.timing().t35Us + _faults.delayMs * 1000UL;
+        if (_clock.micros() - _requestEndUs < waitUs) return;
+        _transport.send(*this, _replyLength);
+        _step = Step::SENDING;
+        return;
+    }
+    if (_transport.busy()) return;
+
+    if (_step == Step::SENDING) {
+        if (_transport.result() == RtuTransport::Result::SENT) {
+            _responses++;
+            recordLatency();
+        }
+        _step = Step::LISTENING;
+        _transport.listen();
+        return;
+    }
+
+    handleRequest();
+    if (_step == Step::LISTENING) _transport.listen();
+}
+
+void SlaveEmulator::handleRequest() {
+    const uint8_t* frame = _transport.response();
+    uint8_t length = _transport.responseLength();
+
+    if (_transport.result() != RtuTransport::Result::REQUEST) {
+        // Śmieci z linii liczą się tylko, gdy wyglądają na zapytanie do nas
+        if (length && isEmulated(frame[0])) _badRequests++;
+        return;
+    }
+
+    uint8_t address = frame[0];
+    uint8_t function = frame[1];
+    if (address == 0) {
+        // Rozgłoszenie: tylko zapis, bez odpowiedzi
+        if (function == 0x06 || function == 0x10) execute(frame, length, _transport.responseCount());
+        _broadcasts++;
+        return;
+    }
+    if (!isEmulated(address)) return;
+    _requests++;
+
+    if (chance(_faults.dropPercent)) {
+        _dropped++;
+        return;
+    }
+    uint8_t exception;
+    if (chance(_faults.exceptionPercent)) {
+        _injectedExceptions++;
+        exception = _faults.exceptionCode;
+    } else {
+        exception = execute(frame, length, _transport.responseCount());
+        if (exception) _exceptions++;
+    }
+    prepareReply(address, function, exception);
+    _replyBadCrc = chance(_faults.crcPercent);
+    if (_replyBadCrc) _injectedCrc++;
+
+    _requestEndUs = _transport.lastByteUs();
+    if (_faults.delayMs) {
+        _step = Step::DELAYING;
+        return;
+    }
+    // Transport sam odczeka t3.5 od ostatniego bajtu zapytania
+    _transport.send(*this, _replyLength);
+    _step = Step::SENDING;
+}
+
+// Wykonanie zapytania na banku; zwraca kod wyjątku, 0 gdy poprawne
+uint8_t SlaveEmulator::execute(const uint8_t* frame, uint8_t length, uint16_t received) {
+    uint8_t function = frame[1];
+    uint16_t start = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t count = ((uint16_t)frame[4] << 8) | frame[5];
+
+    switch (function) {
+        case 0x03:
+        case 0x04: {
+            uint8_t limit = function == 0x03 ? HOLDING_COUNT : INPUT_COUNT;
+            if (received != 8 || count == 0 || count > 125) return 0x03;
+            if ((uint32_t)start + count > limit) return 0x02;
+            _replyStart = start;
+            _replyLength = 5 + 2 * count;
+            return 0;
+        }
+        case 0x06:
+            if (received != 8) return 0x03;
+            if (start >= HOLDING_COUNT) return 0x02;
+            _holding[start] = count;
+            _replyLength = 8;
+            return 0;
+        case 0x10:
+            // Zapis musi zmieścić się w buforze transportu (11 rejestrów)
+            if (count == 0 || count > 123 || frame[6] != 2 * count || received != length
+                || received != 9 + 2 * count) {
+                return 0x03;
+            }
+            if ((uint32_t)start + count > HOLDING_COUNT) return 0x02;
+            for (uint8_t i = 0; i < count; i++) {
+                _holding[start + i] = ((uint16_t)frame[7 + 2 * i] << 8) | frame[8 + 2 * i];
+            }
+            _replyLength = 8;
+            return 0;
+        default:
+            return 0x01;
+    }
+}
+
+void SlaveEmulator::prepareReply(uint8_t address, uint8_t function, uint8_t exception) {
+    _replyAddress = address;
+    _replyFunction = function;
+    _replyException = exception;
+    if (exception) _replyLength = 5;
+}
+
+uint8_t SlaveEmulator::frameByte(uint8_t offset) {
+    if (offset == 0) _replyCrc.reset();
+    if (offset >= _replyLength - 2) {
+        // CRC młodszym bajtem naprzód; błąd wstrzyknięty negacją
+        uint16_t crc = _replyCrc.value();
+        if (_replyBadCrc) crc ^= 0xFFFF;
+        return offset == _replyLength - 2 ? crc & 0xFF : crc >> 8;
+    }
+    uint8_t data = dataByte(offset);
+    _replyCrc.update(data);
+    return data;
+}
+
+uint8_t SlaveEmulator::dataByte(uint8_t offset) const {
+    if (offset == 0) return _replyAddress;
+    if (_replyException) return offset == 1 ? (_replyFunction | 0x80) : _replyException;
+    if (offset == 1) return _replyFunction;
+    // Zapis: echo adresu i ilości z zapytania (bufor transportu nietknięty)
+    if (_replyFunction == 0x06 || _replyFunction == 0x10) return _transport.response()[offset];
+    if (offset == 2) return _replyLength - 5;
+
+    uint8_t index = _replyStart + (offset - 3) / 2;
+    uint16_t value = _replyFunction == 0x03 ? _holding[index] : pgm_read_word(&INPUT_REGISTERS[index]);
+    return ((offset - 3) & 1) ? value & 0xFF : value >> 8;
+}
+
+void SlaveEmulator::recordLatency() {
+    uint32_t latency = _transport.txStartUs() - _requestEndUs;
+    if (_responses == 1 || latency < _latencyMinUs) _latencyMinUs = latency;
+    if (latency > _latencyMaxUs) _latencyMaxUs = latency;
+    _latencySumUs += latency;
+    if (latency > targetUs() + _faults.delayMs * 1000UL) _late++;
+}
+
+uint32_t SlaveEmulator::targetUs() const {
+    const RtuTiming& timing = _transport.timing();
+    return timing.t35Us + timing.charUs;
+}
+
+bool SlaveEmulator::isEmulated(uint8_t address) const {
+    return address >= _firstAddress && address < _firstAddress + _slaveCount;
+}
+
+bool SlaveEmulator::chance(uint8_t percent) {
+    if (percent == 0) return false;
+    // xorshift16 - wystarczy do losowania błędów
+    _random ^= _random << 7;
+    _random ^= _random >> 9;
+    _random ^= _random << 8;
+    return _random % 100 < percent;
+}
+
+void SlaveEmulator::showSummary() const {
+    uint32_t elapsedMs = _running ? _clock.millis() - _startMs : _elapsedMs;
+
+    Serial.println(F("\n=== Emulator slave ==="));
+    Serial.print(F("Predkosc: "));
+    Serial.print(_transport.baud());
+    Serial.print(F(" baud, czas: "));
+    Serial.print(elapsedMs);
+    Serial.println(F(" ms"));
+    Serial.print(F("Zapytania: "));
+    Serial.print(_requests);
+    Serial.print(F(", odpowiedzi: "));
+    Serial.print(_responses);
+    Serial.print(F(", rozgloszeniowe: "));
+    Serial.println(_broadcasts);
+    Serial.print(F("Bledne zapytania: "));
+    Serial.print(_badRequests);
+    Serial.print(F(", wyjatki: "));
+    Serial.println(_exceptions);
+    Serial.print(F("Wstrzykniete: wyjatki "));
+    Serial.print(_injectedExceptions);
+    Serial.print(F(", CRC "));
+    Serial.print(_injectedCrc);
+    Serial.print(F(", brak odpowiedzi "));
+    Serial.println(_dropped);
+    Serial.print(F("Czas odpowiedzi min/sr/max [us]: "));
+    Serial.print(_latencyMinUs);
+    Serial.print('/');
+    Serial.print(_responses ? _latencySumUs / _responses : 0);
+    Serial.print('/');
+    Serial.print(_latencyMaxUs);
+    Serial.print(F(" (cel <= "));
+    Serial.print(targetUs() + _faults.delayMs * 1000UL);
+    Serial.print(F(" us), poza celem: "));
+    Serial.println(_late);
+}
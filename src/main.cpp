@@ -1,92 +1,435 @@
 #include <Arduino.h>
 #include "ModbusScanner.h"
 #include "ModbusAnalyzer.h"
+#include "Rs485Uart.h"
+#include "ArduinoHal.h"
+#include "AutoBaud.h"
+#include "CaptureStream.h"
+#include "DeviceCache.h"
+#include "Config.h"
+#include "RtuTransport.h"
+#include "Scheduler.h"
+#include "Button.h"
+#include "ModeArena.h"
+#include "RegisterMapper.h"
+#include "RegisterDump.h"
+#include "RegisterWatch.h"
+#include "SlaveEmulator.h"
+#include "ModbusGateway.h"
+#include "Profiler.h"
+#ifdef SD_LOG
+#include "SdSpiCard.h"
+#include "SdLogger.h"
+#endif
 
 const uint8_t RS485_DIR_PIN = 2;
 const uint8_t MASTER_BUTTON = 8;    // Analiza mastera
 const uint8_t SCAN_BUTTON = 9;      // Skanowanie slave
 const uint8_t STOP_BUTTON = 10;     // Stop
 const uint8_t LED_PIN = 13;
+const uint8_t SD_CS_PIN = 4;        // Karta SD na SPI (złącze ICSP)
+const uint8_t COMMAND_SIZE = 48;     // Mieści wyrażenie filtra
+const uint8_t TRIGGER_POST_FRAMES = 4; // Domyślnie ramek po wyzwoleniu
+const uint8_t FLOW_REPORT_TOP = 5;     // Domyślnie wierszy tabeli przepływów
 
 enum class Mode {
     IDLE,
     SCANNING,
-    ANALYZING
+    ANALYZING,
+    LOAD_TEST,
+    MAPPING,
+    DUMPING,
+    WATCHING,
+    EMULATING,
+    GATEWAY
 } currentMode = Mode::IDLE;
 
-ModbusScanner scanner(Serial1, RS485_DIR_PIN);
-ModbusAnalyzer analyzer(Serial1);
+Rs485Uart rs485;
+ArduinoClock hwClock;
+ArduinoGpio hwGpio;
+ArduinoEeprom hwEeprom;
+DeviceCache deviceCache(hwEeprom);
+RtuTransport transport(rs485, hwGpio, hwClock, RS485_DIR_PIN);
+ModbusAnalyzer analyzer(transport, hwClock);
+// Tryby pracy (skaner, test obciążenia, mapa, zrzut, obserwacja, emulator,
+// bramka) i bufory logu SD na zmianę we wspólnej pamięci
+ModeArena arena(transport, hwClock, Serial, deviceCache);
+AutoBaud autoBaud;
+CaptureStream capture(Serial);
+#ifdef SD_LOG
+SdSpiCard sdCard(SD_CS_PIN);
+const size_t SD_LOG_SRAM = sizeof(sdCard);
+#else
+const size_t SD_LOG_SRAM = 0;
+#endif
+#ifdef PROFILE
+const size_t PROFILE_SRAM = Profiler::SRAM_BYTES;
+#else
+const size_t PROFILE_SRAM = 0;
+#endif
+Scheduler<SCHEDULER_MAX_TASKS> scheduler;
+Button scanButton(hwGpio, SCAN_BUTTON);
+Button masterButton(hwGpio, MASTER_BUTTON);
+Button stopButton(hwGpio, STOP_BUTTON);
 unsigned long lastBlink = 0;
 bool ledState = false;
+char commandLine[COMMAND_SIZE];
+uint8_t commandLength = 0;
+// Wszystkie zmienne globalne szkicu; szczegóły po kompilacji: tools/sram_report.py
+static_assert(sizeof(currentMode) + sizeof(rs485) + sizeof(hwClock) + sizeof(hwGpio)
+              + sizeof(hwEeprom) + sizeof(deviceCache) + sizeof(transport) + sizeof(analyzer)
+              + sizeof(arena) + sizeof(autoBaud) + sizeof(capture) + SD_LOG_SRAM + PROFILE_SRAM
+              + sizeof(scheduler) + sizeof(scanButton) + sizeof(masterButton) + sizeof(stopButton)
+              + sizeof(lastBlink) + sizeof(ledState) + sizeof(commandLine) + sizeof(commandLength)
+              <= SRAM_STATIC_BUDGET,
+              "Obiekty globalne przekraczaja budzet SRAM (Config.h)");
 
-void setup() {
-    pinMode(LED_PIN, OUTPUT);
-    pinMode(MASTER_BUTTON, INPUT_PULLUP);
-    pinMode(SCAN_BUTTON, INPUT_PULLUP);
-    pinMode(STOP_BUTTON, INPUT_PULLUP);
-    pinMode(RS485_DIR_PIN, OUTPUT);
-    digitalWrite(RS485_DIR_PIN, LOW);
-    
-    Serial.begin(115200);
-    scanner.begin();
-    analyzer.begin();
-    
-    Serial.println(F("\nModbus Scanner & Analyzer v1.0"));
-    Serial.println(F("1. SCAN (PIN 9) - skanowanie slave"));
-    Serial.println(F("2. MASTER (PIN 8) - nasłuchiwanie mastera"));
-    Serial.println(F("3. STOP (PIN 10) - zatrzymanie i raport"));
+// "load [03:04] [rejestry]", np. "load 3:1 10"
+void startLoadTest(const char* args) {
+    char* end;
+    uint8_t holding = 1, input = 0, registers = 10;
+    if (*args) {
+        holding = strtoul(args, &end, 10);
+        if (*end == ':') input = strtoul(end + 1, &end, 10);
+        if (*end == ' ') registers = strtoul(end + 1, &end, 10);
+    }
+    arena.loadTester().configure(holding, input, registers);
+
+    // Urządzenia z ostatniego skanowania, a bez niego lista z EEPROM
+    const DeviceInfo* devices = arena.scanResult().devices;
+    uint8_t count = arena.scanResult().count;
+    DeviceInfo cached[SCANNER_MAX_DEVICES];
+    if (count == 0) {
+        count = deviceCache.load(cached, SCANNER_MAX_DEVICES);
+        devices = cached;
+    }
+    if (arena.loadTester().start(devices, count)) {
+        currentMode = Mode::LOAD_TEST;
+    }
 }
 
-void loop() {
-    if (currentMode != Mode::IDLE) {
-        unsigned long interval = (currentMode == Mode::SCANNING) ? 500 : 100;
-        if (millis() - lastBlink >= interval) {
-            ledState = !ledState;
-            digitalWrite(LED_PIN, ledState);
-            lastBlink = millis();
-        }
+// Prędkość urządzenia z ostatniego skanowania lub listy w EEPROM,
+// a gdy go tam nie ma - bieżąca
+unsigned long deviceBaud(uint8_t address) {
+    const DeviceInfo* devices = arena.scanResult().devices;
+    uint8_t count = arena.scanResult().count;
+    DeviceInfo cached[SCANNER_MAX_DEVICES];
+    if (count == 0) {
+        count = deviceCache.load(cached, SCANNER_MAX_DEVICES);
+        devices = cached;
+    }
+    unsigned long baud = transport.baud();
+    for (uint8_t i = 0; i < count; i++) {
+        if (devices[i].address == address) baud = devices[i].baudRate;
+    }
+    return baud;
+}
+
+// "map <adres>"
+void startMapping(const char* args) {
+    uint8_t address = strtoul(args, nullptr, 10);
+    if (arena.mapper().start(address, deviceBaud(address))) {
+        currentMode = Mode::MAPPING;
+    }
+}
+
+// "dump <adres> <rejestr> <ilosc> [04]", np. "dump 5 0 500"
+void startDump(const char* args) {
+    char* end;
+    uint8_t address = strtoul(args, &end, 10);
+    uint16_t first = strtoul(end, &end, 10);
+    uint16_t count = strtoul(end, &end, 10);
+    uint8_t function = strtoul(end, &end, 10) == 4 ? 0x04 : 0x03;
+    if (arena.registerDump().start(address, deviceBaud(address), function, first, count)) {
+        currentMode = Mode::DUMPING;
+    }
+}
+
+// "slave <adres> [liczba] [baud]", np. "slave 10 4 19200"
+void startEmulator(const char* args) {
+    char* end;
+    uint8_t address = strtoul(args, &end, 10);
+    uint8_t count = strtoul(end, &end, 10);
+    unsigned long baud = strtoul(end, &end, 10);
+    if (arena.emulator().start(address, count, baud ? baud : transport.baud())) {
+        currentMode = Mode::EMULATING;
+    }
+}
+
+// "fault [crc_%] [wyjatek_%] [brak_%] [opoznienie_ms] [kod]", samo "fault" - bez błędów
+void setFaults(const char* args) {
+    char* end;
+    uint8_t crc = strtoul(args, &end, 10);
+    uint8_t exception = strtoul(end, &end, 10);
+    uint8_t drop = strtoul(end, &end, 10);
+    uint16_t delayMs = strtoul(end, &end, 10);
+    uint8_t code = strtoul(end, &end, 0);
+    arena.emulatorFaults().set(crc, exception, drop, delayMs, code);
+    arena.emulatorFaults().show();
+}
+
+// "timing <okno_ms> [proby] [dlugie_ms]", samo "timing" - bieżące ustawienia
+void setScanTiming(const char* args) {
+    if (*args) {
+        char* end;
+        uint16_t turnaroundMs = strtoul(args, &end, 10);
+        uint8_t slowRetries = strtoul(end, &end, 10);
+        uint16_t slowTimeoutMs = strtoul(end, &end, 10);
+        arena.scanTiming().set(turnaroundMs, slowRetries, slowTimeoutMs);
+    }
+    arena.scanTiming().show();
+}
+
+// "gw [baud]" - do STOP lub rekordu końca USB należy do bramki
+void startGateway(const char* args) {
+    unsigned long baud = strtoul(args, nullptr, 10);
+    if (arena.gateway().start(baud ? baud : transport.baud())) {
+        currentMode = Mode::GATEWAY;
+    }
+}
+
+// "filter <wyrazenie>", samo "filter" - bez filtra
+void setFilter(const char* args) {
+    if (analyzer.setFilter(args)) {
+        analyzer.showOutputSettings();
     } else {
-        digitalWrite(LED_PIN, LOW);
+        Serial.println(F("Bledne wyrazenie filtra"));
     }
-    
-    if (currentMode == Mode::IDLE) {
-        if (digitalRead(SCAN_BUTTON) == LOW) {
-            delay(50);
-            if (digitalRead(SCAN_BUTTON) == LOW) {
-                currentMode = Mode::SCANNING;
-                scanner.startScan();
-            }
+}
+
+// "trigger [ramki_po] <wyrazenie>", np. "trigger 8 a=5 err"; samo "trigger" - wylaczenie
+void setTrigger(const char* args) {
+    char* end;
+    uint8_t postFrames = TRIGGER_POST_FRAMES;
+    unsigned long value = strtoul(args, &end, 10);
+    if (end != args && (*end == ' ' || *end == '\0') && value <= UINT8_MAX) {
+        postFrames = value;
+        args = *end ? end + 1 : end;
+    }
+    if (analyzer.setTrigger(args, postFrames)) {
+        analyzer.showOutputSettings();
+    } else {
+        Serial.println(F("Bledne wyrazenie wyzwalacza"));
+    }
+}
+
+// "flows <sekundy> [wiersze]" - okresowa tabela przepływów zamiast ramek,
+// samo "flows" - wydruk ramek
+void setFlowReport(const char* args) {
+    char* end;
+    uint16_t periodS = strtoul(args, &end, 10);
+    uint8_t topCount = strtoul(end, &end, 10);
+    analyzer.setFlowReport(periodS, topCount ? topCount : FLOW_REPORT_TOP);
+    if (periodS == 0) {
+        Serial.println(F("Wydruk kazdej ramki"));
+        return;
+    }
+    Serial.print(F("Tabela przeplywow co "));
+    Serial.print(periodS);
+    Serial.println(F(" s"));
+}
+
+// Komenda z opcjonalnymi argumentami po spacji; args wskazuje ich początek.
+// Nazwa we flash (PSTR) - literały poza flash zajmowałyby SRAM
+bool matchCommand(const char* command, PGM_P name, const char*& args) {
+    size_t length = strlen_P(name);
+    if (strncmp_P(command, name, length) != 0) return false;
+    if (command[length] != '\0' && command[length] != ' ') return false;
+    args = command[length] ? command + length + 1 : command + length;
+    return true;
+}
+
+// "watch" - start obserwacji, "watch add <adres> <rejestr> [ilosc] [4]",
+// "watch band <adres> <rejestr> <pasmo>", "watch clear"
+void handleWatch(const char* args) {
+    const char* rest;
+    char* end;
+    if (matchCommand(args, PSTR("add"), rest)) {
+        uint8_t address = strtoul(rest, &end, 10);
+        uint16_t first = strtoul(end, &end, 10);
+        uint8_t count = strtoul(end, &end, 10);
+        uint8_t function = strtoul(end, &end, 10) == 4 ? 0x04 : 0x03;
+        if (arena.watchBlocks().add(address, function, first, count ? count : 1)) {
+            arena.watchBlocks().show();
         }
-        
-        if (digitalRead(MASTER_BUTTON) == LOW) {
-            delay(50);
-            if (digitalRead(MASTER_BUTTON) == LOW) {
-                currentMode = Mode::ANALYZING;
-                analyzer.startAnalysis();
-            }
+    } else if (matchCommand(args, PSTR("band"), rest)) {
+        uint8_t address = strtoul(rest, &end, 10);
+        uint16_t reg = strtoul(end, &end, 10);
+        uint16_t band = strtoul(end, &end, 10);
+        if (arena.watchBlocks().setDeadband(address, reg, band)) {
+            arena.watchBlocks().show();
+        }
+    } else if (strcmp_P(args, PSTR("clear")) == 0) {
+        arena.watchBlocks().clear();
+        Serial.println(F("Bloki obserwacji usuniete"));
+    } else if (*args == '\0') {
+        // Prędkość z listy urządzeń dla adresu pierwszego bloku
+        if (arena.registerWatch().start(deviceBaud(arena.watchBlocks().firstAddress()))) {
+            currentMode = Mode::WATCHING;
         }
+    } else {
+        Serial.print(F("Nieznana komenda: watch "));
+        Serial.println(args);
     }
-    
-    if (digitalRead(STOP_BUTTON) == LOW) {
-        delay(50);
-        if (digitalRead(STOP_BUTTON) == LOW) {
-            if (currentMode == Mode::SCANNING) {
-                scanner.stopScan();
-            } else if (currentMode == Mode::ANALYZING) {
-                analyzer.stop();
-                analyzer.showSummary();
+}
+
+#ifdef SD_LOG
+// Nasłuch bez komputera: rekordy binarne ramek na kartę SD zamiast na USB.
+// "sd force" - także na karcie z systemem plików
+void startSdLog(bool force) {
+    if (!sdCard.begin()) {
+        Serial.println(F("Brak karty SD"));
+        return;
+    }
+    ModeArena::SdLog& sdLog = arena.sdLog();
+    if (!sdLog.logger.begin(sdCard, micros(), 0, force)) return;
+    Serial.print(F("Log SD: "));
+    Serial.print(sdCard.blockCount() / 2048);
+    Serial.println(F(" MB, STOP konczy zapis"));
+    analyzer.setCaptureStream(&sdLog.capture);
+    currentMode = Mode::ANALYZING;
+    analyzer.startAnalysis();
+}
+
+void sdTask() {
+    if (arena.kind() == ModeArena::Kind::SD_LOGGER) arena.sdLog().logger.poll();
+}
+#endif
+
+#ifdef PROFILE
+// "prof" - liczniki etapów pętli, "prof reset" - od zera
+void showProfile(const char* args) {
+    if (strcmp_P(args, PSTR("reset")) == 0) {
+        Profiler::reset();
+        Serial.println(F("Profil wyzerowany"));
+        return;
+    }
+    Profiler::showStats();
+    Serial.print(F("Przepelnienia pierscienia RX: "));
+    Serial.println(transport.overflowCount());
+}
+#endif
+
+void handleCommand(const char* command) {
+    const char* args;
+    if (strcmp_P(command, PSTR("bin")) == 0) {
+        // Od tej chwili tylko rekordy binarne (tools/capture2pcap.py)
+        analyzer.setCaptureStream(&capture);
+    } else if (strcmp_P(command, PSTR("txt")) == 0) {
+        analyzer.setCaptureStream(nullptr);
+        Serial.println(F("Tryb tekstowy"));
+    } else if (currentMode == Mode::IDLE && strcmp_P(command, PSTR("scan")) == 0) {
+        currentMode = Mode::SCANNING;
+        arena.scanner().startScan(ScanMode::FULL);
+    } else if (currentMode == Mode::IDLE && strcmp_P(command, PSTR("verify")) == 0) {
+        currentMode = Mode::SCANNING;
+        arena.scanner().startScan(ScanMode::VERIFY);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("load"), args)) {
+        startLoadTest(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("map"), args)) {
+        startMapping(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("dump"), args)) {
+        startDump(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("watch"), args)) {
+        handleWatch(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("slave"), args)) {
+        startEmulator(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("gw"), args)) {
+        startGateway(args);
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("timing"), args)) {
+        setScanTiming(args);
+    } else if (matchCommand(command, PSTR("fault"), args)) {
+        setFaults(args);
+    } else if (matchCommand(command, PSTR("filter"), args)) {
+        setFilter(args);
+    } else if (matchCommand(command, PSTR("trigger"), args)) {
+        setTrigger(args);
+    } else if (matchCommand(command, PSTR("flows"), args)) {
+        setFlowReport(args);
+#ifdef SD_LOG
+    } else if (currentMode == Mode::IDLE && matchCommand(command, PSTR("sd"), args)) {
+        startSdLog(strcmp_P(args, PSTR("force")) == 0);
+#endif
+#ifdef PROFILE
+    } else if (matchCommand(command, PSTR("prof"), args)) {
+        showProfile(args);
+#endif
+    } else if (strcmp_P(command, PSTR("forget")) == 0) {
+        deviceCache.clear();
+        Serial.println(F("Lista urzadzen w EEPROM usunieta"));
+    } else {
+        Serial.print(F("Nieznana komenda: "));
+        Serial.println(command);
+    }
+}
+
+void pollCommands() {
+    PROFILE_SCOPE(COMMANDS);
+    // Rekordy binarne bramki czyta ModbusGateway
+    if (currentMode == Mode::GATEWAY) return;
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\n' || c == '\r') {
+            if (commandLength > 0) {
+                commandLine[commandLength] = '\0';
+                handleCommand(commandLine);
+                commandLength = 0;
             }
+        } else if (commandLength < COMMAND_SIZE - 1) {
+            commandLine[commandLength++] = c;
+        }
+    }
+}
+
+void stopMode() {
+    if (currentMode == Mode::SCANNING) {
+        arena.scanner().stopScan();
+    } else if (currentMode == Mode::ANALYZING) {
+        analyzer.stop();
+#ifdef SD_LOG
+        if (arena.kind() == ModeArena::Kind::SD_LOGGER) {
+            SdLogger& sdLogger = arena.sdLog().logger;
+            sdLogger.end();
+            analyzer.showSummary();
+            sdLogger.showSummary();
+            analyzer.setCaptureStream(nullptr);
             currentMode = Mode::IDLE;
-            digitalWrite(LED_PIN, LOW);
+            return;
         }
+#endif
+        analyzer.showSummary();
+    } else if (currentMode == Mode::LOAD_TEST) {
+        arena.loadTester().stop();
+        arena.loadTester().showSummary();
+    } else if (currentMode == Mode::MAPPING) {
+        arena.mapper().stop();
+        arena.mapper().showMap();
+    } else if (currentMode == Mode::DUMPING) {
+        arena.registerDump().stop();
+        arena.registerDump().showSummary();
+    } else if (currentMode == Mode::WATCHING) {
+        arena.registerWatch().stop();
+        arena.registerWatch().showSummary();
+    } else if (currentMode == Mode::EMULATING) {
+        arena.emulator().stop();
+        arena.emulator().showSummary();
+    } else if (currentMode == Mode::GATEWAY) {
+        arena.gateway().stop();
+        arena.gateway().showSummary();
     }
-    
+    currentMode = Mode::IDLE;
+}
+
+// Zadania planisty - żadne nie blokuje, więc STOP i LED reagują
+// także w trakcie skanowania
+
+void busTask() {
+    PROFILE_SCOPE(BUS);
     switch (currentMode) {
         case Mode::SCANNING:
-            scanner.update();
-            if (!scanner.isScanning()) {
+            arena.scanner().update();
+            if (!arena.scanner().isScanning()) {
                 currentMode = Mode::IDLE;
-                digitalWrite(LED_PIN, LOW);
             }
             break;
             
@@ -94,7 +437,138 @@ void loop() {
             analyzer.update();
             break;
             
+        case Mode::LOAD_TEST:
+            arena.loadTester().update();
+            break;
+
+        case Mode::MAPPING:
+            arena.mapper().update();
+            if (!arena.mapper().isRunning()) {
+                arena.mapper().showMap();
+                currentMode = Mode::IDLE;
+            }
+            break;
+
+        case Mode::DUMPING:
+            arena.registerDump().update();
+            if (!arena.registerDump().isRunning()) {
+                arena.registerDump().showSummary();
+                currentMode = Mode::IDLE;
+            }
+            break;
+
+        case Mode::WATCHING:
+            arena.registerWatch().update();
+            break;
+
+        case Mode::EMULATING:
+            arena.emulator().update();
+            break;
+
+        case Mode::GATEWAY:
+            arena.gateway().update();
+            if (!arena.gateway().isRunning()) {
+                arena.gateway().showSummary();
+                currentMode = Mode::IDLE;
+            }
+            break;
+            
         default:
             break;
     }
-}
\ No newline at end of file
+}
+
+void buttonTask() {
+    PROFILE_SCOPE(BUTTONS);
+    uint32_t now = millis();
+    scanButton.update(now);
+    masterButton.update(now);
+    stopButton.update(now);
+
+    if (currentMode == Mode::IDLE) {
+        if (scanButton.pressed()) {
+            currentMode = Mode::SCANNING;
+            arena.scanner().startScan(ScanMode::INCREMENTAL);
+        } else if (masterButton.pressed()) {
+            currentMode = Mode::ANALYZING;
+            analyzer.startAnalysis();
+        }
+    }
+    if (stopButton.pressed()) {
+        stopMode();
+    }
+    // Wciśnięcia w innym trybie są ignorowane, nie czekają na IDLE
+    scanButton.pressed();
+    masterButton.pressed();
+}
+
+void ledTask() {
+    PROFILE_SCOPE(LED);
+    if (currentMode == Mode::IDLE) {
+        ledState = false;
+        digitalWrite(LED_PIN, LOW);
+        return;
+    }
+    unsigned long interval = (currentMode == Mode::SCANNING || currentMode == Mode::MAPPING
+                             || currentMode == Mode::DUMPING || currentMode == Mode::WATCHING) ? 500
+                           : (currentMode == Mode::LOAD_TEST || currentMode == Mode::EMULATING
+                              || currentMode == Mode::GATEWAY) ? 250 : 100;
+    if (millis() - lastBlink >= interval) {
+        ledState = !ledState;
+        digitalWrite(LED_PIN, ledState);
+        lastBlink = millis();
+    }
+}
+
+void setup() {
+    pinMode(LED_PIN, OUTPUT);
+    scanButton.begin();
+    masterButton.begin();
+    stopButton.begin();
+    
+    Serial.begin(115200);
+    arena.scanner().begin();
+    analyzer.setAutoBaud(&autoBaud);
+    analyzer.begin();
+
+#ifdef PROFILE
+    Profiler::begin(hwClock);
+#endif
+    scheduler.add(busTask, 0);
+    scheduler.add(pollCommands, 0);
+    scheduler.add(buttonTask, 5);
+    scheduler.add(ledTask, 10);
+#ifdef SD_LOG
+    scheduler.add(sdTask, 0);
+#endif
+    
+    Serial.println(F("\nModbus Scanner & Analyzer v1.0"));
+    Serial.println(F("1. SCAN (PIN 9) - skanowanie slave (najpierw zapamietane)"));
+    Serial.println(F("2. MASTER (PIN 8) - nasłuchiwanie mastera"));
+    Serial.println(F("3. STOP (PIN 10) - zatrzymanie i raport"));
+    Serial.println(F("Komendy: bin - strumien binarny ramek, txt - tryb tekstowy"));
+    Serial.println(F("scan - pelne skanowanie, verify - tylko zapamietane, forget - usun liste"));
+    Serial.println(F("timing [okno_ms] [proby] [dlugie_ms] - okna odpowiedzi skanowania (0 = 120 ms)"));
+    Serial.println(F("load [03:04] [rejestry] - test obciazenia znalezionych urzadzen (STOP - raport)"));
+    Serial.println(F("map <adres> - zakresy cewek, wejsc i rejestrow urzadzenia"));
+    Serial.println(F("dump <adres> <rejestr> <ilosc> [4] - odczyt blokami po 125 rejestrow"));
+    Serial.println(F("watch add <adres> <rejestr> [ilosc] [4], watch band <adres> <rejestr> <pasmo>"));
+    Serial.println(F("watch - obserwacja blokow, tylko zmiany (STOP - raport), watch clear"));
+    Serial.println(F("slave <adres> [liczba] [baud] - emulacja urzadzen (STOP - raport)"));
+    Serial.println(F("fault [crc_%] [wyjatek_%] [brak_%] [opoznienie_ms] [kod] - bledy emulatora"));
+    Serial.println(F("gw [baud] - bramka USB-RS485, paczki zapytan binarnie (tools/gateway.py)"));
+    Serial.println(F("filter [a=1,5-9 f=3 r=100-199 err t>20] - wypisywane ramki"));
+    Serial.println(F("trigger [ramki_po] [wyrazenie] - historia i ramki wokol zdarzenia"));
+    Serial.println(F("flows [sekundy] [wiersze] - tabela przeplywow zamiast wydruku ramek"));
+#ifdef SD_LOG
+    Serial.println(F("sd [force] - nasluch z zapisem ramek na karte SD (STOP - koniec)"));
+#endif
+#ifdef PROFILE
+    Serial.println(F("prof [reset] - czasy etapow petli i petle dluzsze niz znak"));
+#endif
+}
+
+void loop() {
+    PROFILE_LOOP(transport.timing().charUs);
+    scheduler.run(millis());
+}
@@ -0,0 +1,882 @@
+// Program środowiska native: skanowanie i nasłuch na symulowanej magistrali.
+//
+//   pio run -e native && .pio/build/native/program scan
+//   .pio/build/native/program sniff -t 10 -m 19200:200
+//   .pio/build/native/program load -t 10 -l 3:1:10
+//   .pio/build/native/program replay -i zapis.trace -g zapis.golden
+//   .pio/build/native/program map -a 42
+//   .pio/build/native/program dump -a 42 -d 30000:250:4
+//   .pio/build/native/program slave -S 10:4 -m 19200:20 -f 5:5:5:0
+//   .pio/build/native/program gw -a 17 -B 500 -l 3:1:10
+//   .pio/build/native/program watch -a 17 -d 0:12 -D 0:5 -t 5
+//
+// Opcje:
+//   -s adres:baud:opoznienie_ms[:bledy_crc_%[:brak_odp_%]]  wirtualny slave
+//   -m baud:odstep_ms[:funkcja]  wirtualny master (tryb sniff), funkcja 3/4/6/16
+//   -t sekundy            czas nasłuchu / testu w czasie wirtualnym (sniff, load)
+//   -q                    bez wydruków analizatora/skanera (pomiar czasu)
+//   -b                    strumień binarny ramek na stdout (tryb sniff)
+//                         ... sniff -b | python3 tools/capture2pcap.py - out.pcap
+//   -e plik               EEPROM w pliku - lista urządzeń między uruchomieniami
+//   -r full|verify|inc    tryb skanowania (domyślnie inc, jak przycisk SCAN)
+//   -w okno_ms[:proby[:dlugie_ms]]  okno odpowiedzi skanowania (0 = stałe 120 ms) i próby
+//                         z długim oknem dla spóźnionych adresów (domyślnie 10:1:120)
+//   -l 03:04:rejestry     proporcja funkcji i liczba rejestrów (tryby load, gw)
+//   -n procent            zakłócenia: bajty z błędem ramki (FE)
+//   -F wyrazenie          filtr wypisywanych ramek, np. "a=4 err" (tryb sniff)
+//   -T wyrazenie          wyzwalacz: historia i 4 ramki po zdarzeniu (tryb sniff)
+//   -P sekundy[:wiersze]  tabela przepływów zamiast wydruku ramek (tryb sniff)
+//   -L obraz[:MB]         log ramek na kartę SD w pliku obrazu (tryb sniff, domyślnie 64 MB)
+//                         ... python3 tools/capture2pcap.py --sd obraz out.pcap
+//   -W blok_us[:przestoj_ms]  czas programowania bloku karty i przestój co 128 bloków
+//   -R plik               zapis bajtów z linii do pliku trace (tryb sniff)
+//   -i plik               plik trace do odtworzenia (tryb replay)
+//   -g plik / -G plik     porównanie podsumowania z wzorcem / zapis nowego wzorca
+//   -a adres              urządzenie (tryby map, dump; domyślnie pierwsze znalezione)
+//   -d rejestr:ilosc[:funkcja]  zakres zrzutu lub obserwacji (tryby dump, watch), funkcja 3/4
+//   -D rejestr:pasmo      pasmo martwe obserwowanego rejestru (tryb watch), można powtarzać
+//   -S adres[:liczba]     emulowane adresy (tryb slave), odpytywane przez master -m
+//   -f crc:wyjatek:brak[:opoznienie_ms[:kod]]  błędy emulatora w % (tryb slave)
+//   -B liczba             zapytania w paczce dla bramki (tryb gw)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "ModbusScanner.h"
+#include "ModbusAnalyzer.h"
+#include "RtuTransport.h"
+#include "LoadTester.h"
+#include "ModeArena.h"
+#include "RegisterMapper.h"
+#include "RegisterDump.h"
+#include "RegisterWatch.h"
+#include "SlaveEmulator.h"
+#include "ModbusGateway.h"
+#include "Profiler.h"
+#include "AutoBaud.h"
+#include "CaptureStream.h"
+#include "DeviceCache.h"
+#include "SdLogger.h"
+#include "SimBus.h"
+#include "SimCard.h"
+#include "SimClock.h"
+#include "SimEeprom.h"
+#include "SimGpio.h"
+#include "SimSerial.h"
+#include "SimTrace.h"
+
+static const uint8_t RS485_DIR_PIN = 2;
+static const uint8_t TRIGGER_POST_FRAMES = 4;
+static const uint64_t REPLAY_STEP_US = 1000;        // Najdłuższy skok zegara w ciszy
+static const uint64_t REPLAY_TAIL_US = 2000000;     // Po końcu pliku: timeouty, ostatnia ramka
+static const uint32_t WATCH_LIVE_STEP_US = 50000;   // Tempo zmian obserwowanych rejestrów
+static const uint8_t WATCH_MAX_DEADBANDS = 8;
+
+// Urządzenie z mapą jak u producentów: przerwy, bazy 3xxxx/4xxxx, cewki
+static const SimTable DEMO_TABLES[] = {
+    {0x01, 0, 16}, {0x01, 100, 32},
+    {0x02, 0, 8},
+    {0x03, 0, 64}, {0x03, 980, 120}, {0x03, 40001, 10},
+    {0x04, 30000, 250},
+};
+
+static const SimSlave DEFAULT_SLAVES[] = {
+    {1, 9600, 5000, 0, 0, 64, nullptr, 0},
+    {17, 19200, 3000, 0, 0, 64, nullptr, 0},
+    {42, 38400, 2000, 0, 0, 64, DEMO_TABLES, sizeof(DEMO_TABLES) / sizeof(DEMO_TABLES[0])},
+    {100, 115200, 1000, 0, 0, 64, nullptr, 0},
+};
+
+static bool parseSlave(const char* arg, SimSlave& slave) {
+    unsigned int address = 0, delayMs = 0, crcErrors = 0, noResponse = 0;
+    unsigned long baud = 0;
+    int n = sscanf(arg, "%u:%lu:%u:%u:%u", &address, &baud, &delayMs, &crcErrors, &noResponse);
+    if (n < 3 || address < 1 || address > 247 || baud == 0) return false;
+    slave.address = address;
+    slave.baud = baud;
+    slave.responseDelayUs = delayMs * 1000UL;
+    slave.crcErrorPercent = crcErrors;
+    slave.noResponsePercent = noResponse;
+    slave.registerCount = 64;
+    slave.tables = nullptr;
+    slave.tableCount = 0;
+    return true;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int runScan(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                   Storage& eeprom, ScanMode mode, const ScanTiming& timing) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    ScanResult result;
+    ModbusScanner scanner(transport, clock, result, timing);
+    DeviceCache cache(eeprom);
+    scanner.setDeviceCache(&cache);
+    scanner.begin();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t virtualStart = clock.now();
+    scanner.startScan(mode);
+    while (scanner.isScanning()) {
+        scanner.update();
+    }
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    printf("\n=== Skanowanie (symulacja) ===\n");
+    printf("Znalezione urzadzenia: %u\n", scanner.getFoundDevicesCount());
+    const DeviceInfo* devices = scanner.getFoundDevices();
+    for (uint8_t i = 0; i < scanner.getFoundDevicesCount(); i++) {
+        printf("  adres %u @ %lu baud\n", devices[i].address, devices[i].baudRate);
+    }
+    printf("Zapytania na magistrali: %u\n", (unsigned)bus.requestCount());
+    printf("Czas wirtualny: %.3f s\n", (clock.now() - virtualStart) / 1e6);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+static int runLoad(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                   Storage& eeprom, ScanMode mode, uint32_t seconds,
+                   uint8_t holding, uint8_t input, uint8_t registers) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    DeviceCache cache(eeprom);
+    // Skaner i test we wspólnym obszarze, jak w firmware
+    ModeArena arena(transport, clock, Serial, cache);
+    ModbusScanner& scanner = arena.scanner();
+    scanner.begin();
+
+    // Najpierw skanowanie, jak na urządzeniu przed komendą "load"
+    scanner.startScan(mode);
+    while (scanner.isScanning()) {
+        scanner.update();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t requestsBefore = bus.requestCount();
+    LoadTester& tester = arena.loadTester();
+    tester.configure(holding, input, registers);
+    if (!tester.start(arena.scanResult().devices, arena.scanResult().count)) return 1;
+    uint64_t end = clock.now() + (uint64_t)seconds * 1000000ULL;
+    while (clock.now() < end) {
+        tester.update();
+    }
+    tester.stop();
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    tester.showSummary();
+    printf("Zapytania na magistrali: %u\n", (unsigned)(bus.requestCount() - requestsBefore));
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+// Prędkość urządzenia z wyniku skanowania, jak komendy "map"/"dump" na urządzeniu
+static const DeviceInfo* scanForDevice(ModeArena& arena, ScanMode mode, uint8_t address,
+                                       bool quiet) {
+    ModbusScanner& scanner = arena.scanner();
+    scanner.begin();
+    Serial.setMuted(true);
+    scanner.startScan(mode);
+    while (scanner.isScanning()) {
+        scanner.update();
+    }
+    Serial.setMuted(quiet);
+
+    const ScanResult& result = arena.scanResult();
+    for (uint8_t i = 0; i < result.count; i++) {
+        if (address == 0 || result.devices[i].address == address) return &result.devices[i];
+    }
+    fprintf(stderr, "Brak urzadzenia %u w wyniku skanowania\n", address);
+    return nullptr;
+}
+
+static int runMap(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                  Storage& eeprom, ScanMode mode, uint8_t address, bool quiet) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    DeviceCache cache(eeprom);
+    ModeArena arena(transport, clock, Serial, cache);
+
+    const DeviceInfo* device = scanForDevice(arena, mode, address, quiet);
+    if (!device) return 1;
+    RegisterMapper& mapper = arena.mapper();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t requestsBefore = bus.requestCount();
+    uint64_t virtualStart = clock.now();
+    if (!mapper.start(device->address, device->baudRate)) return 1;
+    while (mapper.isRunning()) {
+        mapper.update();
+    }
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    mapper.showMap();
+    printf("Zapytania na magistrali: %u\n", (unsigned)(bus.requestCount() - requestsBefore));
+    printf("Czas wirtualny: %.3f s\n", (clock.now() - virtualStart) / 1e6);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+static int runDump(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                   Storage& eeprom, ScanMode mode, uint8_t address, bool quiet,
+                   uint8_t function, uint16_t first, uint16_t count) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    DeviceCache cache(eeprom);
+    ModeArena arena(transport, clock, Serial, cache);
+
+    const DeviceInfo* device = scanForDevice(arena, mode, address, quiet);
+    if (!device) return 1;
+    RegisterDump& dump = arena.registerDump();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t requestsBefore = bus.requestCount();
+    uint64_t virtualStart = clock.now();
+    if (!dump.start(device->address, device->baudRate, function, first, count)) return 1;
+    while (dump.isRunning()) {
+        dump.update();
+    }
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    dump.showSummary();
+    printf("Zapytania na magistrali: %u\n", (unsigned)(bus.requestCount() - requestsBefore));
+    printf("Czas wirtualny: %.3f s\n", (clock.now() - virtualStart) / 1e6);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+// Opcje trybu watch
+struct WatchOptions {
+    uint8_t function;
+    uint16_t first;
+    uint16_t count;
+    uint16_t deadbandRegisters[WATCH_MAX_DEADBANDS];
+    uint16_t deadbands[WATCH_MAX_DEADBANDS];
+    uint8_t deadbandCount;
+};
+
+// Obserwacja zakresu urządzenia, którego rejestry zmieniają się w czasie
+static int runWatch(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                    Storage& eeprom, ScanMode mode, uint8_t address, bool quiet,
+                    uint32_t seconds, const WatchOptions& options) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    DeviceCache cache(eeprom);
+    ModeArena arena(transport, clock, Serial, cache);
+
+    const DeviceInfo* device = scanForDevice(arena, mode, address, quiet);
+    if (!device) return 1;
+    WatchBlocks& blocks = arena.watchBlocks();
+
+    // Zakres dzielony na bloki mieszczące się w buforze transportu
+    uint16_t count = std::min<uint16_t>(options.count, WatchBlocks::MAX_REGISTERS);
+    for (uint16_t offset = 0; offset < count; offset += WatchBlocks::MAX_BLOCK_REGISTERS) {
+        uint8_t block = std::min<uint16_t>(count - offset, WatchBlocks::MAX_BLOCK_REGISTERS);
+        if (!blocks.add(device->address, options.function, options.first + offset, block)) {
+            return 1;
+        }
+    }
+    for (uint8_t i = 0; i < options.deadbandCount; i++) {
+        if (!blocks.setDeadband(device->address, options.deadbandRegisters[i], options.deadbands[i])) {
+            return 1;
+        }
+    }
+    if (!quiet) blocks.show();
+    bus.setLiveRegisters(options.first, count, WATCH_LIVE_STEP_US);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t requestsBefore = bus.requestCount();
+    uint64_t virtualStart = clock.now();
+    uint64_t end = virtualStart + (uint64_t)seconds * 1000000ULL;
+    RegisterWatch& watch = arena.registerWatch();
+    if (!watch.start(device->baudRate)) return 1;
+    while (clock.now() < end) {
+        watch.update();
+    }
+    watch.stop();
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    watch.showSummary();
+    printf("Zapytania na magistrali: %u\n", (unsigned)(bus.requestCount() - requestsBefore));
+    printf("Czas wirtualny: %.3f s\n", (clock.now() - virtualStart) / 1e6);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+// Opcje trybu slave
+struct EmulatorOptions {
+    uint8_t firstAddress;
+    uint8_t count;
+    unsigned int crcPercent;
+    unsigned int exceptionPercent;
+    unsigned int dropPercent;
+    unsigned int delayMs;
+    unsigned int exceptionCode;
+};
+
+// Emulator na porcie symulacji, wirtualny master odpytuje emulowane adresy
+static int runEmulator(SimClock& clock, const SimMaster& master, uint32_t seconds,
+                       const EmulatorOptions& options) {
+    SimBus bus(clock);
+    for (uint8_t i = 0; i < options.count; i++) {
+        // Slave'y symulacji tylko wyznaczają adresy mastera - odpowiada emulator
+        SimSlave slave = {(uint8_t)(options.firstAddress + i), master.baud, 0, 0, 100, 0, nullptr, 0};
+        bus.addSlave(slave);
+    }
+    SimGpio gpio;
+    SimSerial port(bus, clock);
+
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    transport.begin(master.baud);
+    EmulatorFaults faults;
+    faults.set(options.crcPercent, options.exceptionPercent, options.dropPercent,
+               options.delayMs, options.exceptionCode);
+    SlaveEmulator emulator(transport, clock, faults);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!emulator.start(options.firstAddress, options.count, master.baud)) return 1;
+    bus.setMaster(master);
+    uint64_t end = clock.now() + (uint64_t)seconds * 1000000ULL;
+    while (clock.now() < end) {
+        emulator.update();
+    }
+    emulator.stop();
+    double wallMs = elapsedMs(start);
+
+    Serial.setMuted(false);
+    emulator.showSummary();
+    printf("Czas wirtualny: %u s\n", (unsigned)seconds);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+// Host bramki: paczka rekordów zapytań na wejściu, rekordy wyników w pamięci
+class GatewayHost : public Stream {
+public:
+    std::string input;
+    std::string output;
+
+    int available() override { return (int)(input.size() - _position); }
+    int read() override { return _position < input.size() ? (uint8_t)input[_position++] : -1; }
+    int peek() override { return _position < input.size() ? (uint8_t)input[_position] : -1; }
+    size_t write(uint8_t data) override {
+        output.push_back((char)data);
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override { return 64; }
+
+private:
+    size_t _position = 0;
+};
+
+static int runGateway(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                      Storage& eeprom, ScanMode mode, uint8_t address, bool quiet,
+                      unsigned int batch, uint8_t holding, uint8_t input, uint8_t registers) {
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    GatewayHost host;
+    DeviceCache cache(eeprom);
+    ModeArena arena(transport, clock, host, cache);
+
+    const DeviceInfo* device = scanForDevice(arena, mode, address, quiet);
+    if (!device) return 1;
+    ModbusGateway& gateway = arena.gateway();
+
+    // Cała paczka od razu - bramka czyta tyle, ile mieści kolejka
+    unsigned int weights = holding + input ? holding + input : 1;
+    for (unsigned int i = 0; i < batch; i++) {
+        uint8_t function = i % weights < holding ? 0x03 : 0x04;
+        const char record[] = {
+            (char)ModbusGateway::REQUEST_SYNC, 6, (char)(i & 0xFF), 0,
+            (char)device->address, (char)function, 0, 0, 0, (char)registers
+        };
+        host.input.append(record, sizeof(record));
+    }
+    host.input.append({(char)ModbusGateway::REQUEST_SYNC, 0});
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t requestsBefore = bus.requestCount();
+    uint64_t virtualStart = clock.now();
+    if (!gateway.start(device->baudRate)) return 1;
+    while (gateway.isRunning()) {
+        gateway.update();
+    }
+    double wallMs = elapsedMs(start);
+    double virtualS = (clock.now() - virtualStart) / 1e6;
+
+    // Wyniki oczami hosta: kolejność znaczników i statusy
+    unsigned int results = 0, ok = 0, outOfOrder = 0;
+    uint64_t turnaroundSumUs = 0;
+    const std::string& out = host.output;
+    size_t pos = 0;
+    while (pos + ModbusGateway::RESULT_HEADER_SIZE <= out.size()
+           && (uint8_t)out[pos] == ModbusGateway::RESULT_SYNC) {
+        const uint8_t* header = (const uint8_t*)out.data() + pos;
+        if (header[2] != (results & 0xFF)) outOfOrder++;
+        if (header[3] == (uint8_t)ModbusGateway::Status::OK) {
+            ok++;
+            turnaroundSumUs += header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+        }
+        results++;
+        pos += ModbusGateway::RESULT_HEADER_SIZE + header[1];
+    }
+
+    Serial.setMuted(false);
+    gateway.showSummary();
+    printf("Wyniki u hosta: %u (poprawne %u), poza kolejnoscia: %u, smieci: %u B\n", results, ok,
+           outOfOrder, (unsigned)(out.size() - pos));
+    printf("Sredni czas reakcji slave'a: %.0f us\n", ok ? (double)turnaroundSumUs / ok : 0.0);
+    printf("Zapytania na magistrali: %u, transakcje/s: %.0f\n",
+           (unsigned)(bus.requestCount() - requestsBefore), virtualS > 0 ? results / virtualS : 0.0);
+    printf("Czas wirtualny: %.3f s\n", virtualS);
+    printf("Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+// Opcje trybu sniff
+struct SniffOptions {
+    uint32_t seconds;
+    bool binary;
+    const char* filter;
+    const char* trigger;
+    uint16_t flowPeriodS;           // 0 - wydruk każdej ramki
+    uint8_t flowTop;
+    const char* logPath;            // Obraz karty SD, nullptr - bez logu
+    uint32_t logBlocks;
+    uint32_t blockUs;
+    uint32_t stallUs;
+};
+
+static int runSniff(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                    const SniffOptions& options) {
+    bool binary = options.binary;
+    uint32_t seconds = options.seconds;
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    ModbusAnalyzer analyzer(transport, clock);
+    AutoBaud autoBaud;
+    CaptureStream capture(Serial);
+    bus.setEdgeSink(&autoBaud);
+    analyzer.setAutoBaud(&autoBaud);
+    if (binary) analyzer.setCaptureStream(&capture);
+    if (!analyzer.setFilter(options.filter)
+        || !analyzer.setTrigger(options.trigger, TRIGGER_POST_FRAMES)) {
+        fprintf(stderr, "Nieprawidlowe wyrazenie filtra lub wyzwalacza\n");
+        return 2;
+    }
+    analyzer.setFlowReport(options.flowPeriodS, options.flowTop);
+
+    // Log SD zamiast strumienia na stdout
+    SimCard card(clock, options.logPath, options.logBlocks,
+                 options.blockUs, options.stallUs);
+    SdLogger logger(clock);
+    CaptureStream sdCapture(logger);
+    if (options.logPath) {
+        if (!card.isOpen() || !logger.begin(card, (uint32_t)time(nullptr), 0, false)) {
+            fprintf(stderr, "Nie mozna otworzyc obrazu karty: %s\n", options.logPath);
+            return 2;
+        }
+        analyzer.setCaptureStream(&sdCapture);
+    }
+    analyzer.begin();
+#ifdef PROFILE
+    Profiler::begin(clock);
+#endif
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t end = clock.now() + (uint64_t)seconds * 1000000ULL;
+    analyzer.startAnalysis();
+    while (clock.now() < end) {
+        PROFILE_LOOP(transport.timing().charUs);
+        analyzer.update();
+        logger.poll();
+    }
+    analyzer.stop();
+    logger.end();
+    double wallMs = elapsedMs(start);
+
+    // W trybie binarnym podsumowanie idzie na stderr, by nie mieszać strumieni
+    FILE* report = binary ? stderr : stdout;
+    if (binary) {
+        fflush(stdout);
+    } else {
+        Serial.setMuted(false);
+        analyzer.showSummary();
+        if (options.logPath) logger.showSummary();
+#ifdef PROFILE
+        Profiler::showStats();
+#endif
+    }
+    fprintf(report, "Zapytania mastera: %u, odpowiedzi: %u\n",
+            (unsigned)bus.requestCount(), (unsigned)bus.responseCount());
+    if (card.midBlockBusyCalls()) {
+        fprintf(stderr, "Blad: busy() karty w trakcie bloku: %u razy\n",
+                (unsigned)card.midBlockBusyCalls());
+        return 1;
+    }
+    fprintf(report, "Czas wirtualny: %u s\n", (unsigned)seconds);
+    fprintf(report, "Czas rzeczywisty: %.1f ms\n", wallMs);
+    return 0;
+}
+
+static bool readFile(FILE* file, std::string& content) {
+    char buffer[4096];
+    size_t n;
+    rewind(file);
+    content.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) content.append(buffer, n);
+    return !ferror(file);
+}
+
+// Porównanie wiersz po wierszu - pokazuje pierwszą różnicę
+static bool compareGolden(const std::string& actual, const char* path) {
+    FILE* file = fopen(path, "rb");
+    std::string expected;
+    if (!file || !readFile(file, expected)) {
+        if (file) fclose(file);
+        fprintf(stderr, "Brak wzorca: %s\n", path);
+        return false;
+    }
+    fclose(file);
+    if (actual == expected) {
+        printf("Wzorzec %s: zgodny\n", path);
+        return true;
+    }
+
+    size_t a = 0, e = 0;
+    unsigned line = 1;
+    while (true) {
+        size_t aEnd = actual.find('\n', a);
+        size_t eEnd = expected.find('\n', e);
+        std::string aLine = actual.substr(a, aEnd == std::string::npos ? std::string::npos : aEnd - a);
+        std::string eLine = expected.substr(e, eEnd == std::string::npos ? std::string::npos : eEnd - e);
+        if (aLine != eLine || aEnd == std::string::npos || eEnd == std::string::npos) {
+            printf("Wzorzec %s: ROZNICA w wierszu %u\n", path, line);
+            printf("  oczekiwano: %s\n", eLine.c_str());
+            printf("  otrzymano:  %s\n", aLine.c_str());
+            return false;
+        }
+        a = aEnd + 1;
+        e = eEnd + 1;
+        line++;
+    }
+}
+
+static int runReplay(SimClock& clock, SimBus& bus, SimSerial& port, SimGpio& gpio,
+                     const char* tracePath, const char* goldenPath, bool updateGolden) {
+    SimTrace trace;
+    if (!tracePath || !trace.open(tracePath)) {
+        fprintf(stderr, "Nieprawidlowy plik trace: %s\n", tracePath ? tracePath : "(brak -i)");
+        return 2;
+    }
+    RtuTransport transport(port, gpio, clock, RS485_DIR_PIN);
+    ModbusAnalyzer analyzer(transport, clock);
+    AutoBaud autoBaud;
+    bus.setEdgeSink(&autoBaud);
+    bus.setReplay(&trace);
+    analyzer.setAutoBaud(&autoBaud);
+    analyzer.begin();
+
+    // Bez wydruków ramek - mierzony jest sam tor analizy
+    Serial.setMuted(true);
+    std::chrono::steady_clock::duration analysis(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t end = UINT64_MAX;
+    analyzer.startAnalysis();
+    while (clock.now() < end) {
+        std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+        analyzer.update();
+        analysis += std::chrono::steady_clock::now() - updateStart;
+
+        uint64_t next = bus.nextReplayUs();
+        if (next == UINT64_MAX) {
+            if (end == UINT64_MAX) end = clock.now() + REPLAY_TAIL_US;
+            next = end;
+        }
+        // Cisza na linii: skok zegara zamiast aktywnego czekania
+        if (next > clock.now()) clock.advanceTo(std::min(next, clock.now() + REPLAY_STEP_US));
+    }
+    analyzer.stop();
+    double wallMs = elapsedMs(start);
+    double analysisMs = std::chrono::duration<double, std::milli>(analysis).count();
+
+    // Podsumowanie analizatora jest wynikiem porównywanym ze wzorcem
+    Serial.setMuted(false);
+    FILE* summary = goldenPath ? tmpfile() : stdout;
+    if (!summary) return 2;
+    Serial.setOutput(summary);
+    analyzer.showSummary();
+    Serial.setOutput(stdout);
+
+    int result = 0;
+    if (goldenPath) {
+        std::string actual;
+        readFile(summary, actual);
+        fclose(summary);
+        if (updateGolden) {
+            FILE* file = fopen(goldenPath, "wb");
+            if (!file || fwrite(actual.data(), 1, actual.size(), file) != actual.size()) result = 2;
+            if (file) fclose(file);
+            printf("Zapisano wzorzec %s\n", goldenPath);
+        } else if (!compareGolden(actual, goldenPath)) {
+            result = 1;
+        }
+    }
+
+    uint32_t frames = analyzer.masterInfo().totalFrames;
+    double virtualS = clock.now() / 1e6;
+    printf("\n=== Replay %s ===\n", tracePath);
+    printf("Bajty: %u @ %lu baud, ramki: %u\n", (unsigned)trace.entryCount(), trace.baud(),
+           (unsigned)frames);
+    printf("Czas wirtualny: %.3f s, rzeczywisty: %.1f ms (x%.0f)\n",
+           virtualS, wallMs, wallMs > 0 ? virtualS * 1000.0 / wallMs : 0.0);
+    if (frames && analysisMs > 0) {
+        printf("Analiza: %.1f ms, %.0f ramek/s, %.0f bajtow/s\n", analysisMs,
+               frames * 1000.0 / analysisMs, trace.entryCount() * 1000.0 / analysisMs);
+        printf("Koszt na ramke: %.0f ns (analiza), %.0f ns (z symulacja linii)\n",
+               analysisMs * 1e6 / frames, wallMs * 1e6 / frames);
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "scan";
+    SimSlave slaves[SimBus::MAX_SLAVES];
+    uint8_t slaveCount = 0;
+    SimMaster master = {19200, 200000, 0x03, 0, 10};
+    uint32_t seconds = 10;
+    bool quiet = false;
+    bool binary = false;
+    const char* eepromPath = nullptr;
+    ScanMode scanMode = ScanMode::INCREMENTAL;
+    ScanTiming scanTiming;
+    unsigned int holding = 1, input = 0, registers = 10;
+    uint8_t noise = 0;
+    SniffOptions sniff = {10, false, "", "", 0, 5, nullptr, 131072, 1000, 100000};
+    const char* recordPath = nullptr;
+    const char* tracePath = nullptr;
+    const char* goldenPath = nullptr;
+    bool updateGolden = false;
+    unsigned int mapAddress = 0;
+    unsigned int dumpFirst = 0, dumpCount = 125, dumpFunction = 3;
+    unsigned int batch = 100;
+    WatchOptions watchOptions;
+    watchOptions.deadbandCount = 0;
+    EmulatorOptions emulatorOptions = {10, 1, 0, 0, 0, 0, SlaveEmulator::BUSY_EXCEPTION};
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (slaveCount >= SimBus::MAX_SLAVES || !parseSlave(argv[++i], slaves[slaveCount])) {
+                fprintf(stderr, "Nieprawidlowy slave: %s\n", argv[i]);
+                return 2;
+            }
+            slaveCount++;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            unsigned int intervalMs = 0, function = master.function;
+            if (sscanf(argv[++i], "%lu:%u:%u", &master.baud, &intervalMs, &function) < 2) {
+                fprintf(stderr, "Nieprawidlowy master: %s\n", argv[i]);
+                return 2;
+            }
+            master.pollIntervalUs = intervalMs * 1000UL;
+            master.function = function;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            binary = true;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            eepromPath = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            unsigned int turnaroundMs = 0, retries = scanTiming.slowRetries;
+            unsigned int slowMs = scanTiming.slowTimeoutMs;
+            if (sscanf(argv[++i], "%u:%u:%u", &turnaroundMs, &retries, &slowMs) < 1
+                || turnaroundMs > 0xFFFF || retries > 0xFF || slowMs > 0xFFFF) {
+                fprintf(stderr, "Nieprawidlowe okno odpowiedzi: %s\n", argv[i]);
+                return 2;
+            }
+            scanTiming.set(turnaroundMs, retries, slowMs);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u:%u:%u", &holding, &input, &registers) < 2) {
+                fprintf(stderr, "Nieprawidlowa proporcja: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            noise = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            sniff.filter = argv[++i];
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            sniff.trigger = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            unsigned int periodS = 0, top = sniff.flowTop;
+            if (sscanf(argv[++i], "%u:%u", &periodS, &top) < 1 || top == 0) {
+                fprintf(stderr, "Nieprawidlowy okres przeplywow: %s\n", argv[i]);
+                return 2;
+            }
+            sniff.flowPeriodS = periodS;
+            sniff.flowTop = top;
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            static char path[256];
+            unsigned int megabytes = 64;
+            if (sscanf(argv[++i], "%255[^:]:%u", path, &megabytes) < 1 || megabytes == 0) {
+                fprintf(stderr, "Nieprawidlowy obraz karty: %s\n", argv[i]);
+                return 2;
+            }
+            sniff.logPath = path;
+            sniff.logBlocks = megabytes * 2048UL;
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            unsigned int blockUs = 0, stallMs = sniff.stallUs / 1000;
+            if (sscanf(argv[++i], "%u:%u", &blockUs, &stallMs) < 1) {
+                fprintf(stderr, "Nieprawidlowe czasy karty: %s\n", argv[i]);
+                return 2;
+            }
+            sniff.blockUs = blockUs;
+            sniff.stallUs = stallMs * 1000UL;
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if ((strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "-G") == 0) && i + 1 < argc) {
+            updateGolden = argv[i][1] == 'G';
+            goldenPath = argv[++i];
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            mapAddress = strtoul(argv[++i], nullptr, 10);
+            if (mapAddress < 1 || mapAddress > 247) {
+                fprintf(stderr, "Nieprawidlowy adres: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u:%u:%u", &dumpFirst, &dumpCount, &dumpFunction) < 2
+                || dumpFirst > 0xFFFF || dumpCount > 0xFFFF) {
+                fprintf(stderr, "Nieprawidlowy zakres: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            unsigned int reg = 0, band = 0;
+            if (watchOptions.deadbandCount >= WATCH_MAX_DEADBANDS
+                || sscanf(argv[++i], "%u:%u", &reg, &band) < 2 || reg > 0xFFFF || band > 0xFFFF) {
+                fprintf(stderr, "Nieprawidlowe pasmo martwe: %s\n", argv[i]);
+                return 2;
+            }
+            watchOptions.deadbandRegisters[watchOptions.deadbandCount] = reg;
+            watchOptions.deadbands[watchOptions.deadbandCount++] = band;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            unsigned int address = 0, count = 1;
+            if (sscanf(argv[++i], "%u:%u", &address, &count) < 1 || address < 1 || address > 247
+                || count < 1 || count > SlaveEmulator::MAX_SLAVES) {
+                fprintf(stderr, "Nieprawidlowe adresy emulatora: %s\n", argv[i]);
+                return 2;
+            }
+            emulatorOptions.firstAddress = address;
+            emulatorOptions.count = count;
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            EmulatorOptions& o = emulatorOptions;
+            if (sscanf(argv[++i], "%u:%u:%u:%u:%u", &o.crcPercent, &o.exceptionPercent,
+                       &o.dropPercent, &o.delayMs, &o.exceptionCode) < 3) {
+                fprintf(stderr, "Nieprawidlowe bledy emulatora: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            batch = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "full") == 0) {
+                scanMode = ScanMode::FULL;
+            } else if (strcmp(name, "verify") == 0) {
+                scanMode = ScanMode::VERIFY;
+            } else if (strcmp(name, "inc") == 0) {
+                scanMode = ScanMode::INCREMENTAL;
+            } else {
+                fprintf(stderr, "Nieznany tryb skanowania: %s\n", name);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Nieznana opcja: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    sniff.seconds = seconds;
+    sniff.binary = binary;
+
+    SimClock clock;
+    SimBus bus(clock);
+    SimGpio gpio;
+    SimSerial port(bus, clock);
+    SimEeprom eeprom(eepromPath);
+
+    if (slaveCount == 0) {
+        for (uint8_t i = 0; i < sizeof(DEFAULT_SLAVES) / sizeof(DEFAULT_SLAVES[0]); i++) {
+            bus.addSlave(DEFAULT_SLAVES[i]);
+        }
+    } else {
+        for (uint8_t i = 0; i < slaveCount; i++) {
+            bus.addSlave(slaves[i]);
+        }
+    }
+    bus.setNoise(noise);
+    Serial.setMuted(quiet);
+
+    if (strcmp(mode, "scan") == 0) {
+        return runScan(clock, bus, port, gpio, eeprom, scanMode, scanTiming);
+    }
+    if (strcmp(mode, "load") == 0) {
+        return runLoad(clock, bus, port, gpio, eeprom, scanMode, seconds, holding, input, registers);
+    }
+    if (strcmp(mode, "map") == 0) {
+        return runMap(clock, bus, port, gpio, eeprom, scanMode, mapAddress, quiet);
+    }
+    if (strcmp(mode, "dump") == 0) {
+        return runDump(clock, bus, port, gpio, eeprom, scanMode, mapAddress, quiet,
+                       dumpFunction, dumpFirst, dumpCount);
+    }
+    if (strcmp(mode, "watch") == 0) {
+        watchOptions.function = dumpFunction;
+        watchOptions.first = dumpFirst;
+        watchOptions.count = dumpCount;
+        return runWatch(clock, bus, port, gpio, eeprom, scanMode, mapAddress, quiet,
+                        seconds, watchOptions);
+    }
+    if (strcmp(mode, "gw") == 0) {
+        return runGateway(clock, bus, port, gpio, eeprom, scanMode, mapAddress, quiet,
+                          batch, holding, input, registers);
+    }
+    if (strcmp(mode, "slave") == 0) {
+        return runEmulator(clock, master, seconds, emulatorOptions);
+    }
+    if (strcmp(mode, "replay") == 0) {
+        return runReplay(clock, bus, port, gpio, tracePath, goldenPath, updateGolden);
+    }
+    if (strcmp(mode, "sniff") == 0) {
+        SimTrace recorder;
+        if (recordPath && !recorder.create(recordPath, master.baud)) {
+            fprintf(stderr, "Nie mozna utworzyc pliku trace: %s\n", recordPath);
+            return 2;
+        }
+        // Nasłuch: wszystkie slave'y na prędkości mastera
+        if (slaveCount == 0) {
+            SimBus sniffBus(clock);
+            for (uint8_t i = 0; i < sizeof(DEFAULT_SLAVES) / sizeof(DEFAULT_SLAVES[0]); i++) {
+                SimSlave slave = DEFAULT_SLAVES[i];
+                slave.baud = master.baud;
+                sniffBus.addSlave(slave);
+            }
+            sniffBus.setMaster(master);
+            sniffBus.setNoise(noise);
+            if (recordPath) sniffBus.setRecorder(&recorder);
+            SimSerial sniffPort(sniffBus, clock);
+            return runSniff(clock, sniffBus, sniffPort, gpio, sniff);
+        }
+        bus.setMaster(master);
+        if (recordPath) bus.setRecorder(&recorder);
+        return runSniff(clock, bus, port, gpio, sniff);
+    }
+
+    fprintf(stderr, "Uzycie: %s scan|sniff|load|map|dump|slave|gw|replay [-s ...] [-m baud:ms[:fn]] [-t s] [-q] [-b] [-e plik] [-r full|verify|inc] [-w ms[:proby[:ms]]] [-l 3:1:10] [-n proc] [-F expr] [-T expr] [-L obraz[:MB]] [-W us[:ms]] [-R trace] [-i trace] [-g|-G wzorzec] [-a adres] [-d rej:ile[:fn]] [-S adres[:ile]] [-f crc:wyj:brak[:ms[:kod]]] [-B paczka]\n", argv[0]);
+    return 2;
+}
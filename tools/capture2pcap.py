@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Konwersja binarnego strumienia ramek analizatora (komenda "bin") do pcap.
+
+Rekord strumienia (little-endian):
+    0xA5 | dlugosc N | nr sekwencji u16 | czas us u32 | flagi | N bajtow ramki
+
+Uzycie:
+    python3 tools/capture2pcap.py zrzut.bin wynik.pcap
+    python3 tools/capture2pcap.py --serial /dev/ttyACM0 --seconds 60 wynik.pcap
+    python3 tools/capture2pcap.py --sd karta.img wynik.pcap
+
+Log z karty SD (komenda "sd", obraz np. z dd if=/dev/sdX bs=512 count=...)
+to sektory 512 B: "MBLG" | sesja u32 | 504 B strumienia. Czytane sa kolejne
+sektory z sesja pierwszego - dalej sa juz stare dane z poprzednich logow.
+
+Plik pcap ma typ lacza DLT_USER0 (147). W Wiresharku: Edit > Preferences >
+Protocols > DLT_USER > Encapsulations Table, DLT=147, Payload protocol "mbrtu".
+Flagi rekordow (blad CRC, t1.5 itd.) sa podsumowane w raporcie na stderr.
+"""
+import argparse
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+HEADER = struct.Struct("<BBHIB")
+LINKTYPE_USER0 = 147
+SD_SECTOR = 512
+SD_HEADER = struct.Struct("<4sI")
+SD_MAGIC = b"MBLG"
+
+FLAG_NAMES = {
+    0x01: "CRC",
+    0x02: "t1.5",
+    0x04: "przepelnienie",
+    0x08: "krotka",
+    0x10: "blad ramki (FE)",
+    0x20: "parzystosc",
+    0x40: "utracone bajty",
+}
+
+
+def parse_records(data):
+    """Zwraca liste (seq, czas_us, flagi, bajty); pomija smieci miedzy rekordami."""
+    records = []
+    pos = 0
+    while pos + HEADER.size <= len(data):
+        if data[pos] != SYNC:
+            pos += 1
+            continue
+        _, length, seq, timestamp, flags = HEADER.unpack_from(data, pos)
+        end = pos + HEADER.size + length
+        if end > len(data):
+            break
+        records.append((seq, timestamp, flags, data[pos + HEADER.size:end]))
+        pos = end
+    return records
+
+
+def read_sd_log(data):
+    """Sklada strumien z sektorow logu SD biezacej sesji."""
+    stream = bytearray()
+    session = None
+    for pos in range(0, len(data) - SD_SECTOR + 1, SD_SECTOR):
+        magic, sector_session = SD_HEADER.unpack_from(data, pos)
+        if magic != SD_MAGIC or (session is not None and sector_session != session):
+            break
+        session = sector_session
+        stream += data[pos + SD_HEADER.size:pos + SD_SECTOR]
+    if session is None:
+        sys.stderr.write("Brak logu na karcie (naglowek MBLG)\n")
+    else:
+        sys.stderr.write("Sesja %08X, sektory: %d\n" % (session, len(stream) // (SD_SECTOR - SD_HEADER.size)))
+    return bytes(stream)
+
+
+def write_pcap(records, out):
+    out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, LINKTYPE_USER0))
+    wraps = 0
+    last_ts = None
+    for _, timestamp, _, frame in records:
+        # Licznik micros() przekreca sie co ~71 min
+        if last_ts is not None and timestamp < last_ts:
+            wraps += 1
+        last_ts = timestamp
+        total_us = wraps * (1 << 32) + timestamp
+        out.write(struct.pack("<IIII", total_us // 1000000, total_us % 1000000,
+                              len(frame), len(frame)))
+        out.write(frame)
+
+
+def report(records):
+    lost = 0
+    flagged = {}
+    for i in range(1, len(records)):
+        gap = (records[i][0] - records[i - 1][0] - 1) & 0xFFFF
+        lost += gap
+    for _, _, flags, _ in records:
+        for bit, name in FLAG_NAMES.items():
+            if flags & bit:
+                flagged[name] = flagged.get(name, 0) + 1
+    sys.stderr.write("Rekordy: %d, utracone (luki w sekwencji): %d\n" % (len(records), lost))
+    for name, count in sorted(flagged.items()):
+        sys.stderr.write("  %s: %d\n" % (name, count))
+
+
+def read_serial(port, seconds):
+    import serial  # pyserial, potrzebny tylko przy przechwytywaniu na zywo
+
+    with serial.Serial(port, 115200, timeout=0.1) as link:
+        link.write(b"bin\n")
+        data = bytearray()
+        end = time.time() + seconds
+        while time.time() < end:
+            data += link.read(4096)
+        link.write(b"txt\n")
+    return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="plik ze strumieniem lub '-' dla stdin")
+    parser.add_argument("output", help="plik wynikowy .pcap")
+    parser.add_argument("--serial", help="port analizatora do przechwytywania na zywo")
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--sd", action="store_true", help="wejscie to obraz karty SD z logiem")
+    args = parser.parse_args()
+
+    if args.serial:
+        data = read_serial(args.serial, args.seconds)
+    elif args.input == "-" or args.input is None:
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+
+    if args.sd:
+        data = read_sd_log(data)
+    records = parse_records(data)
+    with open(args.output, "wb") as out:
+        write_pcap(records, out)
+    report(records)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Zamiana zapisu ramek analizatora (strumien "bin" lub log z karty SD) na plik trace.
+
+Plik trace to wejscie trybu replay programu native:
+    "MBTR" | predkosc u32 | rekordy: czas us u32 | bajt | status
+
+Rekord ramki ma tylko czas pierwszego bajtu, wiec kolejne bajty dostaja
+czasy co czas znaku przy podanej predkosci. Statusy bajtow (FE, DOR) nie sa
+zapisywane w rekordach ramek - w trace sa zerowe.
+
+Uzycie:
+    python3 tools/capture2trace.py --baud 19200 zrzut.bin tools/replay/obiekt.trace
+    python3 tools/capture2trace.py --baud 9600 --sd karta.img tools/replay/obiekt.trace
+    pio run -e native && UPDATE=1 tools/replay/check.sh    # wzorzec nowego zapisu
+"""
+import argparse
+import struct
+import sys
+
+from capture2pcap import parse_records, read_sd_log
+
+MAGIC = b"MBTR"
+
+
+def char_us(baud):
+    # Jak RtuTiming: 11 bitow na znak, zaokraglenie
+    return (11 * 1000000 + baud // 2) // baud
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="plik ze strumieniem lub '-' dla stdin")
+    parser.add_argument("output", help="plik wynikowy .trace")
+    parser.add_argument("--baud", type=int, required=True, help="predkosc magistrali")
+    parser.add_argument("--sd", action="store_true", help="wejscie to obraz karty SD z logiem")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    if args.sd:
+        data = read_sd_log(data)
+
+    step = char_us(args.baud)
+    count = 0
+    with open(args.output, "wb") as out:
+        out.write(MAGIC + struct.pack("<I", args.baud))
+        for _, timestamp, _, frame in parse_records(data):
+            for i, byte in enumerate(frame):
+                out.write(struct.pack("<IBB", (timestamp + i * step) & 0xFFFFFFFF, byte, 0))
+                count += 1
+    sys.stderr.write("Bajty: %d @ %d baud\n" % (count, args.baud))
+
+
+if __name__ == "__main__":
+    main()
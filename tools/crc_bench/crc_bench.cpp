@@ -0,0 +1,109 @@
+// Porównanie wariantów CRC16 Modbus na hoście (bitowy, półbajtowy, tablicowy).
+//
+// Budowanie i uruchomienie z katalogu głównego projektu:
+//   g++ -O2 -Iinclude tools/crc_bench/crc_bench.cpp src/ModbusCRC.cpp -o crc_bench
+//   ./crc_bench > bench_output.txt
+//
+// Czas na bajt mierzony jest na hoście (TSC na x86, w innym przypadku ns),
+// więc liczby służą do porównania wariantów między sobą, a nie jako cykle AVR.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "ModbusCRC.h"
+
+typedef uint16_t (*CrcStep)(uint16_t crc, uint8_t byte);
+
+struct Variant {
+    const char* name;
+    CrcStep step;
+    uint16_t tableBytes;
+};
+
+static const uint32_t BUFFER_SIZE = 4096;
+static const uint32_t ROUNDS = 2000;
+
+static uint16_t runVariant(CrcStep step, const uint8_t* data, uint32_t length) {
+    uint16_t crc = ModbusCRC::INITIAL;
+    for (uint32_t i = 0; i < length; i++) {
+        crc = step(crc, data[i]);
+    }
+    return crc;
+}
+
+static uint64_t now() {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int main() {
+    const Variant variants[] = {
+        {"bitowy", ModbusCRC::updateBitwise, 0},
+        {"polbajtowy", ModbusCRC::updateNibble, ModbusCRC::NIBBLE_TABLE_BYTES},
+        {"tablicowy", ModbusCRC::updateTable, ModbusCRC::TABLE_BYTES},
+    };
+    const uint8_t variantCount = sizeof(variants) / sizeof(variants[0]);
+
+    // Wektor referencyjny: zapytanie 0x03 do adresu 1 -> CRC 0x0A84
+    const uint8_t query[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01};
+    const uint16_t expected = 0x0A84;
+
+    static uint8_t data[BUFFER_SIZE];
+    srand(1234);
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++) {
+        data[i] = rand() & 0xFF;
+    }
+
+    bool ok = true;
+    uint16_t reference = runVariant(variants[0].step, data, BUFFER_SIZE);
+    for (uint8_t v = 0; v < variantCount; v++) {
+        uint16_t q = runVariant(variants[v].step, query, sizeof(query));
+        uint16_t r = runVariant(variants[v].step, data, BUFFER_SIZE);
+        if (q != expected || r != reference) {
+            printf("BLAD: wariant %s daje 0x%04X / 0x%04X\n", variants[v].name, q, r);
+            ok = false;
+        }
+    }
+
+    // Wszystkie długości ramek 0..256 bajtów muszą zgadzać się z wariantem bitowym
+    for (uint32_t len = 0; len <= 256; len++) {
+        uint16_t ref = runVariant(ModbusCRC::updateBitwise, data, len);
+        if (ModbusCRC::calculate(data, len) != ref) {
+            printf("BLAD: calculate() dla dlugosci %u\n", (unsigned)len);
+            ok = false;
+        }
+    }
+
+    printf("%-12s %14s %12s\n", "wariant",
+#ifdef HAVE_TSC
+           "cykle/bajt",
+#else
+           "ns/bajt",
+#endif
+           "flash [B]");
+
+    volatile uint16_t sink = 0;
+    for (uint8_t v = 0; v < variantCount; v++) {
+        uint64_t start = now();
+        for (uint32_t r = 0; r < ROUNDS; r++) {
+            sink ^= runVariant(variants[v].step, data, BUFFER_SIZE);
+        }
+        uint64_t elapsed = now() - start;
+        double perByte = (double)elapsed / ((double)ROUNDS * BUFFER_SIZE);
+        printf("%-12s %14.2f %12u\n", variants[v].name, perByte, variants[v].tableBytes);
+    }
+    (void)sink;
+
+    printf("Zgodnosc wariantow: %s\n", ok ? "OK" : "BLAD");
+    return ok ? 0 : 1;
+}
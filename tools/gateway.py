@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Klient bramki USB-RS485 (komenda "gw"): paczki zapytan Modbus przez USB.
+
+Rekordy (little-endian):
+    host -> bramka: 0x5A | dlugosc N | znacznik | limit ms | N bajtow (adres + PDU, bez CRC)
+                    N = 0 konczy tryb bramki
+    bramka -> host: 0x5B | dlugosc N | znacznik | status | czas reakcji us u32 | N bajtow
+
+Zapytania sa wysylane z wyprzedzeniem (--window), wiec bramka ma zawsze
+nastepne w kolejce i wykonuje je bez czekania na USB. Gdy jej kolejka jest
+pelna, przestaje czytac USB - wyprzedzenie nie grozi utrata zapytan.
+
+Uzycie:
+    python3 tools/gateway.py /dev/ttyACM0 --bus-baud 19200 --read 5:0:10 --count 1000
+    python3 tools/gateway.py /dev/ttyACM0 --read 5:0:10 --read 6:100:4:4 --count 500 --show
+"""
+import argparse
+import struct
+import sys
+import time
+
+REQUEST_SYNC = 0x5A
+RESULT_SYNC = 0x5B
+RESULT_HEADER = struct.Struct("<BBBBI")
+MAX_REQUEST = 30
+MAX_TIMEOUT_MS = 255  # Pole limitu w rekordzie ma jeden bajt
+
+STATUS_NAMES = ["ok", "CRC", "timeout", "obciete", "rozgloszenie", "bledne zapytanie"]
+
+
+def encode_request(tag, frame, timeout_ms=0):
+    """Rekord zapytania; frame to adres + PDU bez CRC."""
+    if not 2 <= len(frame) <= MAX_REQUEST:
+        raise ValueError("zapytanie musi miec 2..%d bajtow" % MAX_REQUEST)
+    if not 0 <= timeout_ms <= MAX_TIMEOUT_MS:
+        raise ValueError("limit musi miec 0..%d ms" % MAX_TIMEOUT_MS)
+    return bytes([REQUEST_SYNC, len(frame), tag & 0xFF, timeout_ms]) + bytes(frame)
+
+
+def parse_results(buffer):
+    """Zwraca (lista (znacznik, status, czas_us, bajty), nieprzetworzona reszta)."""
+    results = []
+    pos = 0
+    while pos + RESULT_HEADER.size <= len(buffer):
+        if buffer[pos] != RESULT_SYNC:
+            pos += 1
+            continue
+        _, length, tag, status, time_us = RESULT_HEADER.unpack_from(buffer, pos)
+        end = pos + RESULT_HEADER.size + length
+        if end > len(buffer):
+            break
+        results.append((tag, status, time_us, bytes(buffer[pos + RESULT_HEADER.size:end])))
+        pos = end
+    return results, buffer[pos:]
+
+
+def timeout_arg(text):
+    """Limit odpowiedzi w ms; bez cichego obciecia do bajtu."""
+    value = int(text, 0)
+    if not 0 <= value <= MAX_TIMEOUT_MS:
+        raise argparse.ArgumentTypeError("limit 0..%d ms (0 - 100 ms)" % MAX_TIMEOUT_MS)
+    return value
+
+
+def read_request(spec):
+    """'adres:rejestr:ilosc[:funkcja]' -> ramka odczytu 0x03/0x04."""
+    parts = [int(p, 0) for p in spec.split(":")]
+    if len(parts) < 3:
+        raise argparse.ArgumentTypeError("oczekiwano adres:rejestr:ilosc[:funkcja]")
+    address, register, count = parts[:3]
+    function = parts[3] if len(parts) > 3 else 3
+    return struct.pack(">BBHH", address, function, register, count)
+
+
+class Gateway:
+    def __init__(self, port, bus_baud=0):
+        import serial  # pyserial, potrzebny tylko przy pracy z urzadzeniem
+        self.link = serial.Serial(port, 115200, timeout=0.1)
+        self.pending = b""
+        command = "gw %d\n" % bus_baud if bus_baud else "gw\n"
+        self.link.reset_input_buffer()
+        self.link.write(command.encode("ascii"))
+        # Ostatni wiersz tekstu przed rekordami binarnymi
+        deadline = time.time() + 2.0
+        while time.time() < deadline:
+            line = self.link.readline()
+            if line.startswith(b"Bramka RS485"):
+                return
+        raise RuntimeError("bramka nie odpowiada (czy urzadzenie jest w trybie IDLE?)")
+
+    def transact(self, frames, window=16, timeout_ms=0):
+        """Wykonuje zapytania po kolei; zwraca wyniki w kolejnosci zapytan."""
+        results = []
+        sent = 0
+        last_data = time.time()
+        while len(results) < len(frames):
+            while sent < len(frames) and sent - len(results) < window:
+                self.link.write(encode_request(sent, frames[sent], timeout_ms))
+                sent += 1
+            data = self.link.read(max(1, self.link.in_waiting))
+            if data:
+                last_data = time.time()
+            elif time.time() - last_data > 2.0:
+                print("Brak wynikow od bramki - przerwano", file=sys.stderr)
+                break
+            batch, self.pending = parse_results(self.pending + data)
+            results.extend(batch)
+        return results
+
+    def close(self):
+        self.link.write(bytes([REQUEST_SYNC, 0]))
+        time.sleep(0.3)
+        summary = self.link.read(self.link.in_waiting)
+        self.link.close()
+        return summary.decode("ascii", "replace")
+
+
+def percentile(values, percent):
+    if not values:
+        return 0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, len(ordered) * percent // 100)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="port USB bramki, np. /dev/ttyACM0")
+    parser.add_argument("--bus-baud", type=int, default=0, help="predkosc RS485 (domyslnie biezaca)")
+    parser.add_argument("--read", action="append", type=read_request, required=True,
+                        help="odczyt adres:rejestr:ilosc[:funkcja], mozna powtarzac")
+    parser.add_argument("--count", type=int, default=100, help="liczba transakcji")
+    parser.add_argument("--window", type=int, default=16, help="zapytania wyslane z wyprzedzeniem")
+    parser.add_argument("--timeout-ms", type=timeout_arg, default=0,
+                        help="limit odpowiedzi 0..%d ms (0 - 100 ms)" % MAX_TIMEOUT_MS)
+    parser.add_argument("--show", action="store_true", help="wypisz kazda odpowiedz")
+    args = parser.parse_args()
+
+    frames = [args.read[i % len(args.read)] for i in range(args.count)]
+    gateway = Gateway(args.port, args.bus_baud)
+    start = time.time()
+    results = gateway.transact(frames, args.window, args.timeout_ms)
+    elapsed = time.time() - start
+    summary = gateway.close()
+
+    statuses = [0] * len(STATUS_NAMES)
+    times = []
+    for index, (tag, status, time_us, data) in enumerate(results):
+        if tag != index & 0xFF:
+            print("Znacznik %d zamiast %d" % (tag, index & 0xFF), file=sys.stderr)
+        if status < len(statuses):
+            statuses[status] += 1
+        if status == 0:
+            times.append(time_us)
+        if args.show:
+            name = STATUS_NAMES[status] if status < len(STATUS_NAMES) else str(status)
+            print("%5d %-8s %6d us  %s" % (index, name, time_us, data.hex(" ")))
+
+    print("Transakcje: %d w %.2f s (%.0f/s)" % (len(results), elapsed,
+                                               len(results) / elapsed if elapsed else 0))
+    print("Statusy: " + ", ".join("%s %d" % (n, c) for n, c in zip(STATUS_NAMES, statuses) if c))
+    if times:
+        print("Czas reakcji slave'a p50/p99/max: %d/%d/%d us" %
+              (percentile(times, 50), percentile(times, 99), max(times)))
+    sys.stdout.write(summary)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Odtwarza wszystkie zapisy *.trace z tego katalogu przez ModbusAnalyzer
+# (program native, tryb replay) i porównuje podsumowania ze wzorcami *.golden.
+#
+#   pio run -e native && tools/replay/check.sh
+#   tools/replay/check.sh sciezka/do/program
+#   UPDATE=1 tools/replay/check.sh      - nowe wzorce po zamierzonej zmianie
+#
+# Nowy zapis z symulacji: program sniff -t 10 ... -R tools/replay/nazwa.trace,
+# z urządzenia: tools/capture2trace.py (strumień "bin" lub log z karty SD).
+dir=$(dirname "$0")
+program=${1:-.pio/build/native/program}
+mode=-g
+[ -n "$UPDATE" ] && mode=-G
+
+failed=0
+for trace in "$dir"/*.trace; do
+    "$program" replay -i "$trace" $mode "${trace%.trace}.golden" || failed=1
+done
+exit $failed
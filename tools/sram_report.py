@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Raport zajetosci SRAM firmware: rozmiar kazdego obiektu w .data/.bss.
+
+Uzycie:
+    python3 tools/sram_report.py .pio/build/leonardo/firmware.elf
+    python3 tools/sram_report.py --nm avr-nm firmware.elf
+
+W env:leonardo skrypt jest podpiety jako extra_scripts i drukuje raport
+po kazdej kompilacji. Tablice w PROGMEM (np. CRC) leza we flash i nie sa
+liczone. Zapas = SRAM - statyczne dane; z niego korzysta stos.
+"""
+import argparse
+import collections
+import subprocess
+import sys
+
+SRAM_BYTES = 2560           # ATmega32U4
+STACK_RESERVE = 512         # Minimalny zapas na stos (SRAM_STACK_RESERVE w Config.h)
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "--size-sort", "-S", "-C", elf],
+                         check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        _, size, kind, name = parts
+        # b/B = .bss, d/D = .data; pozostale sa we flash
+        if kind.lower() not in ("b", "d"):
+            continue
+        symbols.append((name, int(size, 16)))
+    return symbols
+
+
+def component(name):
+    """Grupowanie: skladowe statyczne klasy pod nazwa klasy, reszta osobno."""
+    if "::" in name:
+        return name.split("::")[0]
+    return name
+
+
+def report(symbols, out):
+    groups = collections.Counter()
+    for name, size in symbols:
+        groups[component(name)] += size
+    total = sum(groups.values())
+
+    out.write("SRAM (statycznie): %d / %d B\n" % (total, SRAM_BYTES))
+    for name, size in groups.most_common():
+        out.write("  %6d  %s\n" % (size, name))
+    free = SRAM_BYTES - total
+    out.write("Zapas na stos: %d B\n" % free)
+    if free < STACK_RESERVE:
+        out.write("UWAGA: zapas ponizej %d B\n" % STACK_RESERVE)
+    return free >= STACK_RESERVE
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="avr-nm")
+    args = parser.parse_args()
+    ok = report(read_symbols(args.nm, args.elf), sys.stdout)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
+else:
+    # Wywolanie jako extra_scripts z PlatformIO (SCons); avr-nm jest w PATH toolchaina
+    Import("env")  # noqa: F821
+
+    def _after_build(source, target, env):
+        # Brak zapasu na stos przerywa build, jak static_assert w main.cpp
+        if not report(read_symbols("avr-nm", str(target[0])), sys.stdout):
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _after_build)  # noqa: F821